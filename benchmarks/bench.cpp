@@ -0,0 +1,45 @@
+/**
+ * @file bench.cpp
+ *
+ * This file implements the helpers declared in bench.hpp. The global
+ * operator new and delete are replaced to count heap allocations.
+ */
+
+#include "bench.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> allocation_count(0);
+
+void *operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+
+namespace bench {
+size_t allocations() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+void report_header() {
+    std::printf("%-44s %12s %12s\n", "benchmark", "ns/op", "allocs/op");
+}
+
+void report(const std::string &name, const Result &result) {
+    std::printf("%-44s %12.1f %12.2f\n", name.c_str(), result.ns_per_op,
+                result.allocs_per_op);
+}
+
+} // namespace bench
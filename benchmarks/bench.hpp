@@ -0,0 +1,65 @@
+/**
+ * @file bench.hpp
+ *
+ * This file contains helpers shared by the benchmarks for timing a piece of
+ * code and counting the heap allocations it makes.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace bench {
+/**
+ * The result of a benchmark run
+ */
+struct Result {
+    double ns_per_op;     ///< Average wall time of one operation
+    double allocs_per_op; ///< Average number of heap allocations per operation
+};
+
+/**
+ * Get the number of times operator new has been called by this process
+ */
+size_t allocations();
+
+/**
+ * Run a function repeatedly and measure its average cost. The function is run
+ * a few times before measuring to warm up caches and reused buffers.
+ *
+ * @param iterations The number of times to run the function
+ * @param fn The function to run
+ */
+template <typename F>
+Result run(const size_t iterations, F fn) {
+    for (size_t i = 0; i < iterations / 100 + 1; i++)
+        fn();
+
+    const size_t allocs_before = allocations();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+        fn();
+    const auto end = std::chrono::steady_clock::now();
+    const size_t allocs = allocations() - allocs_before;
+
+    Result result;
+    result.ns_per_op =
+        std::chrono::duration<double, std::nano>(end - start).count() /
+        iterations;
+    result.allocs_per_op = static_cast<double>(allocs) / iterations;
+    return result;
+}
+
+/**
+ * Print a benchmark result as a table row
+ */
+void report(const std::string &name, const Result &result);
+
+/**
+ * Print the header of the table printed by report
+ */
+void report_header();
+
+} // namespace bench
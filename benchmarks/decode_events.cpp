@@ -0,0 +1,139 @@
+/**
+ * @file decode_events.cpp
+ *
+ * Compare the per-event cost of decoding each event type with jsoncpp and
+ * with the streaming decoder, and of reading a single field with an event
+ * view.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "bench.hpp"
+#include "dwmipcpp/decoder.hpp"
+#include "dwmipcpp/event_view.hpp"
+
+static const size_t ITERATIONS = 200000;
+
+struct Sample {
+    const char *name;
+    std::string payload;
+};
+
+static const Sample samples[] = {
+    {"tag_change_event",
+     "{\"tag_change_event\":{\"monitor_number\":0,\"old_state\":{"
+     "\"selected\":1,\"occupied\":11,\"urgent\":0},\"new_state\":{"
+     "\"selected\":2,\"occupied\":11,\"urgent\":0}}}"},
+    {"client_focus_change_event",
+     "{\"client_focus_change_event\":{\"monitor_number\":0,\"old_win_id\":"
+     "31457283,\"new_win_id\":29360131}}"},
+    {"layout_change_event",
+     "{\"layout_change_event\":{\"monitor_number\":0,\"old_symbol\":\"[]=\","
+     "\"old_address\":94229782593760,\"new_symbol\":\"[M]\","
+     "\"new_address\":94229782593784}}"},
+    {"monitor_focus_change_event",
+     "{\"monitor_focus_change_event\":{\"old_monitor_number\":0,"
+     "\"new_monitor_number\":1}}"},
+    {"focused_title_change_event",
+     "{\"focused_title_change_event\":{\"monitor_number\":0,"
+     "\"client_window_id\":31457283,\"old_name\":\"user@host: "
+     "~/src/dwmipcpp/build\",\"new_name\":\"vim src/connection.cpp "
+     "\\u2014 \\\"dwmipcpp\\\"\"}}"},
+    {"focused_state_change_event",
+     "{\"focused_state_change_event\":{\"monitor_number\":0,"
+     "\"client_window_id\":31457283,\"old_state\":{\"old_state\":false,"
+     "\"is_fixed\":false,\"is_floating\":false,\"is_fullscreen\":false,"
+     "\"is_urgent\":false,\"never_focus\":false},\"new_state\":{"
+     "\"old_state\":false,\"is_fixed\":false,\"is_floating\":true,"
+     "\"is_fullscreen\":false,\"is_urgent\":false,\"never_focus\":false}}}"},
+};
+
+/**
+ * Make sure both decoders agree on the fields that are easy to compare
+ */
+static void check_equivalent(const dwmipc::EventMessage &a,
+                             const dwmipc::EventMessage &b) {
+    bool same = a.type == b.type;
+    if (same && a.type == dwmipc::Event::FOCUSED_TITLE_CHANGE)
+        same = a.focused_title_change.new_name ==
+                   b.focused_title_change.new_name &&
+               a.focused_title_change.client_window_id ==
+                   b.focused_title_change.client_window_id;
+    else if (same && a.type == dwmipc::Event::LAYOUT_CHANGE)
+        same = a.layout_change.new_symbol == b.layout_change.new_symbol &&
+               a.layout_change.new_address == b.layout_change.new_address;
+
+    if (!same) {
+        std::cerr << "Decoders disagree" << std::endl;
+        std::exit(1);
+    }
+}
+
+int main() {
+    bench::report_header();
+
+    for (const Sample &sample : samples) {
+        const char *payload = sample.payload.c_str();
+        // Payload size in the header includes the null terminator
+        const uint32_t size = sample.payload.size() + 1;
+
+        dwmipc::EventMessage json_msg;
+        dwmipc::EventMessage stream_msg;
+
+        const bench::Result json = bench::run(ITERATIONS, [&]() {
+            Json::Value root;
+            dwmipc::pre_parse_reply(root, payload, size);
+            dwmipc::parse_event(root, json_msg);
+        });
+
+        const bench::Result stream = bench::run(ITERATIONS, [&]() {
+            if (!dwmipc::decode_event(payload, size, stream_msg))
+                std::exit(1);
+        });
+
+        check_equivalent(json_msg, stream_msg);
+
+        bench::report(std::string(sample.name) + " (jsoncpp)", json);
+        bench::report(std::string(sample.name) + " (streaming)", stream);
+    }
+
+    // Views only exist for the events carrying strings
+    dwmipc::FocusedTitleChangeView title_view;
+    dwmipc::LayoutChangeView layout_view;
+    for (const Sample &sample : samples) {
+        const char *payload = sample.payload.c_str();
+        const uint32_t size = sample.payload.size() + 1;
+        dwmipc::Event ev;
+        const char *body;
+
+        if (!dwmipc::locate_event(payload, size, ev, body))
+            std::exit(1);
+
+        dwmipc::EventView *view;
+        if (ev == dwmipc::Event::FOCUSED_TITLE_CHANGE)
+            view = &title_view;
+        else if (ev == dwmipc::Event::LAYOUT_CHANGE)
+            view = &layout_view;
+        else
+            continue;
+
+        size_t total = 0;
+        const bench::Result result = bench::run(ITERATIONS, [&]() {
+            if (!dwmipc::locate_event(payload, size, ev, body))
+                std::exit(1);
+            view->reset(ev, body, payload + size);
+            // Read the field a status bar would typically use
+            if (ev == dwmipc::Event::FOCUSED_TITLE_CHANGE)
+                total += title_view.new_name().size;
+            else
+                total += layout_view.new_symbol().size;
+        });
+
+        if (total == 0)
+            std::exit(1);
+
+        bench::report(std::string(sample.name) + " (view, one field)", result);
+    }
+}
@@ -0,0 +1,137 @@
+/**
+ * @file decode_replies.cpp
+ *
+ * Compare the cost of decoding GET_MONITORS and GET_DWM_CLIENT replies with
+ * jsoncpp and with the schema specific streaming decoders.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "bench.hpp"
+#include "dwmipcpp/decoder.hpp"
+
+static const size_t ITERATIONS = 20000;
+static const unsigned int NUM_MONITORS = 3;
+static const unsigned int CLIENTS_PER_MONITOR = 50;
+
+/**
+ * Build a GET_MONITORS reply similar to the one sent by DWM
+ */
+static std::string make_monitors_payload() {
+    std::ostringstream out;
+
+    out << "[";
+    for (unsigned int m = 0; m < NUM_MONITORS; m++) {
+        if (m > 0)
+            out << ",";
+        out << "{\"master_factor\":0.55,\"num_master\":1,\"num\":" << m
+            << ",\"is_selected\":" << (m == 0 ? "true" : "false")
+            << ",\"monitor_geometry\":{\"x\":" << m * 1920
+            << ",\"y\":0,\"width\":1920,\"height\":1080},"
+            << "\"window_geometry\":{\"x\":" << m * 1920
+            << ",\"y\":22,\"width\":1920,\"height\":1058},"
+            << "\"tagset\":{\"current\":1,\"old\":4},"
+            << "\"tag_state\":{\"selected\":1,\"occupied\":511,\"urgent\":0},"
+            << "\"clients\":{\"selected\":" << 41943041 + m * 1000
+            << ",\"stack\":[";
+        for (unsigned int c = 0; c < CLIENTS_PER_MONITOR; c++)
+            out << (c ? "," : "") << 41943041 + m * 1000 + c;
+        out << "],\"all\":[";
+        for (unsigned int c = 0; c < CLIENTS_PER_MONITOR; c++)
+            out << (c ? "," : "") << 41943041 + m * 1000 + c;
+        out << "]},\"layout\":{\"symbol\":{\"current\":\"[]=\",\"old\":"
+               "\"[M]\"},\"address\":{\"current\":94229782593760,\"old\":"
+               "94229782593784}},\"bar\":{\"y\":0,\"is_shown\":true,"
+               "\"is_top\":true,\"window_id\":"
+            << 8388614 + m << "}}";
+    }
+    out << "]";
+    return out.str();
+}
+
+static const std::string client_payload =
+    "{\"name\":\"vim src/connection.cpp\",\"tags\":1,\"window_id\":41943041,"
+    "\"monitor_number\":0,\"geometry\":{\"current\":{\"x\":0,\"y\":22,"
+    "\"width\":958,\"height\":1056},\"old\":{\"x\":0,\"y\":22,\"width\":1918,"
+    "\"height\":1056}},\"size_hints\":{\"base\":{\"width\":4,\"height\":4},"
+    "\"step\":{\"width\":9,\"height\":18},\"max\":{\"width\":0,\"height\":0},"
+    "\"min\":{\"width\":13,\"height\":22},\"aspect_ratio\":{\"min\":0.0,"
+    "\"max\":0.0}},\"border_width\":{\"current\":1,\"old\":0},\"states\":{"
+    "\"is_fixed\":false,\"is_floating\":false,\"is_urgent\":false,"
+    "\"never_focus\":false,\"old_state\":false,\"is_fullscreen\":false}}";
+
+int main() {
+    const std::string monitors_payload = make_monitors_payload();
+
+    bench::report_header();
+
+    {
+        const char *payload = monitors_payload.c_str();
+        // Payload size in the header includes the null terminator
+        const uint32_t size = monitors_payload.size() + 1;
+        std::vector<dwmipc::Monitor> json_monitors;
+        std::vector<dwmipc::Monitor> stream_monitors;
+
+        const bench::Result json = bench::run(ITERATIONS, [&]() {
+            Json::Value root;
+            dwmipc::pre_parse_reply(root, payload, size);
+            dwmipc::parse_monitors(root, json_monitors);
+        });
+
+        // A fresh vector each time, as returned by Connection::get_monitors
+        const bench::Result stream = bench::run(ITERATIONS, [&]() {
+            std::vector<dwmipc::Monitor> monitors;
+            if (!dwmipc::decode_monitors(payload, size, monitors))
+                std::exit(1);
+        });
+
+        // The same vector each time, as done when refreshing a snapshot
+        const bench::Result stream_reuse = bench::run(ITERATIONS, [&]() {
+            if (!dwmipc::decode_monitors(payload, size, stream_monitors))
+                std::exit(1);
+        });
+
+        if (json_monitors.size() != stream_monitors.size() ||
+            json_monitors[2].clients.all != stream_monitors[2].clients.all ||
+            json_monitors[1].master_factor !=
+                stream_monitors[1].master_factor) {
+            std::cerr << "Decoders disagree" << std::endl;
+            return 1;
+        }
+
+        bench::report("get_monitors (jsoncpp)", json);
+        bench::report("get_monitors (streaming)", stream);
+        bench::report("get_monitors (streaming, reused vector)", stream_reuse);
+    }
+
+    {
+        const char *payload = client_payload.c_str();
+        const uint32_t size = client_payload.size() + 1;
+        dwmipc::Client json_client;
+        dwmipc::Client stream_client;
+
+        const bench::Result json = bench::run(ITERATIONS, [&]() {
+            Json::Value root;
+            dwmipc::pre_parse_reply(root, payload, size);
+            dwmipc::parse_client(root, json_client);
+        });
+
+        const bench::Result stream = bench::run(ITERATIONS, [&]() {
+            if (!dwmipc::decode_client(payload, size, stream_client))
+                std::exit(1);
+        });
+
+        if (json_client.name != stream_client.name ||
+            json_client.size_hints.step.height !=
+                stream_client.size_hints.step.height) {
+            std::cerr << "Decoders disagree" << std::endl;
+            return 1;
+        }
+
+        bench::report("get_client (jsoncpp)", json);
+        bench::report("get_client (streaming)", stream);
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * @file dispatch_events.cpp
+ *
+ * Compare the cost of working out which event a message holds by probing the
+ * parsed message for each event name in turn, which is what parse_event used
+ * to do, and by looking up the message's first key.
+ */
+
+#include <cstdlib>
+#include <string>
+
+#include "bench.hpp"
+#include "dwmipcpp/decoder.hpp"
+
+static const size_t ITERATIONS = 1000000;
+
+/**
+ * The order in which the event names used to be probed
+ */
+static const dwmipc::Event probe_order[] = {
+    dwmipc::Event::TAG_CHANGE,           dwmipc::Event::LAYOUT_CHANGE,
+    dwmipc::Event::CLIENT_FOCUS_CHANGE,  dwmipc::Event::MONITOR_FOCUS_CHANGE,
+    dwmipc::Event::FOCUSED_TITLE_CHANGE, dwmipc::Event::FOCUSED_STATE_CHANGE,
+};
+
+/**
+ * Find the event by probing for every event name in turn
+ */
+static dwmipc::Event probe_chain(const Json::Value &root) {
+    for (const dwmipc::Event ev : probe_order)
+        if (root.get(dwmipc::event_map.at(ev), Json::nullValue) !=
+            Json::nullValue)
+            return ev;
+    std::exit(1);
+}
+
+/**
+ * Find the event from the first key of the parsed message
+ */
+static dwmipc::Event first_key(const Json::Value &root) {
+    const auto it = root.begin();
+    const char *end;
+    const char *name = it.memberName(&end);
+
+    dwmipc::Event ev;
+    if (!dwmipc::event_from_name(name, end - name, ev))
+        std::exit(1);
+    return ev;
+}
+
+int main() {
+    bench::report_header();
+
+    for (const dwmipc::Event ev : probe_order) {
+        const std::string &name = dwmipc::event_map.at(ev);
+        const std::string payload = "{\"" + name + "\":{}}";
+
+        Json::Value root;
+        dwmipc::pre_parse_reply(root, payload.c_str(), payload.size() + 1);
+
+        volatile dwmipc::Event found;
+        const bench::Result chain =
+            bench::run(ITERATIONS, [&]() { found = probe_chain(root); });
+        const bench::Result table =
+            bench::run(ITERATIONS, [&]() { found = first_key(root); });
+
+        if (found != ev)
+            return 1;
+
+        bench::report(name + " (probe chain)", chain);
+        bench::report(name + " (first key)", table);
+    }
+}
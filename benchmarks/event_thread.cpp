@@ -0,0 +1,133 @@
+/**
+ * @file event_thread.cpp
+ *
+ * Compare handling events inline in handle_events with receiving them on the
+ * background event thread. Events are written by the mock server over a real
+ * socket, each carrying the time it was sent, so the benchmark measures both
+ * throughput and the latency from write to handler. The "blocked ms" column
+ * is the time the server spent waiting for room in a full socket buffer, so it
+ * shows how far the client falls behind the events written to it.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "dwmipcpp/connection.hpp"
+#include "mock_server.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Get the current time in nanoseconds, used to timestamp events
+ */
+static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               Clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * Busy wait to simulate a handler doing work, such as redrawing a bar
+ */
+static void spin_us(const unsigned int us) {
+    const auto until = Clock::now() + std::chrono::microseconds(us);
+    while (Clock::now() < until) {
+    }
+}
+
+/**
+ * How events are sent and handled in one run
+ */
+struct Scenario {
+    const char *name;
+    size_t events;           ///< Number of events to send
+    unsigned int handler_us; ///< Work done by the handler per event
+    unsigned int period_us;  ///< Time between events, 0 to send a burst
+};
+
+struct Outcome {
+    double events_per_s;
+    double p50_us;
+    double p99_us;
+    double blocked_ms; ///< Time the server waited for a full socket buffer
+};
+
+static Outcome run(dwmipc::MockServer &server, const Scenario &scenario,
+                   const bool threaded) {
+    // Make sure the connection of the previous run is gone
+    server.wait_subscribers(dwmipc::Event::FOCUSED_TITLE_CHANGE, 0);
+
+    dwmipc::Connection conn(server.socket_path);
+    std::vector<double> latencies;
+    latencies.reserve(scenario.events);
+
+    conn.handlers.add<dwmipc::FocusedTitleChangeEvent>(
+        [&](const dwmipc::FocusedTitleChangeEvent &ev) {
+            const uint64_t sent = std::strtoull(ev.new_name.c_str(), nullptr,
+                                                10);
+            latencies.push_back((now_ns() - sent) / 1000.0);
+            spin_us(scenario.handler_us);
+        });
+    conn.subscribe(dwmipc::Event::FOCUSED_TITLE_CHANGE);
+    if (threaded)
+        conn.start_event_thread(4096);
+
+    dwmipc::MockEventOptions events;
+    events.generate = [](size_t) {
+        return "{\"focused_title_change_event\":{\"monitor_number\":0,"
+               "\"client_window_id\":4194307,\"old_name\":\"\","
+               "\"new_name\":\"" +
+               std::to_string(now_ns()) + "\"}}";
+    };
+    events.rate = scenario.period_us ? 1e6 / scenario.period_us : 0;
+    events.count = scenario.events;
+
+    const double blocked_before = server.get_stats().blocked_ms;
+    const auto start = Clock::now();
+    server.start_events(events);
+
+    while (latencies.size() < scenario.events) {
+        struct pollfd pfd = {conn.get_event_wait_fd(), POLLIN, 0};
+        poll(&pfd, 1, conn.has_pending_events() ? 0 : 1000);
+        conn.handle_events();
+    }
+    const auto end = Clock::now();
+    server.wait_events();
+
+    std::sort(latencies.begin(), latencies.end());
+    Outcome outcome;
+    outcome.events_per_s =
+        scenario.events / std::chrono::duration<double>(end - start).count();
+    outcome.p50_us = latencies[latencies.size() / 2];
+    outcome.p99_us = latencies[latencies.size() * 99 / 100];
+    outcome.blocked_ms = server.get_stats().blocked_ms - blocked_before;
+    return outcome;
+}
+
+int main() {
+    static const Scenario scenarios[] = {
+        {"burst, no handler work", 100000, 0, 0},
+        {"burst, 20us handler", 4000, 20, 0},
+        {"every 100us, 20us handler", 10000, 20, 100},
+    };
+
+    dwmipc::MockServer server("/tmp/dwmipcpp-bench-" +
+                              std::to_string(getpid()));
+
+    std::printf("%-28s %-8s %12s %10s %10s %12s\n", "scenario", "mode",
+                "events/s", "p50 us", "p99 us", "blocked ms");
+    for (const Scenario &scenario : scenarios) {
+        for (const bool threaded : {false, true}) {
+            const Outcome o = run(server, scenario, threaded);
+            std::printf("%-28s %-8s %12.0f %10.1f %10.1f %12.1f\n",
+                        scenario.name, threaded ? "thread" : "inline",
+                        o.events_per_s, o.p50_us, o.p99_us, o.blocked_ms);
+        }
+    }
+}
@@ -0,0 +1,157 @@
+/**
+ * @file replay_traffic.cpp
+ *
+ * Measure the cost of handling recorded traffic by replaying a traffic log
+ * through a Connection as fast as possible, with a few handler setups. Pass
+ * the path of a log recorded with a TrafficRecorder to replay real traffic.
+ * Without one, a synthetic log of bursts of typical events is generated.
+ */
+
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+#include "bench.hpp"
+#include "dwmipcpp/errors.hpp"
+#include "dwmipcpp/traffic_replayer.hpp"
+
+static const size_t ITERATIONS = 50;
+
+/**
+ * Events making up one synthetic burst, as DWM sends them when focus moves to
+ * a window on another tag
+ */
+static const std::string burst[] = {
+    "{\"tag_change_event\":{\"monitor_number\":0,\"old_state\":{"
+    "\"selected\":1,\"occupied\":11,\"urgent\":0},\"new_state\":{"
+    "\"selected\":2,\"occupied\":11,\"urgent\":0}}}",
+    "{\"client_focus_change_event\":{\"monitor_number\":0,\"old_win_id\":"
+    "31457283,\"new_win_id\":29360131}}",
+    "{\"focused_title_change_event\":{\"monitor_number\":0,"
+    "\"client_window_id\":29360131,\"old_name\":\"user@host: "
+    "~/src/dwmipcpp/build\",\"new_name\":\"vim src/connection.cpp "
+    "\\u2014 \\\"dwmipcpp\\\"\"}}",
+    "{\"focused_state_change_event\":{\"monitor_number\":0,"
+    "\"client_window_id\":29360131,\"old_state\":{\"old_state\":false,"
+    "\"is_fixed\":false,\"is_floating\":false,\"is_fullscreen\":false,"
+    "\"is_urgent\":false,\"never_focus\":false},\"new_state\":{"
+    "\"old_state\":false,\"is_fixed\":false,\"is_floating\":true,"
+    "\"is_fullscreen\":false,\"is_urgent\":false,\"never_focus\":false}}}",
+};
+
+/**
+ * Write a synthetic log of event bursts to a temporary file
+ *
+ * @return The path of the log
+ */
+static std::string write_synthetic_log() {
+    const std::string path =
+        "/tmp/dwmipcpp-bench-" + std::to_string(getpid()) + ".log";
+    dwmipc::TrafficRecorder recorder(path);
+    auto time = dwmipc::TrafficRecorder::Clock::now();
+
+    const std::string subscribed = "{\"result\":\"success\"}";
+    recorder.record(time, dwmipc::SocketRole::EVENT,
+                    dwmipc::Direction::RECEIVED,
+                    static_cast<uint8_t>(dwmipc::MessageType::SUBSCRIBE),
+                    subscribed.c_str(), subscribed.size() + 1);
+
+    for (int i = 0; i < 2000; i++) {
+        // Each burst is received in one read, a few milliseconds apart
+        time += std::chrono::milliseconds(5);
+        for (const std::string &payload : burst)
+            recorder.record(time, dwmipc::SocketRole::EVENT,
+                            dwmipc::Direction::RECEIVED,
+                            static_cast<uint8_t>(dwmipc::MessageType::EVENT),
+                            payload.c_str(), payload.size() + 1);
+    }
+    recorder.flush();
+    return path;
+}
+
+/**
+ * Replay the log repeatedly and report the cost per message
+ */
+template <typename Setup>
+static void run(const std::string &name,
+                const dwmipc::TrafficReplayer &replayer, Setup setup) {
+    dwmipc::Connection conn("", false);
+    setup(conn);
+
+    size_t messages = 0;
+    bench::Result result = bench::run(ITERATIONS, [&]() {
+        const dwmipc::ReplayStats stats = replayer.replay(
+            conn, dwmipc::TrafficReplayer::AS_FAST_AS_POSSIBLE);
+        messages = stats.events + stats.replies;
+    });
+
+    result.ns_per_op /= messages;
+    result.allocs_per_op /= messages;
+    bench::report(name, result);
+}
+
+int main(int argc, char *argv[]) {
+    std::string path;
+    if (argc > 1) {
+        path = argv[1];
+    } else {
+        path = write_synthetic_log();
+    }
+
+    try {
+        const dwmipc::TrafficReplayer replayer(path);
+        if (argc <= 1)
+            unlink(path.c_str());
+
+        std::printf("Replaying %zu messages from %s\n",
+                    replayer.get_records().size(), path.c_str());
+        bench::report_header();
+
+        volatile size_t seen = 0;
+
+        run("on_* handlers (streaming)", replayer,
+            [&](dwmipc::Connection &conn) {
+                conn.on_tag_change = [&](const dwmipc::TagChangeEvent &) {
+                    seen = seen + 1;
+                };
+                conn.on_focused_title_change =
+                    [&](const dwmipc::FocusedTitleChangeEvent &) {
+                        seen = seen + 1;
+                    };
+            });
+
+        run("on_* handlers (jsoncpp)", replayer,
+            [&](dwmipc::Connection &conn) {
+                conn.set_decoder(dwmipc::Decoder::JSONCPP);
+                conn.on_tag_change = [&](const dwmipc::TagChangeEvent &) {
+                    seen = seen + 1;
+                };
+                conn.on_focused_title_change =
+                    [&](const dwmipc::FocusedTitleChangeEvent &) {
+                        seen = seen + 1;
+                    };
+            });
+
+        run("title view handler", replayer, [&](dwmipc::Connection &conn) {
+            conn.handlers.add<dwmipc::FocusedTitleChangeView>(
+                [&](const dwmipc::FocusedTitleChangeView &view) {
+                    seen = seen + view.client_window_id();
+                });
+        });
+
+        run("titles coalesced per read", replayer,
+            [&](dwmipc::Connection &conn) {
+                dwmipc::CoalescePolicy policy;
+                policy.mode = dwmipc::CoalesceMode::LATEST;
+                conn.set_coalesce_policy(dwmipc::Event::FOCUSED_TITLE_CHANGE,
+                                         policy);
+                conn.on_focused_title_change =
+                    [&](const dwmipc::FocusedTitleChangeEvent &) {
+                        seen = seen + 1;
+                    };
+            });
+    } catch (const dwmipc::IPCError &err) {
+        std::fprintf(stderr, "%s\n", err.what());
+        return 1;
+    }
+}
@@ -0,0 +1,97 @@
+/**
+ * @file requests.cpp
+ *
+ * Measure the cost of requests made over a real socket to the mock server:
+ * blocking round trips, pipelined asynchronous requests, and requests made
+ * from several threads through a thread safe connection or a ConnectionPool.
+ */
+
+#include <cstdio>
+#include <future>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bench.hpp"
+#include "dwmipcpp/connection.hpp"
+#include "dwmipcpp/connection_pool.hpp"
+#include "dwmipcpp/errors.hpp"
+#include "mock_server.hpp"
+
+static const size_t ITERATIONS = 20000;
+static const size_t PIPELINE_DEPTH = 64;
+static const unsigned int THREADS = 4;
+
+/**
+ * Run a request from several threads at once and report the cost per request
+ */
+template <typename Request>
+static void run_threads(const std::string &name, Request request) {
+    bench::Result result = bench::run(1, [&]() {
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < THREADS; i++)
+            threads.emplace_back([&]() {
+                for (size_t j = 0; j < ITERATIONS / THREADS; j++)
+                    request();
+            });
+        for (auto &thread : threads)
+            thread.join();
+    });
+
+    result.ns_per_op /= ITERATIONS;
+    result.allocs_per_op /= ITERATIONS;
+    bench::report(name, result);
+}
+
+int main() {
+    try {
+        const dwmipc::MockServer server("/tmp/dwmipcpp-bench-" +
+                                        std::to_string(getpid()));
+        const dwmipc::Window win_id = server.get_model().clients[0].window_id;
+        bench::report_header();
+
+        {
+            dwmipc::Connection conn(server.socket_path);
+            bench::report("get_monitors", bench::run(ITERATIONS, [&]() {
+                              conn.get_monitors();
+                          }));
+            bench::report("get_client", bench::run(ITERATIONS, [&]() {
+                              conn.get_client(win_id);
+                          }));
+
+            bench::Result result =
+                bench::run(ITERATIONS / PIPELINE_DEPTH, [&]() {
+                    std::vector<std::future<std::shared_ptr<dwmipc::Client>>>
+                        replies;
+                    for (size_t i = 0; i < PIPELINE_DEPTH; i++)
+                        replies.push_back(conn.get_client_async(win_id));
+                    for (auto &reply : replies)
+                        reply.get();
+                });
+            result.ns_per_op /= PIPELINE_DEPTH;
+            result.allocs_per_op /= PIPELINE_DEPTH;
+            bench::report("get_client_async, pipelined", result);
+        }
+
+        {
+            dwmipc::Connection conn(server.socket_path);
+            conn.set_thread_safe(true);
+            run_threads("get_client, thread safe",
+                        [&]() { conn.get_client(win_id); });
+        }
+
+        {
+            dwmipc::ConnectionPoolOptions options;
+            options.max_connections = THREADS;
+            dwmipc::ConnectionPool pool(server.socket_path, options);
+            run_threads("get_client, pooled", [&]() {
+                dwmipc::ConnectionLease lease = pool.lease();
+                lease->get_client(win_id);
+            });
+        }
+    } catch (const dwmipc::IPCError &err) {
+        std::fprintf(stderr, "%s\n", err.what());
+        return 1;
+    }
+}
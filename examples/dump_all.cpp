@@ -114,17 +114,17 @@ void dump_client(const std::shared_ptr<dwmipc::Client> &c) {
 int main() {
     dwmipc::Connection connection("/tmp/dwm.sock");
 
-    auto monitors = connection.get_monitors();
+    // Fetch monitors, tags and layouts in a single round trip
+    auto state = connection.get_state();
+    auto monitors = state.monitors;
 
     for (auto m : *monitors)
         dump_monitor(std::make_shared<dwmipc::Monitor>(m));
 
-    auto tags = connection.get_tags();
-    for (auto t: *tags)
+    for (auto t: *state.tags)
         dump_tag(std::make_shared<dwmipc::Tag>(t));
 
-    auto layouts = connection.get_layouts();
-    for (auto l: *layouts)
+    for (auto l: *state.layouts)
         dump_layout(std::make_shared<dwmipc::Layout>(l));
 
     auto c = connection.get_client((*monitors)[0].clients.selected);
@@ -0,0 +1,52 @@
+/**
+ * @file record_traffic.cpp
+ *
+ * Record DWM's traffic for a while, for replaying with TrafficReplayer or the
+ * replay-traffic benchmark.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+#include "dwmipcpp/connection.hpp"
+#include "dwmipcpp/errors.hpp"
+#include "dwmipcpp/event_loop.hpp"
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <log file> [seconds]"
+                  << std::endl;
+        return 1;
+    }
+    const unsigned int seconds = argc > 2 ? std::atoi(argv[2]) : 60;
+
+    auto recorder = std::make_shared<dwmipc::TrafficRecorder>(argv[1]);
+
+    dwmipc::Connection con("/tmp/dwm.sock");
+    con.set_traffic_recorder(recorder);
+
+    // The events are recorded as they are received, so no handlers are
+    // needed
+    con.subscribe_many(
+        static_cast<uint8_t>(dwmipc::Event::LAYOUT_CHANGE) |
+        static_cast<uint8_t>(dwmipc::Event::CLIENT_FOCUS_CHANGE) |
+        static_cast<uint8_t>(dwmipc::Event::TAG_CHANGE) |
+        static_cast<uint8_t>(dwmipc::Event::MONITOR_FOCUS_CHANGE) |
+        static_cast<uint8_t>(dwmipc::Event::FOCUSED_TITLE_CHANGE) |
+        static_cast<uint8_t>(dwmipc::Event::FOCUSED_STATE_CHANGE));
+    con.get_state();
+
+    dwmipc::EventLoop loop(con);
+
+    loop.on_error = [](const dwmipc::IPCError &err) {
+        std::cerr << "Error handling event" << err.what() << std::endl;
+    };
+
+    loop.add_timer(seconds * 1000, [&]() { loop.stop(); }, false);
+    loop.run();
+
+    recorder->flush();
+    std::cout << "Recorded " << recorder->get_records() << " messages"
+              << std::endl;
+}
@@ -1,29 +1,8 @@
 #include <iostream>
-#include <unistd.h>
 
 #include "dwmipcpp/connection.hpp"
 #include "dwmipcpp/errors.hpp"
-
-bool msleep(const long milliseconds) {
-    struct timespec ts;
-    int res;
-
-    // Invalid argument
-    if (milliseconds < 0)
-        return false;
-
-    time_t sec = milliseconds / 1000;
-    long ns = (milliseconds % 1000) * 1000 * 1000;
-
-    ts.tv_sec = sec;
-    ts.tv_nsec = ns;
-
-    do {
-        res = nanosleep(&ts, &ts);
-    } while (res && errno == EINTR);
-
-    return true;
-}
+#include "dwmipcpp/event_loop.hpp"
 
 int main() {
     dwmipc::Connection con("/tmp/dwm.sock");
@@ -108,24 +87,19 @@ int main() {
                       << std::endl;
         };
 
-    con.subscribe(dwmipc::Event::LAYOUT_CHANGE);
-    con.subscribe(dwmipc::Event::CLIENT_FOCUS_CHANGE);
-    con.subscribe(dwmipc::Event::TAG_CHANGE);
-    con.subscribe(dwmipc::Event::MONITOR_FOCUS_CHANGE);
-    con.subscribe(dwmipc::Event::FOCUSED_TITLE_CHANGE);
-    con.subscribe(dwmipc::Event::FOCUSED_STATE_CHANGE);
+    con.subscribe_many(
+        static_cast<uint8_t>(dwmipc::Event::LAYOUT_CHANGE) |
+        static_cast<uint8_t>(dwmipc::Event::CLIENT_FOCUS_CHANGE) |
+        static_cast<uint8_t>(dwmipc::Event::TAG_CHANGE) |
+        static_cast<uint8_t>(dwmipc::Event::MONITOR_FOCUS_CHANGE) |
+        static_cast<uint8_t>(dwmipc::Event::FOCUSED_TITLE_CHANGE) |
+        static_cast<uint8_t>(dwmipc::Event::FOCUSED_STATE_CHANGE));
+
+    dwmipc::EventLoop loop(con);
+
+    loop.on_error = [](const dwmipc::IPCError &err) {
+        std::cerr << "Error handling event" << err.what() << std::endl;
+    };
 
-    while (true) {
-        try {
-            con.handle_event();
-        } catch (const dwmipc::SocketClosedError &err) {
-            std::cerr << err.what() << std::endl;
-            std::cout << "Attempting to reconnect" << std::endl;
-            msleep(500);
-            con.connect_event_socket();
-        } catch (const dwmipc::IPCError &err) {
-            std::cerr << "Error handling event" << err.what() << std::endl;
-        }
-        msleep(100);
-    }
+    loop.run();
 }
@@ -0,0 +1,125 @@
+/**
+ * @file command_writer.hpp
+ *
+ * This file contains the declarations for the CommandWriter class which
+ * serializes a RUN_COMMAND message directly into a packet. This file is used
+ * internally by dwmipcpp.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <json/json.h>
+#include <string>
+#include <type_traits>
+
+#include "packet.hpp"
+
+namespace dwmipc {
+/**
+ * This class writes the payload {"command":<name>,"args":[...]} straight into
+ * a packet's buffer, one argument at a time. No JSON document or intermediate
+ * string is built. The packet's buffer grows as needed, so a pooled packet
+ * normally needs no allocation at all.
+ */
+class CommandWriter {
+  public:
+    /**
+     * Start a RUN_COMMAND message in the specified packet. The previous
+     * contents of the packet are discarded.
+     *
+     * @param packet The packet to write into
+     * @param name Name of the command
+     */
+    CommandWriter(Packet &packet, const std::string &name);
+
+    /**
+     * Append a string argument
+     */
+    void value(const std::string &arg);
+
+    /**
+     * Append a string argument
+     */
+    void value(const char *arg);
+
+    /**
+     * Append a boolean argument
+     */
+    void value(bool arg);
+
+    /**
+     * Append a signed integer argument
+     */
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value &&
+                            std::is_signed<T>::value>::type
+    value(const T arg) {
+        separate();
+        int_value(static_cast<int64_t>(arg));
+    }
+
+    /**
+     * Append an unsigned integer argument
+     */
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value &&
+                            !std::is_signed<T>::value>::type
+    value(const T arg) {
+        separate();
+        uint_value(static_cast<uint64_t>(arg));
+    }
+
+    /**
+     * Append a floating point argument
+     */
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value>::type
+    value(const T arg) {
+        separate();
+        double_value(static_cast<double>(arg));
+    }
+
+    /**
+     * Append every element of a JSON array as an argument
+     */
+    void values(const Json::Value &arr);
+
+    /**
+     * Terminate the message and fill in the packet header. The packet is
+     * ready to be sent after this call.
+     */
+    void finish();
+
+  private:
+    Packet &packet;
+    uint32_t pos = 0;  ///< Number of payload bytes written so far
+    bool first = true; ///< No argument has been written yet
+
+    /**
+     * Make room for at least n more payload bytes and get a pointer to them
+     */
+    char *grow(size_t n);
+
+    void put(char c);
+    void put(const char *str, size_t len);
+
+    /**
+     * Write the comma separating an argument from the previous one
+     */
+    void separate();
+
+    /**
+     * Write a quoted and escaped JSON string
+     */
+    void string(const char *str, size_t len);
+
+    void bool_value(bool arg);
+    void int_value(int64_t arg);
+    void uint_value(uint64_t arg);
+    void double_value(double arg);
+    void json_value(const Json::Value &arg);
+};
+
+} // namespace dwmipc
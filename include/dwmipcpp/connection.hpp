@@ -6,17 +6,58 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <future>
 #include <json/json.h>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "command_writer.hpp"
+#include "decoder.hpp"
+#include "event_coalescer.hpp"
+#include "event_filter.hpp"
+#include "event_reader_thread.hpp"
+#include "frame_reader.hpp"
+#include "handler_registry.hpp"
 #include "packet.hpp"
+#include "packet_pool.hpp"
+#include "traffic_log.hpp"
 #include "types.hpp"
 
 namespace dwmipc {
+/**
+ * Controls how a Connection re-establishes a socket that was closed, for
+ * example because DWM was restarted
+ */
+struct ReconnectPolicy {
+    /**
+     * Reconnect automatically when a socket is lost. If this is false, a lost
+     * socket is reported by throwing SocketClosedError.
+     */
+    bool enabled = true;
+
+    /**
+     * Milliseconds to wait before each successive connection attempt. The
+     * last delay is repeated for any further attempts. The first attempt is
+     * made immediately so that a socket that is already back is reconnected
+     * without delay.
+     */
+    std::vector<unsigned int> backoff_ms = {0, 10, 25, 50, 100, 250, 500};
+
+    /**
+     * Stop trying and throw SocketClosedError once this many milliseconds
+     * have passed. 0 means keep trying forever.
+     */
+    unsigned int timeout_ms = 30000;
+};
+
 /**
  * The DWM IPC connection class used to initiate a connection with DWM's IPC
  * socket and send/receive messages.
@@ -79,6 +120,35 @@ class Connection {
      */
     std::shared_ptr<Client> get_client(Window win_id);
 
+    /**
+     * Get the properties of several DWM clients. All of the requests are
+     * pipelined over the main socket instead of making a round trip per
+     * window. A window that DWM cannot find, for example because it was closed
+     * while the batch was in flight, is reported in ClientList::failures and
+     * does not affect the rest of the batch.
+     *
+     * @param win_ids XIDs of the client windows
+     *
+     * @return The clients that were found and the windows that were not
+     *
+     * @throw ReplyError if a reply does not match its request
+     * @throw SocketClosedError if the socket is disconnected
+     */
+    std::shared_ptr<ClientList> get_clients(const std::vector<Window> &win_ids);
+
+    /**
+     * Get the monitors, tags and layouts in a single round trip. The three
+     * requests are written back to back and their replies are collected in
+     * order.
+     *
+     * @return The monitors, tags and layouts as defined by DWM
+     *
+     * @throw ResultFailureError if DWM sends an error reply.
+     * @throw ReplyError if a reply does not match its request
+     * @throw SocketClosedError if the socket is disconnected
+     */
+    StateSnapshot get_state();
+
     /**
      * Subscribe to the specified DWM event. After subscribing to an event, DWM
      * will send dwmipc::MessageType::EVENT messages when the specified
@@ -92,6 +162,20 @@ class Connection {
      */
     void subscribe(const Event ev);
 
+    /**
+     * Subscribe to several DWM events at once. All of the subscribe requests
+     * are written together and their replies are collected afterwards, so
+     * this takes about one round trip regardless of how many events are
+     * specified.
+     *
+     * @param mask Bitwise OR of the dwmipc::Event values to subscribe to
+     *
+     * @throw std::invalid_argument if mask has bits that are not events
+     * @throw ResultFailureError if DWM sends an error reply.
+     * @throw SocketClosedError if the socket is disconnected
+     */
+    void subscribe_many(uint8_t mask);
+
     /**
      * Unsubscribe to the specified DWM event. After unsubscribing to an event,
      * DWM will no longer send dwmipc::MessageType::EVENT messages for
@@ -115,6 +199,67 @@ class Connection {
      */
     bool handle_event();
 
+    /**
+     * Read all event messages currently queued on the event socket and call
+     * their event handlers. The socket is read with as few syscalls as
+     * possible, usually one per burst of events. Any trailing partial message
+     * is kept and completed by a later call. Coalesced events that are due are
+     * dispatched at the end of the call (see set_coalesce_policy).
+     *
+     * @param max The maximum number of events to handle. Events beyond this
+     *   are kept buffered and handled by the next call.
+     *
+     * @return The number of events handled
+     *
+     * @throw SocketClosedError if the socket is disconnected
+     * @throw IPCError if invalid message type received
+     */
+    size_t handle_events(const size_t max = SIZE_MAX);
+
+    /**
+     * Select the implementation used to decode event messages and replies to
+     * get_monitors and get_client. The streaming decoder is used by default
+     * and falls back to jsoncpp for any payload it does not understand.
+     *
+     * @param decoder The decoder to use for subsequent messages
+     */
+    void set_decoder(const Decoder decoder);
+
+    /**
+     * Get the implementation used to decode messages from DWM
+     */
+    Decoder get_decoder() const;
+
+    /**
+     * Enable or disable thread-safe mode. By default, a Connection must only
+     * be used by one thread at a time. In thread-safe mode, requests on the
+     * main socket (get_*, run_command and their _async variants) may be made
+     * from any number of threads at once. Every request is queued for the
+     * internal I/O thread, which pipelines everything queued so far and hands
+     * each reply back to the thread waiting for it, in the order the requests
+     * were sent. Replies are decoded on the calling threads, so concurrent
+     * callers share round trips instead of waiting for each other.
+     *
+     * Events are still received on the event socket, so subscribing and
+     * handling events must stay on a single thread. The mode should be set
+     * before the Connection is shared between threads.
+     *
+     * @param enabled true to route requests through the I/O thread
+     */
+    void set_thread_safe(bool enabled);
+
+    /**
+     * Check if the Connection is in thread-safe mode
+     */
+    bool is_thread_safe() const;
+
+    /**
+     * Get the counters of the pool that packets sent and received on the
+     * main socket are taken from. A hit rate close to 1 means messages are
+     * being sent and received without allocating packets.
+     */
+    PacketPoolStats get_packet_pool_stats() const;
+
     /**
      * Run a DWM command
      *
@@ -134,9 +279,11 @@ class Connection {
      */
     template <typename... Types>
     void run_command(const std::string name, Types... args) {
-        Json::Value arr = Json::Value(Json::arrayValue);
-        run_command_build(arr, args...);
-        run_command(name, arr);
+        auto packet = packet_pool.acquire();
+        CommandWriter writer(*packet, name);
+        run_command_write(writer, args...);
+        writer.finish();
+        send_command(packet);
     }
 
     /**
@@ -151,6 +298,79 @@ class Connection {
     void run_command(const std::string name,
                      const Json::Value &arr = Json::Value(Json::arrayValue));
 
+    /**
+     * Asynchronously get a list of monitors and their properties as defined by
+     * DWM. The request is sent by an internal I/O thread, so this never blocks
+     * on the socket. Requests made before earlier ones are answered are
+     * pipelined together.
+     *
+     * @return A future for the list of Monitor objects. The future holds a
+     *   ResultFailureError if DWM sends an error reply or a SocketClosedError
+     *   if the socket is disconnected.
+     */
+    std::future<std::shared_ptr<std::vector<Monitor>>> get_monitors_async();
+
+    /**
+     * Asynchronously get the list of tags defined by DWM. See
+     * get_monitors_async.
+     *
+     * @return A future for the list of Tag objects
+     */
+    std::future<std::shared_ptr<std::vector<Tag>>> get_tags_async();
+
+    /**
+     * Asynchronously get the list of available layouts as defined by DWM. See
+     * get_monitors_async.
+     *
+     * @return A future for the list of Layout objects
+     */
+    std::future<std::shared_ptr<std::vector<Layout>>> get_layouts_async();
+
+    /**
+     * Asynchronously get the properties of a DWM client. See
+     * get_monitors_async.
+     *
+     * @param win_id XID of the client window
+     *
+     * @return A future for the Client object
+     */
+    std::future<std::shared_ptr<Client>> get_client_async(Window win_id);
+
+    /**
+     * Asynchronously run a DWM command. See run_command and
+     * get_monitors_async.
+     *
+     * @param name Name of the command
+     * @param args Arguments for the command. The arguments must be either a
+     *   string, bool, or number.
+     *
+     * @return A future that becomes ready when DWM has run the command. It
+     *   holds a ResultFailureError if the command failed.
+     */
+    template <typename... Types>
+    std::future<void> run_command_async(const std::string name,
+                                        Types... args) {
+        auto packet = packet_pool.acquire();
+        CommandWriter writer(*packet, name);
+        run_command_write(writer, args...);
+        writer.finish();
+        return send_command_async(packet);
+    }
+
+    /**
+     * Asynchronously run a DWM command. Use this overload without specifying
+     * any arguments, if this command takes no arguments.
+     *
+     * @param name Name of the command
+     * @param arr JSON array of arguments for the command. If this parameter is
+     *   not specified, the arguments default to an empty array.
+     *
+     * @return A future that becomes ready when DWM has run the command
+     */
+    std::future<void>
+    run_command_async(const std::string name,
+                      const Json::Value &arr = Json::Value(Json::arrayValue));
+
     /**
      * Check if main socket is connected. If the connection is found to be
      * broken, the main file descriptor will be closed and the file descriptor
@@ -217,11 +437,199 @@ class Connection {
      */
     int get_event_socket_fd() const;
 
+    /**
+     * Get a number that is incremented every time the event socket is
+     * connected. This can be used to notice that the event socket was
+     * replaced, even if the new socket has the same file descriptor.
+     */
+    unsigned int get_event_socket_generation() const;
+
+    /**
+     * Check if events have already been received that handle_events would
+     * dispatch without reading the socket. This happens when events arrive
+     * while waiting for the reply to a subscribe request. An event loop
+     * should call handle_events when this is true, since the socket will not
+     * become readable for them.
+     */
+    bool has_pending_events() const;
+
+    /**
+     * Receive and decode events on a background thread, so that slow handlers
+     * do not keep the event socket from being read. The thread queues decoded
+     * events in a bounded lock-free ring, and handle_events dispatches them
+     * on the calling thread as before. If the ring is full, the thread stops
+     * reading until handle_events makes room.
+     *
+     * While the thread is enabled, get_event_wait_fd should be waited on
+     * instead of the event socket. The thread is paused while subscribing,
+     * and a lost event socket is reconnected by handle_events as usual. The
+     * decoder is read when the thread starts, so set_decoder takes effect the
+     * next time it is started.
+     *
+     * @param capacity The number of events that can be queued. It is rounded
+     *   up to a power of two, and only used if no events are still queued from
+     *   an earlier run of the thread.
+     *
+     * @throw InvalidOperationError if the thread is already enabled
+     * @throw ErrnoError if the thread's file descriptors could not be created
+     */
+    void start_event_thread(size_t capacity = 1024);
+
+    /**
+     * Stop the background event thread and go back to reading the event
+     * socket in handle_events. Events already queued are still dispatched by
+     * handle_events.
+     */
+    void stop_event_thread();
+
+    /**
+     * Check if events are received on a background thread
+     */
+    bool is_event_thread_enabled() const;
+
+    /**
+     * Get the counters of the background event thread
+     */
+    EventThreadStats get_event_thread_stats() const;
+
+    /**
+     * Get the file descriptor that becomes readable when handle_events has
+     * events to handle. This is the event socket, or a file descriptor
+     * signalled by the background event thread while it is enabled.
+     *
+     * @return The file descriptor, -1 if the event socket is disconnected
+     */
+    int get_event_wait_fd() const;
+
+    /**
+     * Set which received events are dispatched. Events rejected by the filter
+     * are dropped straight from the receive buffer, before they are parsed.
+     * They still count as handled for handle_events, except on the event
+     * thread, which drops them before they are queued.
+     *
+     * @param filter The filter to apply to subsequently handled events
+     */
+    void set_event_filter(const EventFilter &filter);
+
+    /**
+     * Get the filter applied to received events
+     */
+    const EventFilter &get_event_filter() const;
+
+    /**
+     * Set how events of one type are coalesced before their handlers are
+     * called. Events are not coalesced by default. Events of a coalesced type
+     * may be dispatched after later events of other types.
+     *
+     * @param ev The event type the policy applies to
+     * @param policy The policy to use for subsequently received events
+     */
+    void set_coalesce_policy(const Event ev, const CoalescePolicy &policy);
+
+    /**
+     * Get how events of one type are coalesced
+     */
+    const CoalescePolicy &get_coalesce_policy(const Event ev) const;
+
+    /**
+     * Get the number of milliseconds until a held coalesced event is due to
+     * be dispatched. handle_events must be called by then for the event to be
+     * dispatched on time, even if no more events arrive.
+     *
+     * @return The time in milliseconds, 0 if an event is already due, or -1
+     *   if no coalesced event is held
+     */
+    int get_coalesce_timeout_ms() const;
+
+    /**
+     * Set how lost sockets are re-established. When a socket is lost while
+     * sending a message or handling events, it is reconnected according to the
+     * policy, subscriptions are replayed, and the interrupted request is
+     * retried, so the caller never sees the loss. A command that was sent but
+     * not answered is not retried, since DWM may already have run it; the
+     * socket is still reconnected, but SocketClosedError is thrown.
+     *
+     * Reconnecting blocks the thread that noticed the loss, for up to
+     * timeout_ms. See set_event_reconnect_blocking to avoid that for the
+     * event socket.
+     *
+     * @param policy The policy to use from now on
+     */
+    void set_reconnect_policy(const ReconnectPolicy &policy);
+
+    /**
+     * Get the policy used to re-establish lost sockets
+     */
+    const ReconnectPolicy &get_reconnect_policy() const;
+
+    /**
+     * Set whether a lost event socket is reconnected by the thread that
+     * noticed the loss, according to the reconnect policy. If this is false,
+     * handle_events and subscribe throw SocketClosedError right away, and the
+     * caller is expected to call try_reconnect_event_socket until it
+     * succeeds. EventLoop does this so that it is never blocked. This is true
+     * by default.
+     */
+    void set_event_reconnect_blocking(bool blocking);
+
+    /**
+     * Check whether a lost event socket is reconnected by the thread that
+     * noticed the loss. See set_event_reconnect_blocking.
+     */
+    bool is_event_reconnect_blocking() const;
+
+    /**
+     * Make a single attempt to reconnect the event socket and replay the
+     * subscriptions, without waiting. on_reconnected is called if it
+     * succeeds.
+     *
+     * @return true if the event socket is connected
+     */
+    bool try_reconnect_event_socket();
+
+    /**
+     * Record every message sent and received on both sockets, including by
+     * the I/O thread and the background event thread. The recorder may be
+     * shared with other connections. This should not be called while another
+     * thread is using the event socket.
+     *
+     * @param recorder The recorder to write to, or nullptr to stop recording
+     */
+    void set_traffic_recorder(const std::shared_ptr<TrafficRecorder> &recorder);
+
+    /**
+     * Handle a message as if it had just been received from DWM. An event is
+     * passed through the event filter, coalescing and handlers, and a reply is
+     * parsed as by the request that asked for it and then discarded. This is
+     * used by TrafficReplayer to replay recorded traffic, and does not need a
+     * connected socket.
+     *
+     * @param type The message type from the packet header
+     * @param payload Pointer to the start of the payload
+     * @param size Size of the payload as specified in the packet header
+     * @param batch_end Whether this is the last event of a batch received in
+     *   one read, which releases events held by CoalesceMode::LATEST
+     *
+     * @throw ResultFailureError if the message is an error reply
+     * @throw IPCError if the message is malformed
+     */
+    void replay_message(uint8_t type, const char *payload, uint32_t size,
+                        bool batch_end = true);
+
     /**
      * The path to the DWM IPC socket specified when Connection is constructed.
      */
     const std::string socket_path;
 
+    /**
+     * Additional event handlers. Any number of handlers can be registered per
+     * event and removed again using the returned tokens. They are called by
+     * handle_event in the order they were added, before the on_* handler of
+     * the event. Handlers taking a lazy FocusedTitleChangeView or
+     * LayoutChangeView are called last.
+     */
+    HandlerRegistry handlers;
+
     /**
      * The dwmipc::Event::TAG_CHANGE handler. This will be called by
      * handle_event if an dwmipc::Event::TAG_CHANGE event message is received.
@@ -267,6 +675,21 @@ class Connection {
     std::function<void(const FocusedStateChangeEvent &ev)>
         on_focused_state_change;
 
+    /**
+     * Called after a lost socket has been reconnected and the subscriptions
+     * replayed. Events raised while the socket was down are lost, so any
+     * state derived from events should be refreshed, which can be done with
+     * requests from within this handler.
+     *
+     * This is called on the thread that noticed the loss. For the event
+     * socket, that is the thread calling handle_events or subscribe, or the
+     * thread running an EventLoop. For the main socket, it is the thread
+     * making the request, which is the internal I/O thread in thread-safe
+     * mode and the thread holding the lease with a ConnectionPool, and the
+     * main socket's mutex is held.
+     */
+    std::function<void()> on_reconnected;
+
   private:
     /**
      * The main DWM IPC socket file descriptor for all non-event messages
@@ -287,6 +710,160 @@ class Connection {
      */
     uint8_t subscriptions = 0;
 
+    /**
+     * The implementation used to decode messages from DWM
+     */
+    Decoder decoder = Decoder::STREAMING;
+
+    /**
+     * Storage for the most recently decoded event. This is reused for every
+     * event so that its strings keep their capacity between events.
+     */
+    EventMessage event_msg;
+
+    /**
+     * Selects the events that are dispatched
+     */
+    EventFilter event_filter;
+
+    /**
+     * Holds events of coalesced types until they are due
+     */
+    EventCoalescer coalescer;
+
+    /**
+     * Storage for an event released by the coalescer
+     */
+    EventMessage coalesced_msg;
+
+    /**
+     * Buffer for bytes received on the event socket
+     */
+    FrameReader event_reader;
+
+    /**
+     * How lost sockets are re-established
+     */
+    ReconnectPolicy reconnect_policy;
+
+    /**
+     * Incremented every time the event socket is connected
+     */
+    unsigned int event_socket_generation = 0;
+
+    /**
+     * Set while the event socket is being reconnected, so that a failure to
+     * resubscribe does not start a nested reconnect
+     */
+    bool event_reconnecting = false;
+
+    /**
+     * Reconnect a lost event socket in place, see
+     * set_event_reconnect_blocking
+     */
+    bool event_reconnect_blocking = true;
+
+    /**
+     * Events received on the event socket while waiting for a reply
+     */
+    std::deque<std::shared_ptr<Packet>> deferred_events;
+
+    /**
+     * Receive events on the background event thread
+     */
+    bool event_thread_enabled = false;
+
+    /**
+     * Events queued by the background event thread before it was last
+     * paused, which are older than any deferred events
+     */
+    size_t event_thread_backlog = 0;
+
+    /**
+     * Events at the front of the event thread queue that were filtered with
+     * an older filter than the current one, so must be filtered again
+     */
+    size_t event_thread_stale = 0;
+
+    /**
+     * Where messages are recorded, if anywhere. The event thread writes to it
+     * while it runs, so it is declared before it.
+     */
+    std::shared_ptr<TrafficRecorder> recorder;
+
+    /**
+     * When the last read from each socket returned, the time recorded for
+     * the messages it completed
+     */
+    TrafficRecorder::Clock::time_point main_filled, event_filled;
+
+    /**
+     * Reads the event socket while event_thread_enabled is set. It uses
+     * event_reader while it runs, so it is declared after it.
+     */
+    EventReaderThread event_thread;
+
+    /**
+     * Buffer for bytes received on the main socket
+     */
+    FrameReader main_reader;
+
+    /**
+     * Packets for requests and replies, reused across messages
+     */
+    PacketPool packet_pool;
+
+    /**
+     * A request queued for the I/O thread
+     */
+    struct AsyncRequest {
+        PacketView request; ///< The message to send
+        /// Owns the bytes of request, null if they are static
+        std::shared_ptr<Packet> packet;
+        /// Decode the reply and fulfill the request's promise
+        std::function<void(const std::shared_ptr<Packet> &)> fulfill;
+        /// Fail the request's promise with the specified exception
+        std::function<void(std::exception_ptr)> fail;
+    };
+
+    /**
+     * Route requests on the main socket through the I/O thread
+     */
+    bool thread_safe = false;
+
+    /**
+     * Serializes use of the main socket between the I/O thread and the
+     * calling thread. It is recursive because on_reconnected is called while
+     * it is held and may make requests.
+     */
+    std::recursive_mutex main_mutex;
+
+    /**
+     * Thread that sends queued asynchronous requests. It is started the first
+     * time an asynchronous request is made.
+     */
+    std::thread io_thread;
+
+    /**
+     * Protects io_queue and io_stopping
+     */
+    std::mutex io_mutex;
+
+    /**
+     * Signalled when a request is queued or the I/O thread should stop
+     */
+    std::condition_variable io_cv;
+
+    /**
+     * Asynchronous requests waiting to be sent
+     */
+    std::deque<AsyncRequest> io_queue;
+
+    /**
+     * Set when the I/O thread should exit once the queue is empty
+     */
+    bool io_stopping = false;
+
     /**
      * Subscribe to all events specified in subscriptions. This is used to
      * resubscribe to events after a reconnection.
@@ -303,8 +880,9 @@ class Connection {
 
     /**
      * Require that the appropriate socket is connected to write/receive the
-     * specified message type. This function throws a SocketClosedError if the
-     * socket is disconnected.
+     * specified message type. A socket that is found to have been lost is
+     * reconnected according to the reconnect policy. This function throws a
+     * SocketClosedError if the socket is disconnected.
      *
      * @throw SocketClosedError if the required socket is disconnected
      */
@@ -314,17 +892,186 @@ class Connection {
      * Send a message to DWM with the specified payload and message type
      *
      * @param type IPC message type
-     * @param msg The payload. This can be left empty for message types where
-     *   the payload is not needed/used.
-     * @param reconnect If true and the main socket is disconnected, an attempt
-     *   to re-establish the connection will be made
+     * @param msg The payload
      *
      * @return The reply packet from DWM
      *
      * @throw ReplyError if reply message type doesn't match sent message type
      */
     std::shared_ptr<Packet> dwm_msg(const MessageType type,
-                                    const std::string &msg = "");
+                                    const std::string &msg);
+
+    /**
+     * Send an already serialized message to DWM
+     *
+     * @param request The complete packet to send, such as one of the static
+     *   packets from static_packet.hpp
+     *
+     * @return The reply packet from DWM
+     *
+     * @throw ReplyError if reply message type doesn't match sent message type
+     */
+    std::shared_ptr<Packet> dwm_msg(const PacketView &request);
+
+    /**
+     * The maximum number of requests written to the main socket before their
+     * replies are read. This bounds the number of replies DWM has to buffer.
+     */
+    static constexpr size_t PIPELINE_DEPTH = 64;
+
+    /**
+     * Send several messages to DWM on the main socket without waiting for a
+     * reply between them, then collect all of the replies. Requests are
+     * written in chunks of PIPELINE_DEPTH.
+     *
+     * @param requests The messages to send. They must not be subscribe or
+     *   event messages.
+     * @param count The number of messages in requests
+     *
+     * @return The reply packets from DWM, in the same order as requests
+     *
+     * @throw ReplyError if a reply's message type doesn't match the type of
+     *   the message it is a reply to
+     * @throw SocketClosedError if the socket is disconnected
+     */
+    std::vector<std::shared_ptr<Packet>> dwm_msgs(const PacketView *requests,
+                                                  size_t count);
+
+    /**
+     * Pipeline messages as dwm_msgs does, without checking the types of the
+     * replies
+     *
+     * @param requests The messages to send
+     * @param count The number of messages in requests
+     * @param replies Filled with the reply packets in the same order as
+     *   requests. If an exception is thrown, it holds the replies received
+     *   before the failure.
+     *
+     * @throw SocketClosedError if the socket is disconnected
+     */
+    void pipeline(const PacketView *requests, size_t count,
+                  std::vector<std::shared_ptr<Packet>> &replies);
+
+    /**
+     * Send a message on the main socket and wait for its reply. In
+     * thread-safe mode, the message is queued for the I/O thread, otherwise
+     * it is sent with dwm_msg.
+     *
+     * @param request The message to send. Its bytes only need to stay valid
+     *   until this returns.
+     *
+     * @return The reply packet from DWM
+     *
+     * @throw ReplyError if reply message type doesn't match sent message type
+     * @throw SocketClosedError if the socket is disconnected
+     */
+    std::shared_ptr<Packet> send_request(const PacketView &request);
+
+    /**
+     * Send several messages on the main socket and wait for their replies. In
+     * thread-safe mode, the messages are queued for the I/O thread, otherwise
+     * they are sent with dwm_msgs.
+     *
+     * @param requests The messages to send. Their bytes only need to stay
+     *   valid until this returns.
+     * @param count The number of messages in requests
+     *
+     * @return The reply packets from DWM, in the same order as requests
+     *
+     * @throw ReplyError if a reply's message type doesn't match the type of
+     *   the message it is a reply to
+     * @throw SocketClosedError if the socket is disconnected
+     */
+    std::vector<std::shared_ptr<Packet>>
+    send_requests(const PacketView *requests, size_t count);
+
+    /**
+     * Check if requests should be queued for the I/O thread. This is false on
+     * the I/O thread itself, for example in on_reconnected, since it would
+     * wait for itself.
+     */
+    bool use_io_thread() const;
+
+    /**
+     * Reconnect a lost socket according to the reconnect policy, and call
+     * on_reconnected if successful
+     *
+     * @param event_socket Reconnect the event socket if true, otherwise the
+     *   main socket
+     *
+     * @return true if the socket was reconnected, false if reconnecting is
+     *   disabled or timed out
+     */
+    bool reconnect_socket(bool event_socket);
+
+    /**
+     * Receive a reply into a packet from the pool. The socket is read through
+     * its FrameReader, so a burst of pipelined replies usually takes a single
+     * read.
+     *
+     * @param sockfd The socket to receive the reply from
+     */
+    std::shared_ptr<Packet> recv_reply(int sockfd);
+
+    /**
+     * Read from a socket into its FrameReader, noting when the read returned
+     * if traffic is being recorded. See FrameReader::fill.
+     */
+    size_t fill_reader(FrameReader &reader, int sockfd, bool &drained);
+
+    /**
+     * Record a frame extracted from the main or event socket's FrameReader,
+     * if traffic is being recorded
+     */
+    void record_received(const FrameReader &reader, const Frame &frame);
+
+    /**
+     * Record requests that are about to be sent, if traffic is being
+     * recorded
+     */
+    void record_sent(SocketRole role, const PacketView *requests,
+                     size_t count);
+
+    /**
+     * Decode a reply to a MessageType::GET_MONITORS message
+     *
+     * @throw ResultFailureError if DWM sent an error reply.
+     */
+    std::shared_ptr<std::vector<Monitor>>
+    parse_monitors_reply(const std::shared_ptr<Packet> &reply) const;
+
+    /**
+     * Decode a reply to a MessageType::GET_TAGS message
+     *
+     * @throw ResultFailureError if DWM sent an error reply.
+     */
+    std::shared_ptr<std::vector<Tag>>
+    parse_tags_reply(const std::shared_ptr<Packet> &reply) const;
+
+    /**
+     * Decode a reply to a MessageType::GET_LAYOUTS message
+     *
+     * @throw ResultFailureError if DWM sent an error reply.
+     */
+    std::shared_ptr<std::vector<Layout>>
+    parse_layouts_reply(const std::shared_ptr<Packet> &reply) const;
+
+    /**
+     * Decode a reply to a MessageType::GET_DWM_CLIENT message
+     *
+     * @throw ResultFailureError if DWM sent an error reply.
+     */
+    std::shared_ptr<Client>
+    parse_client_reply(const std::shared_ptr<Packet> &reply) const;
+
+    /**
+     * Decode a reply to a MessageType::GET_DWM_CLIENT message into an
+     * existing Client
+     *
+     * @throw ResultFailureError if DWM sent an error reply
+     */
+    void parse_client_reply(const std::shared_ptr<Packet> &reply,
+                            Client &client) const;
 
     /**
      * Subscribe or unsubscribe to the specified event
@@ -337,37 +1084,209 @@ class Connection {
     void subscribe(const Event ev, const bool sub);
 
     /**
-     * Base case of run_command_build which checks if a valid argument type was
-     * provided and then appends the argument to the specified JSON array.
+     * Subscribe or unsubscribe to several events in one round trip
+     *
+     * @param mask Bitwise OR of the dwmipc::Event values
+     * @param sub true to subscribe, false to unsubscribe
      *
-     * @param arr The JSON array to append the argument to
-     * @param arg The argument to append to the array
+     * @throw ResultFailureError if DWM sends an error reply.
      */
-    template <typename T>
-    static void run_command_build(Json::Value &arr, T arg) {
-        static_assert(std::is_arithmetic<T>::value ||             // number
-                          std::is_same<T, std::string>::value ||  // string
-                          std::is_same<T, const char *>::value || // string
-                          std::is_same<T, bool>::value,           // bool
-                      "The arguments to run_command must be a string, number, "
-                      "bool, or NULL");
-        arr.append(arg);
+    void subscribe_mask(uint8_t mask, bool sub);
+
+    /**
+     * Call the event handler associated with the type of the specified event
+     *
+     * @param msg The decoded event
+     */
+    void dispatch_event(const EventMessage &msg);
+
+    /**
+     * Dispatch the coalesced events that are due
+     *
+     * @param batch_end true if events held until the end of a handle_events
+     *   call are due
+     */
+    void dispatch_coalesced(bool batch_end);
+
+    /**
+     * Start the background event thread if it is enabled, not running, and
+     * the event socket is connected
+     */
+    void resume_event_thread();
+
+    /**
+     * Stop the background event thread so that the event socket can be used
+     * or closed by the calling thread
+     */
+    void pause_event_thread();
+
+    /**
+     * Dispatch events queued by the background event thread
+     *
+     * @param max The maximum number of events to handle
+     *
+     * @return The number of events handled
+     */
+    size_t handle_queued_events(size_t max);
+
+    /**
+     * Reconnect the event socket or rethrow the error if the background event
+     * thread has exited and every event it queued has been handled
+     */
+    void check_event_thread();
+
+    /**
+     * Filter the payload of an event message and dispatch it to the view
+     * handlers and, if needed, decode it for the other handlers
+     *
+     * @param payload Pointer to the start of the payload
+     * @param size Size of the payload as specified in the packet header
+     * @param decoded The event if it was already decoded, otherwise nullptr
+     * @param filtered Whether the event already passed the current filter
+     *
+     * @throw IPCError if the event type is not recognized
+     */
+    void handle_event_payload(const char *payload, const uint32_t size,
+                              const EventMessage *decoded = nullptr,
+                              bool filtered = false);
+
+    /**
+     * Decode the payload of an event message and dispatch it to the handlers
+     * taking the decoded event
+     *
+     * @param payload Pointer to the start of the payload
+     * @param size Size of the payload as specified in the packet header
+     * @param decoded The event if it was already decoded, otherwise nullptr
+     *
+     * @throw IPCError if the event type is not recognized
+     */
+    void decode_event_payload(const char *payload, const uint32_t size,
+                              const EventMessage *decoded);
+
+    /**
+     * Check if the on_* handler or a registered handler taking the decoded
+     * event is set for an event
+     */
+    bool has_event_handler(Event ev) const;
+
+    /**
+     * Serialize a RUN_COMMAND message into a pooled packet
+     *
+     * @param name Name of the command
+     * @param arr JSON array of arguments for the command
+     */
+    std::shared_ptr<Packet> build_command_packet(const std::string &name,
+                                                 const Json::Value &arr);
+
+    /**
+     * Send a serialized RUN_COMMAND message and check the result
+     *
+     * @throw ResultFailureError if DWM sends an error reply
+     */
+    void send_command(const std::shared_ptr<Packet> &packet);
+
+    /**
+     * Queue a serialized RUN_COMMAND message for the I/O thread
+     *
+     * @return A future that becomes ready when DWM has run the command
+     */
+    std::future<void> send_command_async(const std::shared_ptr<Packet> &packet);
+
+    /**
+     * Queue a request for the I/O thread, starting the thread if needed
+     *
+     * @throw InvalidOperationError if the connection is being destroyed
+     */
+    void enqueue(AsyncRequest &&request);
+
+    /**
+     * The I/O thread's main loop. It repeatedly takes every queued request,
+     * pipelines them, and fulfills their promises in order. Each promise is
+     * failed on its own, so a bad reply only affects the request it answers.
+     */
+    void io_loop();
+
+    /**
+     * Make the I/O thread exit after it finishes queued requests, and wait for
+     * it
+     */
+    void stop_io_thread();
+
+    /**
+     * Fulfill a promise with the value returned by parse
+     */
+    template <typename T, typename Parse>
+    static void set_promise(std::promise<T> &promise, Parse &parse,
+                            const std::shared_ptr<Packet> &reply) {
+        promise.set_value(parse(reply));
+    }
+
+    /**
+     * Fulfill a promise for a request with no value after parse succeeds
+     */
+    template <typename Parse>
+    static void set_promise(std::promise<void> &promise, Parse &parse,
+                            const std::shared_ptr<Packet> &reply) {
+        parse(reply);
+        promise.set_value();
+    }
+
+    /**
+     * Queue a message for the I/O thread
+     *
+     * @param view The message to send
+     * @param packet The packet that owns the bytes of view, or nullptr if they
+     *   are static
+     * @param parse Function called on the I/O thread to decode the reply
+     *
+     * @return A future for the value returned by parse
+     */
+    template <typename T, typename Parse>
+    std::future<T> submit(const PacketView &view,
+                          const std::shared_ptr<Packet> &packet, Parse parse) {
+        auto promise = std::make_shared<std::promise<T>>();
+        std::future<T> future = promise->get_future();
+
+        AsyncRequest request;
+        request.request = view;
+        request.packet = packet;
+        request.fulfill =
+            [promise, parse](const std::shared_ptr<Packet> &reply) mutable {
+                set_promise(*promise, parse, reply);
+            };
+        request.fail = [promise](std::exception_ptr err) {
+            promise->set_exception(err);
+        };
+
+        enqueue(std::move(request));
+        return future;
     }
 
-    // Recursive
     /**
-     * The recursive case of the run_command_build function which calls the base
-     * case of run_command_build to append the first argument to the specified
-     * JSON array and then calls itself with the remaining arguments.
+     * Base case of run_command_write, reached once every argument has been
+     * written
+     */
+    static void run_command_write(CommandWriter &) {}
+
+    /**
+     * Check if a valid argument type was provided, write the first argument
+     * to the message, and then call run_command_write with the remaining
+     * arguments.
      *
-     * @param arr The JSON array to append the arg1 to
-     * @param arg1 The argument to append to the array
+     * @param writer The message being written
+     * @param arg1 The argument to write
      * @param args The rest of the arguments
      */
     template <typename T, typename... Ts>
-    static void run_command_build(Json::Value &arr, T arg1, Ts... args) {
-        run_command_build(arr, arg1);
-        run_command_build(arr, args...);
+    static void run_command_write(CommandWriter &writer, T arg1, Ts... args) {
+        static_assert(std::is_arithmetic<T>::value ||             // number
+                          std::is_same<T, std::string>::value ||  // string
+                          std::is_same<T, const char *>::value || // string
+                          std::is_same<T, bool>::value,           // bool
+                      "The arguments to run_command must be a string, number, "
+                      "bool, or NULL");
+        writer.value(arg1);
+        run_command_write(writer, args...);
     }
 };
 } // namespace dwmipc
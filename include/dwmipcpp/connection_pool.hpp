@@ -0,0 +1,280 @@
+/**
+ * @file connection_pool.hpp
+ *
+ * This file contains the declarations for the ConnectionPool class which
+ * leases main socket connections to concurrent callers.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "connection.hpp"
+
+namespace dwmipc {
+/**
+ * Controls how many connections a ConnectionPool keeps and how it checks them
+ */
+struct ConnectionPoolOptions {
+    /**
+     * Connections opened when the pool is created and kept open while idle
+     */
+    size_t min_connections = 1;
+
+    /**
+     * The most connections open at once. Callers of lease wait for a
+     * connection to be returned once this many are leased.
+     */
+    size_t max_connections = 8;
+
+    /**
+     * Idle connections beyond min_connections are closed after this many
+     * milliseconds without being leased
+     */
+    unsigned int idle_timeout_ms = 30000;
+
+    /**
+     * A connection that has been idle for this many milliseconds is checked
+     * before it is leased, and reconnected or replaced if its socket was lost
+     */
+    unsigned int health_check_ms = 5000;
+
+    /**
+     * How long lease waits for a connection before throwing TimeoutError. 0
+     * means wait forever.
+     */
+    unsigned int lease_timeout_ms = 0;
+};
+
+/**
+ * Usage counters of one pooled connection
+ */
+struct PooledConnectionStats {
+    unsigned int id;    ///< Number identifying the connection in the pool
+    bool leased;        ///< The connection is currently leased
+    size_t leases;      ///< Number of times the connection was leased
+    double busy_ms;     ///< Time spent leased, including the current lease
+    double lifetime_ms; ///< Time since the connection was opened
+
+    /**
+     * Fraction of the connection's lifetime it spent leased
+     */
+    double utilization() const {
+        return lifetime_ms > 0 ? busy_ms / lifetime_ms : 0;
+    }
+};
+
+/**
+ * Counters describing how a ConnectionPool is being used. Consistently high
+ * utilization of every connection and a growing number of waits suggest that
+ * max_connections is too small, while idle connections suggest that
+ * min_connections is too large.
+ */
+struct ConnectionPoolStats {
+    size_t opened;   ///< Connections opened since the pool was created
+    size_t closed;   ///< Connections closed because they were idle
+    size_t replaced; ///< Connections dropped because their socket was lost
+    size_t waits;    ///< Leases that had to wait for a connection
+    std::vector<PooledConnectionStats> connections; ///< The open connections
+};
+
+class ConnectionPool;
+
+/**
+ * Exclusive use of one pooled Connection. The connection is returned to the
+ * pool when the lease is destroyed or released. Leases can be moved but not
+ * copied.
+ */
+class ConnectionLease {
+  public:
+    /**
+     * Construct a lease that does not hold a connection
+     */
+    ConnectionLease() = default;
+
+    ConnectionLease(ConnectionLease &&other);
+    ConnectionLease &operator=(ConnectionLease &&other);
+    ConnectionLease(const ConnectionLease &) = delete;
+    ConnectionLease &operator=(const ConnectionLease &) = delete;
+
+    /**
+     * Return the connection to the pool
+     */
+    ~ConnectionLease();
+
+    /**
+     * Check if the lease holds a connection
+     */
+    bool valid() const { return this->conn != nullptr; }
+
+    /**
+     * Return the connection to the pool before the lease is destroyed
+     */
+    void release();
+
+    Connection &operator*() const { return *this->conn; }
+    Connection *operator->() const { return this->conn; }
+
+  private:
+    friend class ConnectionPool;
+
+    ConnectionPool *pool = nullptr;
+    Connection *conn = nullptr;
+
+    ConnectionLease(ConnectionPool *pool, Connection *conn);
+};
+
+/**
+ * A set of connections to the main socket of one DWM instance, leased to
+ * callers so that queries from several threads run in parallel instead of
+ * waiting for each other's round trips. The pool opens connections on demand
+ * up to max_connections, and closes connections that stay idle beyond
+ * min_connections. Connections that have been idle for a while are checked
+ * before being leased.
+ *
+ * Pooled connections do not connect to the event socket. Events are received
+ * by a single Connection shared by the whole pool, see events. The pool is
+ * thread safe, but every lease must be released before the pool is destroyed.
+ */
+class ConnectionPool {
+  public:
+    /**
+     * Create a pool and open min_connections connections and the event
+     * socket
+     *
+     * @param socket_path Path to DWM's IPC socket
+     * @param options How many connections to keep and how to check them
+     *
+     * @throw SocketClosedError if DWM cannot be connected to
+     */
+    ConnectionPool(const std::string &socket_path,
+                   const ConnectionPoolOptions &options =
+                       ConnectionPoolOptions());
+
+    /**
+     * Lease a connection, opening a new one if every open connection is
+     * leased and the pool is not full
+     *
+     * @throw TimeoutError if no connection became available within
+     *   lease_timeout_ms
+     * @throw SocketClosedError if a new connection could not be opened
+     */
+    ConnectionLease lease();
+
+    /**
+     * Get the connection that receives events for the pool. It is only
+     * connected to the event socket, so it is used to subscribe and handle
+     * events and must only be used by one thread at a time.
+     */
+    Connection &events();
+
+    /**
+     * Close connections that have been idle for longer than idle_timeout_ms,
+     * keeping at least min_connections open. This is also done whenever a
+     * connection is leased or returned.
+     */
+    void prune();
+
+    /**
+     * Get the number of open connections, including the leased ones
+     */
+    size_t size() const;
+
+    /**
+     * Get the pool's counters and the utilization of every connection
+     */
+    ConnectionPoolStats get_stats() const;
+
+    /**
+     * The path to the DWM IPC socket specified when the pool was constructed
+     */
+    const std::string socket_path;
+
+  private:
+    friend class ConnectionLease;
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+        std::unique_ptr<Connection> conn;
+        unsigned int id;
+        bool leased = false;
+        size_t leases = 0;
+        Clock::time_point opened;
+        Clock::time_point last_used; ///< When the last lease started or ended
+        Clock::duration busy{};      ///< Time spent leased by past leases
+    };
+
+    const ConnectionPoolOptions options;
+
+    /**
+     * Only connected to the event socket
+     */
+    Connection event_conn;
+
+    /**
+     * Protects everything below
+     */
+    mutable std::mutex mutex;
+
+    /**
+     * Signalled when a connection is returned or a slot becomes free
+     */
+    std::condition_variable available;
+
+    std::vector<std::unique_ptr<Entry>> entries;
+
+    /**
+     * Connections being opened outside the lock, counted against
+     * max_connections
+     */
+    size_t opening = 0;
+
+    unsigned int last_id = 0;
+    ConnectionPoolStats stats = {};
+
+    /**
+     * Open a new connection to the main socket
+     */
+    std::unique_ptr<Connection> open_connection() const;
+
+    /**
+     * Make sure a connection that was idle for a while still has its socket,
+     * reconnecting it if needed
+     *
+     * @return false if the connection could not be restored
+     */
+    bool check(Connection &conn) const;
+
+    /**
+     * Find the entry of a leased connection
+     */
+    Entry *find(const Connection *conn) const;
+
+    /**
+     * Return a leased connection to the pool
+     */
+    void give_back(Connection *conn);
+
+    /**
+     * Remove an entry, moving it into closed so its connection can be
+     * destroyed without holding the lock
+     */
+    void take_entry(const Entry *entry,
+                    std::vector<std::unique_ptr<Entry>> &closed);
+
+    /**
+     * Remove idle entries that have timed out. The removed connections are
+     * moved into closed so they can be destroyed without holding the lock.
+     */
+    void take_expired(std::vector<std::unique_ptr<Entry>> &closed,
+                      Clock::time_point now);
+};
+
+} // namespace dwmipc
@@ -0,0 +1,119 @@
+/**
+ * @file decoder.hpp
+ *
+ * This file contains the declarations for the functions that turn DWM's JSON
+ * payloads into the structs defined in types.hpp. Two implementations are
+ * provided for each message: one that walks a Json::Value tree built by
+ * jsoncpp, and a streaming one that decodes straight from the payload buffer.
+ * This file is used internally by dwmipcpp.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <json/json.h>
+#include <vector>
+
+#include "types.hpp"
+
+namespace dwmipc {
+/**
+ * The implementations available for decoding messages from DWM
+ */
+enum class Decoder : uint8_t {
+    JSONCPP,  ///< Build a Json::Value tree and copy values out of it
+    STREAMING ///< Decode directly from the payload without building a tree.
+              ///< Falls back to JSONCPP if the payload is not understood.
+};
+
+/**
+ * A decoded event message of any type. Only the member corresponding to type
+ * is valid. Reusing the same EventMessage for successive events allows the
+ * string members to keep their capacity.
+ */
+struct EventMessage {
+    Event type; ///< The type of event that was decoded
+    TagChangeEvent tag_change;                     ///< Event::TAG_CHANGE
+    ClientFocusChangeEvent client_focus_change;    ///< CLIENT_FOCUS_CHANGE
+    LayoutChangeEvent layout_change;               ///< Event::LAYOUT_CHANGE
+    MonitorFocusChangeEvent monitor_focus_change;  ///< MONITOR_FOCUS_CHANGE
+    FocusedTitleChangeEvent focused_title_change;  ///< FOCUSED_TITLE_CHANGE
+    FocusedStateChangeEvent focused_state_change;  ///< FOCUSED_STATE_CHANGE
+};
+
+/**
+ * Parse a reply payload from DWM into a Json::Value.
+ *
+ * @param root The value to parse the payload into
+ * @param payload Pointer to the start of the payload
+ * @param size Size of the payload as specified in the packet header
+ *
+ * @throw ResultFailureError if DWM sends an error reply.
+ */
+void pre_parse_reply(Json::Value &root, const char *payload, uint32_t size);
+
+/**
+ * Copy the event contained in a parsed event message into an EventMessage
+ *
+ * @param root The parsed event message
+ * @param msg The EventMessage to store the event in
+ *
+ * @return true if the event was recognized, false otherwise
+ */
+bool parse_event(const Json::Value &root, EventMessage &msg);
+
+/**
+ * Decode an event message directly from its payload.
+ *
+ * @param payload Pointer to the start of the payload
+ * @param size Size of the payload as specified in the packet header
+ * @param msg The EventMessage to store the event in
+ *
+ * @return true if the event was decoded, false if the payload is malformed or
+ *   does not match the expected schema
+ */
+bool decode_event(const char *payload, uint32_t size, EventMessage &msg);
+
+/**
+ * Copy the monitors contained in a parsed GET_MONITORS reply
+ *
+ * @param root The parsed reply
+ * @param monitors The vector to store the monitors in
+ */
+void parse_monitors(const Json::Value &root, std::vector<Monitor> &monitors);
+
+/**
+ * Decode a GET_MONITORS reply directly from its payload in a single pass.
+ * Existing elements of the vector are reused.
+ *
+ * @param payload Pointer to the start of the payload
+ * @param size Size of the payload as specified in the packet header
+ * @param monitors The vector to store the monitors in
+ *
+ * @return true if the reply was decoded, false if the payload is malformed,
+ *   is an error reply, or does not match the expected schema
+ */
+bool decode_monitors(const char *payload, uint32_t size,
+                     std::vector<Monitor> &monitors);
+
+/**
+ * Copy the client contained in a parsed GET_DWM_CLIENT reply
+ *
+ * @param root The parsed reply
+ * @param client The Client to store the client properties in
+ */
+void parse_client(const Json::Value &root, Client &client);
+
+/**
+ * Decode a GET_DWM_CLIENT reply directly from its payload in a single pass
+ *
+ * @param payload Pointer to the start of the payload
+ * @param size Size of the payload as specified in the packet header
+ * @param client The Client to store the client properties in
+ *
+ * @return true if the reply was decoded, false if the payload is malformed,
+ *   is an error reply, or does not match the expected schema
+ */
+bool decode_client(const char *payload, uint32_t size, Client &client);
+
+} // namespace dwmipc
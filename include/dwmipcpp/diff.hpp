@@ -0,0 +1,127 @@
+/**
+ * @file diff.hpp
+ *
+ * This file contains the declarations for comparing successive snapshots of
+ * monitors and clients, so consumers can update only what changed.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "types.hpp"
+
+namespace dwmipc {
+/**
+ * Bit flags naming the fields of a Monitor that can change
+ */
+enum class MonitorField : uint32_t {
+    MASTER_FACTOR = 1 << 0,    ///< Monitor::master_factor
+    NUM_MASTER = 1 << 1,       ///< Monitor::num_master
+    IS_SELECTED = 1 << 2,      ///< Monitor::is_selected
+    MONITOR_GEOM = 1 << 3,     ///< Monitor::monitor_geom
+    WINDOW_GEOM = 1 << 4,      ///< Monitor::window_geom
+    TAGSET = 1 << 5,           ///< Monitor::tagset
+    TAG_STATE = 1 << 6,        ///< Monitor::tag_state
+    CLIENTS_ALL = 1 << 7,      ///< Monitor::clients.all
+    CLIENTS_STACK = 1 << 8,    ///< Monitor::clients.stack
+    CLIENTS_SELECTED = 1 << 9, ///< Monitor::clients.selected
+    LAYOUT_SYMBOL = 1 << 10,   ///< Monitor::layout.symbol
+    LAYOUT_ADDRESS = 1 << 11,  ///< Monitor::layout.address
+    BAR = 1 << 12              ///< Monitor::bar
+};
+
+/**
+ * Bit flags naming the fields of a Client that can change
+ */
+enum class ClientField : uint32_t {
+    NAME = 1 << 0,         ///< Client::name
+    MONITOR_NUM = 1 << 1,  ///< Client::monitor_num
+    TAGS = 1 << 2,         ///< Client::tags
+    BORDER_WIDTH = 1 << 3, ///< Client::border_width
+    GEOM = 1 << 4,         ///< Client::geom
+    SIZE_HINTS = 1 << 5,   ///< Client::size_hints
+    STATES = 1 << 6        ///< Client::states
+};
+
+/**
+ * The changes to a single monitor between two snapshots
+ */
+struct MonitorDiff {
+    unsigned int num;       ///< Index of the monitor
+    uint32_t changed;       ///< MonitorField flags of the fields that changed
+    std::vector<Window> added;   ///< Windows now in clients.all that were not
+    std::vector<Window> removed; ///< Windows no longer in clients.all
+    bool stack_reordered; ///< clients.stack holds the same windows in a
+                          ///< different order
+
+    /**
+     * Check if the specified field changed
+     */
+    bool has(const MonitorField field) const {
+        return (changed & static_cast<uint32_t>(field)) != 0;
+    }
+};
+
+/**
+ * The changes between two snapshots of all monitors
+ */
+struct MonitorsDiff {
+    std::vector<MonitorDiff> monitors; ///< Monitors present in both snapshots
+                                       ///< that changed
+    std::vector<unsigned int> added_monitors;   ///< Indices of new monitors
+    std::vector<unsigned int> removed_monitors; ///< Indices of gone monitors
+    std::vector<Window> added_windows;   ///< Windows that did not exist on any
+                                         ///< monitor before
+    std::vector<Window> removed_windows; ///< Windows that no longer exist on
+                                         ///< any monitor. A window moved
+                                         ///< between monitors is in neither.
+
+    /**
+     * Check if the snapshots were identical
+     */
+    bool empty() const {
+        return monitors.empty() && added_monitors.empty() &&
+               removed_monitors.empty();
+    }
+
+    /**
+     * Remove all changes, keeping the capacity of the vectors
+     */
+    void clear();
+};
+
+/**
+ * Compare two monitors
+ *
+ * @param old_mon The earlier snapshot of the monitor
+ * @param new_mon The later snapshot of the monitor
+ * @param diff Filled with the changes. Its vectors are cleared first.
+ *
+ * @return true if anything changed
+ */
+bool diff_monitor(const Monitor &old_mon, const Monitor &new_mon,
+                  MonitorDiff &diff);
+
+/**
+ * Compare two snapshots of all monitors. Monitors are matched by their index.
+ *
+ * @param old_mons The earlier snapshot
+ * @param new_mons The later snapshot
+ * @param diff Filled with the changes. It is cleared first.
+ */
+void diff_monitors(const std::vector<Monitor> &old_mons,
+                   const std::vector<Monitor> &new_mons, MonitorsDiff &diff);
+
+/**
+ * Compare two snapshots of a client
+ *
+ * @param old_client The earlier snapshot of the client
+ * @param new_client The later snapshot of the client
+ *
+ * @return ClientField flags of the fields that changed
+ */
+uint32_t diff_client(const Client &old_client, const Client &new_client);
+
+} // namespace dwmipc
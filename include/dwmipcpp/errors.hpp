@@ -148,4 +148,28 @@ class InvalidOperationError : public IPCError {
     InvalidOperationError(const std::string &msg);
 };
 
+/**
+ * This error is thrown when an operation does not complete within its time
+ * limit, such as waiting for a pooled connection.
+ */
+class TimeoutError : public IPCError {
+  public:
+    /**
+     * Construct a TimeoutError specifying the operation that timed out
+     */
+    TimeoutError(const std::string &msg);
+};
+
+/**
+ * This error is thrown when a traffic log cannot be read because it is not a
+ * traffic log, has an unsupported version or is truncated.
+ */
+class TrafficLogError : public IPCError {
+  public:
+    /**
+     * Construct a TrafficLogError describing what is wrong with the log
+     */
+    TrafficLogError(const std::string &msg);
+};
+
 } // namespace dwmipc
@@ -0,0 +1,117 @@
+/**
+ * @file event_coalescer.hpp
+ *
+ * This file contains the declarations for the EventCoalescer class which
+ * merges bursts of events into single events. This file is used internally by
+ * dwmipcpp.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "decoder.hpp"
+#include "types.hpp"
+
+namespace dwmipc {
+/**
+ * How events of one type are merged before being dispatched
+ */
+enum class CoalesceMode : uint8_t {
+    NONE,   ///< Dispatch every event as soon as it is received
+    LATEST, ///< Merge the events handled by one Connection::handle_events call
+    WINDOW  ///< Merge the events received within window_ms of the first one
+};
+
+/**
+ * Controls how a Connection coalesces events of one type. A merged event holds
+ * the old_* values of the first event merged into it and the new_* values of
+ * the last, so it still describes a consistent transition.
+ */
+struct CoalescePolicy {
+    CoalesceMode mode = CoalesceMode::NONE; ///< How events are merged
+
+    /**
+     * How long to hold the first event of a burst for CoalesceMode::WINDOW
+     */
+    unsigned int window_ms = 0;
+
+    /**
+     * Merge events separately for each monitor (tag, layout and client focus
+     * changes) or window (focused title and state changes) instead of merging
+     * every event of the type together
+     */
+    bool per_key = false;
+};
+
+/**
+ * Holds events that are waiting to be merged with later events of the same
+ * type, according to a CoalescePolicy for each event type. Merged events are
+ * released in the order their first event was received.
+ */
+class EventCoalescer {
+  public:
+    /**
+     * Set the policy for an event type. Events already held keep the policy
+     * they were received under.
+     */
+    void set_policy(Event ev, const CoalescePolicy &policy);
+
+    /**
+     * Get the policy for an event type
+     */
+    const CoalescePolicy &get_policy(Event ev) const;
+
+    /**
+     * Hold an event if its type is coalesced, merging it into an event that
+     * is already held for the same type and key
+     *
+     * @return true if the event is held, false if it should be dispatched now
+     */
+    bool add(const EventMessage &msg);
+
+    /**
+     * Release the oldest held event that is due
+     *
+     * @param msg Set to the released event
+     * @param batch_end true if the current handle_events call is finishing, so
+     *   events held under CoalesceMode::LATEST are due
+     *
+     * @return true if an event was released
+     */
+    bool release(EventMessage &msg, bool batch_end);
+
+    /**
+     * Get the number of milliseconds until a held event becomes due
+     *
+     * @return The time in milliseconds, 0 if an event is already due, or -1
+     *   if no event is held
+     */
+    int get_timeout_ms() const;
+
+    /**
+     * Get the number of events held
+     */
+    size_t size() const;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Held {
+        uint64_t key;
+        bool at_batch_end; ///< Held under CoalesceMode::LATEST
+        Clock::time_point deadline;
+        EventMessage msg;
+    };
+
+    CoalescePolicy policies[6];
+    std::vector<Held> held;
+
+    static uint64_t key_of(const EventMessage &msg);
+    static void merge(EventMessage &into, const EventMessage &msg);
+};
+
+} // namespace dwmipc
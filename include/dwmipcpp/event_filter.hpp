@@ -0,0 +1,62 @@
+/**
+ * @file event_filter.hpp
+ *
+ * This file contains the declaration of the EventFilter struct which selects
+ * the events a Connection dispatches.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "types.hpp"
+
+namespace dwmipc {
+/**
+ * Selects which received events are dispatched. Events are checked by
+ * scanning their raw payload in the receive buffer, so rejected events are
+ * dropped without being copied, parsed or allocating any memory. The default
+ * filter accepts every event.
+ */
+struct EventFilter {
+    /**
+     * Bitmask of the Event types to accept
+     */
+    uint8_t events = 0xff;
+
+    /**
+     * Only accept events about the monitor specified by monitor_num. Events
+     * that do not refer to a monitor are not affected. A monitor focus change
+     * is accepted if either its old or new monitor matches.
+     */
+    bool match_monitor = false;
+    unsigned int monitor_num = 0; ///< Monitor to accept if match_monitor
+
+    /**
+     * Only accept events about the window specified by window_id. Events that
+     * do not refer to a window are not affected. A client focus change is
+     * accepted if either its old or new window matches.
+     */
+    bool match_window = false;
+    Window window_id = 0; ///< Window to accept if match_window
+
+    /**
+     * Check if an event passes the filter. Payloads that cannot be scanned
+     * are accepted, so that decoding them reports the error.
+     *
+     * @param payload Pointer to the start of the event payload
+     * @param size Size of the payload as specified in the packet header
+     *
+     * @return true if the event should be dispatched
+     */
+    bool accepts(const char *payload, uint32_t size) const;
+
+    /**
+     * Check if the filter accepts every event without looking at it
+     */
+    bool accepts_all() const {
+        return events == 0xff && !match_monitor && !match_window;
+    }
+};
+
+} // namespace dwmipc
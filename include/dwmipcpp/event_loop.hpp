@@ -0,0 +1,201 @@
+/**
+ * @file event_loop.hpp
+ *
+ * This file contains the declarations for the EventLoop class which waits on
+ * a Connection's event socket, user timers, and user file descriptors.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sys/epoll.h>
+#include <unordered_map>
+
+#include "connection.hpp"
+#include "errors.hpp"
+
+namespace dwmipc {
+/**
+ * An epoll based event loop that dispatches DWM events as soon as they arrive.
+ * The loop sleeps in the kernel while there is nothing to do, so an idle
+ * process with no timers registered is never woken up.
+ *
+ * If the event socket is closed, the loop keeps trying to reconnect on a timer
+ * and registers the new socket once the connection is re-established. The
+ * loop turns off the connection's blocking event socket reconnection, so it
+ * keeps running timers and user file descriptors while DWM is down.
+ *
+ * If the connection receives events on its background event thread, the loop
+ * waits on Connection::get_event_wait_fd instead of the event socket.
+ */
+class EventLoop {
+  public:
+    /**
+     * Identifier returned by add_timer, used to remove the timer. Ids are
+     * never reused, so an id kept after its timer was removed cannot refer to
+     * a newer timer.
+     */
+    typedef uint64_t TimerId;
+
+    /**
+     * Construct an EventLoop for the specified connection. The event socket
+     * is registered when the loop starts running.
+     *
+     * @param connection The connection whose events will be handled. It must
+     *   outlive the EventLoop.
+     *
+     * @throw ErrnoError if the epoll instance could not be created
+     */
+    EventLoop(Connection &connection);
+
+    /**
+     * Destroy the EventLoop and close all timers. User file descriptors are
+     * not closed. The connection's blocking event socket reconnection is
+     * restored.
+     */
+    ~EventLoop();
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    /**
+     * Add a timer to the loop
+     *
+     * @param interval_ms The number of milliseconds until the timer fires
+     * @param callback The function to call when the timer fires
+     * @param repeat If true, the timer fires every interval_ms until it is
+     *   removed. Otherwise it is removed after firing once.
+     *
+     * @return The id of the timer
+     *
+     * @throw ErrnoError if the timer could not be created
+     */
+    TimerId add_timer(const unsigned int interval_ms,
+                      const std::function<void()> &callback,
+                      const bool repeat = true);
+
+    /**
+     * Remove a timer from the loop. Removing a timer that has already been
+     * removed has no effect.
+     *
+     * @param id The id of the timer returned by add_timer
+     */
+    void remove_timer(const TimerId id);
+
+    /**
+     * Watch a user file descriptor
+     *
+     * @param fd The file descriptor to watch
+     * @param callback The function to call when the file descriptor is ready.
+     *   It is passed the ready epoll events.
+     * @param events The epoll events to wait for
+     *
+     * @throw ErrnoError if the file descriptor could not be watched
+     */
+    void add_fd(const int fd, const std::function<void(uint32_t)> &callback,
+                const uint32_t events = EPOLLIN);
+
+    /**
+     * Stop watching a user file descriptor. The file descriptor is not closed.
+     *
+     * @param fd The file descriptor to stop watching
+     */
+    void remove_fd(const int fd);
+
+    /**
+     * Run the loop until stop is called
+     */
+    void run();
+
+    /**
+     * Wait for and dispatch one round of ready sources
+     *
+     * @param timeout_ms The maximum number of milliseconds to wait, -1 to
+     *   wait indefinitely
+     *
+     * @return The number of sources that were ready
+     */
+    int run_once(const int timeout_ms = -1);
+
+    /**
+     * Make run return after the current round of sources has been
+     * dispatched. This may be called from another thread or from a callback.
+     */
+    void stop();
+
+    /**
+     * The number of milliseconds to wait between attempts to reconnect the
+     * event socket
+     */
+    unsigned int reconnect_interval_ms = 500;
+
+    /**
+     * Called with errors other than SocketClosedError thrown while handling
+     * events. If this is not set, the error is rethrown from run or run_once.
+     */
+    std::function<void(const IPCError &err)> on_error;
+
+  private:
+    /**
+     * Something the loop waits on
+     */
+    struct Source {
+        enum class Kind { EVENT_SOCKET, TIMER, USER_FD, WAKE, RECONNECT };
+
+        Kind kind;                              ///< What the fd belongs to
+        std::function<void(uint32_t)> callback; ///< Called for user sources
+        bool repeat;                            ///< For timers, fire again
+        TimerId timer_id;                       ///< For timers, their id
+    };
+
+    Connection &connection;            ///< The connection whose events are
+                                       ///< handled
+    int epoll_fd = -1;                 ///< The epoll instance
+    int wake_fd = -1;                  ///< eventfd used to interrupt epoll_wait
+    int reconnect_fd = -1;             ///< timerfd armed while the socket is
+                                       ///< closed
+    bool reconnect_armed = false;      ///< Is reconnect_fd armed
+    int event_fd = -1;                 ///< Registered event fd, -1 if none
+    bool reconnect_blocking;           ///< The connection's setting before
+    unsigned int event_generation = 0; ///< Generation of event_fd
+    std::atomic<bool> running{false};  ///< Should run keep looping
+
+    /**
+     * Registered sources keyed by file descriptor. Sources are held by
+     * shared_ptr so that a callback can remove its own source safely.
+     */
+    std::unordered_map<int, std::shared_ptr<Source>> sources;
+
+    std::unordered_map<TimerId, int> timers; ///< Timer fds keyed by timer id
+    TimerId next_timer_id = 1;               ///< Id of the next added timer
+
+    void watch(const int fd, const uint32_t events,
+               const std::shared_ptr<Source> &source);
+    void unwatch(const int fd);
+
+    /**
+     * Register the connection's event socket, or start trying to reconnect if
+     * it is disconnected.
+     */
+    void register_event_socket();
+
+    /**
+     * Handle all events queued on the event socket
+     */
+    void handle_events();
+
+    /**
+     * Try to reconnect the event socket
+     */
+    void try_reconnect();
+
+    /**
+     * Arm or disarm the reconnect timer
+     */
+    void set_reconnect_timer(const bool armed);
+};
+
+} // namespace dwmipc
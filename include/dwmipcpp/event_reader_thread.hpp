@@ -0,0 +1,209 @@
+/**
+ * @file event_reader_thread.hpp
+ *
+ * This file contains the declarations for the EventReaderThread class which
+ * receives and decodes event messages on a background thread. This file is
+ * used internally by dwmipcpp.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "decoder.hpp"
+#include "event_filter.hpp"
+#include "frame_reader.hpp"
+#include "spsc_ring.hpp"
+#include "traffic_log.hpp"
+
+namespace dwmipc {
+/**
+ * Counters describing how an event reader thread keeps up with the events
+ */
+struct EventThreadStats {
+    size_t received; ///< Events received by the thread, including dropped
+    size_t stalls;   ///< Times the thread waited because the queue was full
+    size_t queued;   ///< Events waiting to be handled
+    size_t capacity; ///< The most events that can wait to be handled
+};
+
+/**
+ * A background thread that reads event messages from the event socket,
+ * decodes them, and publishes them into a bounded SpscRing for the thread
+ * calling Connection::handle_events. Events rejected by the connection's
+ * EventFilter are dropped before they are decoded or copied, as they are
+ * without the thread. If the ring is full, the thread stops
+ * reading until a slot is handed back, so the socket buffer only fills up
+ * once the ring has.
+ *
+ * The thread stops when the socket is lost or a malformed message is read.
+ * The consumer finds out through lost and error once it has handled the
+ * events queued before that.
+ */
+class EventReaderThread {
+  public:
+    /**
+     * A received event, in the form it is queued in
+     */
+    struct Slot {
+        uint8_t type;        ///< The message type of the packet
+        bool decoded;        ///< msg holds the decoded event
+        EventMessage msg;    ///< The decoded event
+        std::string payload; ///< The payload, including the null terminator
+    };
+
+    EventReaderThread() = default;
+    EventReaderThread(const EventReaderThread &) = delete;
+    EventReaderThread &operator=(const EventReaderThread &) = delete;
+
+    /**
+     * Stop the thread and close its file descriptors
+     */
+    ~EventReaderThread();
+
+    /**
+     * Allocate the queue and the file descriptors used to signal the threads.
+     * This must be called before start. The queue is only replaced if it is
+     * empty, and the file descriptors are only created once.
+     *
+     * @param capacity The number of events the queue can hold
+     *
+     * @throw ErrnoError if the file descriptors could not be created
+     */
+    void init(size_t capacity);
+
+    /**
+     * Start reading events. The socket and reader must not be used by any
+     * other thread until stop is called.
+     *
+     * @param sockfd The non-blocking event socket
+     * @param reader The buffer for bytes read from the socket. Any bytes
+     *   already in it are read first, and bytes not yet published are left in
+     *   it when the thread stops.
+     * @param decoder The decoder to decode events with
+     * @param filter The events to publish. It is copied, so the thread must
+     *   be restarted for a change to take effect.
+     * @param recorder Where to record the received messages, or nullptr. It
+     *   must outlive the thread.
+     */
+    void start(int sockfd, FrameReader &reader, Decoder decoder,
+               const EventFilter &filter, TrafficRecorder *recorder = nullptr);
+
+    /**
+     * Stop the thread and wait for it to exit. Events already queued are
+     * kept.
+     */
+    void stop();
+
+    /**
+     * Check if the thread was started and not stopped since. The thread may
+     * already have exited because the socket was lost.
+     */
+    bool running() const { return this->thread.joinable(); }
+
+    /**
+     * Check if the thread exited because the socket was closed
+     */
+    bool lost() const;
+
+    /**
+     * Get the error that made the thread exit, other than the socket being
+     * closed, or nullptr if there was none
+     */
+    std::exception_ptr error() const;
+
+    /**
+     * Get the file descriptor that becomes readable when events are queued or
+     * the thread exits
+     */
+    int notify_fd() const { return this->notify; }
+
+    /**
+     * Reset the notify file descriptor. This should be done before handling
+     * the queued events, so that events queued afterwards wake the consumer
+     * again.
+     */
+    void clear_notify();
+
+    /**
+     * Get the oldest queued event
+     *
+     * @return The event, or nullptr if no event is queued
+     */
+    Slot *front() { return this->ring ? this->ring->read_slot() : nullptr; }
+
+    /**
+     * Remove the event returned by front, waking the thread if it is waiting
+     * for room in the queue
+     */
+    void pop();
+
+    /**
+     * Check if no event is queued
+     */
+    bool empty() const { return !this->ring || this->ring->empty(); }
+
+    /**
+     * Get the number of queued events
+     */
+    size_t size() const { return this->ring ? this->ring->size() : 0; }
+
+    /**
+     * Get the counters of the thread
+     */
+    EventThreadStats get_stats() const;
+
+  private:
+    std::unique_ptr<SpscRing<Slot>> ring;
+    std::thread thread;
+
+    int notify = -1; ///< eventfd signalled by the thread
+    int wake = -1;   ///< eventfd signalled to the thread to stop or go on
+
+    std::atomic<bool> stopping{false}; ///< The thread should exit
+    std::atomic<bool> waiting{false};  ///< The thread is waiting for room
+    std::atomic<bool> finished{false}; ///< The thread exited by itself
+    bool socket_lost = false;          ///< Read once finished is set
+    std::exception_ptr failure;        ///< Read once finished is set
+
+    EventFilter filter; ///< Only written while the thread is stopped
+    TrafficRecorder *recorder = nullptr;
+    TrafficRecorder::Clock::time_point filled; ///< When the last read returned
+
+    std::atomic<size_t> received{0};
+    std::atomic<size_t> stalls{0};
+
+    /**
+     * The thread's main loop
+     */
+    void run(int sockfd, FrameReader &reader, Decoder decoder);
+
+    /**
+     * Publish every complete frame in reader, waiting for room in the ring if
+     * needed
+     *
+     * @return false if the thread should stop
+     */
+    bool publish(FrameReader &reader, Decoder decoder);
+
+    /**
+     * Wait until the wake file descriptor is signalled
+     *
+     * @param sockfd Also return when this socket is readable, -1 to only wait
+     *   for the wake file descriptor
+     */
+    void wait(int sockfd);
+
+    /**
+     * Signal an eventfd
+     */
+    static void signal(int fd);
+};
+
+} // namespace dwmipc
@@ -0,0 +1,154 @@
+/**
+ * @file event_view.hpp
+ *
+ * This file contains the declarations for the lazy event views, which decode
+ * the fields of an event message on demand straight from the receive buffer.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "types.hpp"
+
+namespace dwmipc {
+class JsonScanner;
+
+/**
+ * A non-owning reference to a string. The referenced characters are not null
+ * terminated.
+ */
+struct StringRef {
+    const char *data = nullptr; ///< Pointer to the first character
+    size_t size = 0;            ///< Number of characters
+
+    /**
+     * Copy the referenced characters into a std::string
+     */
+    std::string str() const { return std::string(data, size); }
+
+    bool empty() const { return size == 0; }
+
+    bool operator==(const char *other) const {
+        return std::strlen(other) == size &&
+               std::memcmp(data, other, size) == 0;
+    }
+
+    bool operator==(const std::string &other) const {
+        return other.size() == size &&
+               std::memcmp(data, other.data(), size) == 0;
+    }
+
+    bool operator!=(const char *other) const { return !(*this == other); }
+
+    bool operator!=(const std::string &other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * Base class of the event views. A view refers to the body of an event message
+ * in the receive buffer, and each accessor scans the body for its field when
+ * called. A handler that reads one field only pays for that field. Views and
+ * the StringRefs they return are only valid during the handler call they are
+ * passed to. Fields missing from the message are returned as 0 or an empty
+ * string.
+ */
+class EventView {
+  public:
+    /**
+     * Get the type of the event
+     */
+    Event type() const { return this->ev; }
+
+    /**
+     * Get the raw JSON of the event body
+     */
+    StringRef raw() const;
+
+    /**
+     * Point the view at a new event body. This is used internally when
+     * dispatching events.
+     *
+     * @param ev The type of the event
+     * @param body Pointer to the start of the event body
+     * @param end Pointer one past the end of the payload
+     */
+    void reset(Event ev, const char *body, const char *end);
+
+  protected:
+    /**
+     * Position a scanner at the value of the specified key of the body
+     *
+     * @return true if the key was found
+     */
+    bool find(const char *key, size_t len, JsonScanner &s) const;
+
+    /**
+     * Get an unsigned integer field, or 0 if it is missing or malformed
+     */
+    uint64_t get_uint(const char *key, size_t len) const;
+
+    /**
+     * Get a string field. Strings without escape sequences are referenced in
+     * place. Strings with escape sequences are unescaped into scratch, whose
+     * capacity is kept for later events.
+     */
+    StringRef get_string(const char *key, size_t len,
+                         std::string &scratch) const;
+
+  private:
+    Event ev = Event::TAG_CHANGE;
+    const char *body = nullptr;
+    const char *end = nullptr;
+};
+
+/**
+ * A lazily decoded Event::FOCUSED_TITLE_CHANGE event. See
+ * FocusedTitleChangeEvent.
+ */
+class FocusedTitleChangeView : public EventView {
+  public:
+    unsigned int monitor_num() const;
+    Window client_window_id() const;
+    StringRef old_name() const;
+    StringRef new_name() const;
+
+  private:
+    mutable std::string old_scratch;
+    mutable std::string new_scratch;
+};
+
+/**
+ * A lazily decoded Event::LAYOUT_CHANGE event. See LayoutChangeEvent.
+ */
+class LayoutChangeView : public EventView {
+  public:
+    unsigned int monitor_num() const;
+    StringRef old_symbol() const;
+    uintptr_t old_address() const;
+    StringRef new_symbol() const;
+    uintptr_t new_address() const;
+
+  private:
+    mutable std::string old_scratch;
+    mutable std::string new_scratch;
+};
+
+/**
+ * Find the type and body of an event message without decoding it
+ *
+ * @param payload Pointer to the start of the event payload
+ * @param size Size of the payload as specified in the packet header
+ * @param ev Set to the type of the event
+ * @param body Set to the start of the event body
+ *
+ * @return true if the payload starts with a known event name
+ */
+bool locate_event(const char *payload, uint32_t size, Event &ev,
+                  const char *&body);
+
+} // namespace dwmipc
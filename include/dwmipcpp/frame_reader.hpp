@@ -0,0 +1,98 @@
+/**
+ * @file frame_reader.hpp
+ *
+ * This file contains the declarations for the FrameReader class which buffers
+ * the bytes received on a socket and splits them into packets. This file is
+ * used internally by dwmipcpp.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dwmipc {
+/**
+ * A complete packet held in a FrameReader's buffer. The payload pointer is
+ * only valid until the next call to FrameReader::fill or FrameReader::clear.
+ */
+struct Frame {
+    uint8_t type;  ///< Type of message as specified in the header
+    uint32_t size; ///< Size of the payload as specified in the header
+    char *payload; ///< Pointer to the start of the payload
+};
+
+/**
+ * This class reads as many bytes as are available from a socket in one
+ * syscall and hands out the complete packets contained in them. Bytes
+ * belonging to a packet that has not been fully received are kept for the
+ * next fill.
+ */
+class FrameReader {
+  public:
+    /**
+     * Default size of the receive buffer in bytes
+     */
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    /**
+     * Construct a FrameReader with the specified receive buffer size
+     *
+     * @param capacity The initial size of the receive buffer. The buffer only
+     *   grows if a single packet does not fit in it.
+     */
+    FrameReader(const size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * Read as many bytes as are available from the specified socket into the
+     * buffer. At most one read is made, unless it is interrupted.
+     *
+     * @param fd The file descriptor of a non-blocking socket to read from
+     * @param drained Set to true if the socket is known to have no more bytes
+     *   available after this call
+     *
+     * @return The number of bytes read. 0 if no bytes were available.
+     *
+     * @throw SocketClosedError if the socket is closed
+     * @throw ErrnoError if the read fails
+     */
+    size_t fill(int fd, bool &drained);
+
+    /**
+     * Extract the next complete packet from the buffer
+     *
+     * @param frame Set to the extracted packet
+     *
+     * @return true if a packet was extracted, false if the buffer does not
+     *   contain a complete packet
+     *
+     * @throw HeaderError if the buffered packet has an invalid magic string.
+     *   The buffer is cleared before throwing.
+     */
+    bool next(Frame &frame);
+
+    /**
+     * Discard any buffered bytes. This should be called when the socket is
+     * disconnected or reconnected.
+     */
+    void clear();
+
+    /**
+     * Get the number of buffered bytes that have not been extracted yet
+     */
+    size_t buffered() const { return this->end - this->start; }
+
+  private:
+    std::vector<char> buf; ///< The receive buffer
+    size_t start = 0;      ///< Offset of the first unextracted byte
+    size_t end = 0;        ///< Offset one past the last received byte
+
+    /**
+     * Make room at the end of the buffer by moving unextracted bytes to the
+     * front, and grow the buffer if the packet at the front does not fit.
+     */
+    void make_room();
+};
+
+} // namespace dwmipc
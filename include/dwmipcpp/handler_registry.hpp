@@ -0,0 +1,297 @@
+/**
+ * @file handler_registry.hpp
+ *
+ * This file contains the declarations for the HandlerRegistry class which
+ * lets any number of event handlers be registered with a Connection.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "decoder.hpp"
+#include "event_view.hpp"
+#include "small_function.hpp"
+#include "types.hpp"
+
+namespace dwmipc {
+/**
+ * Identifies a handler registered with a HandlerRegistry so that it can be
+ * removed later
+ */
+struct HandlerToken {
+    Event event = Event::TAG_CHANGE; ///< The event the handler was added for
+    uint64_t id = 0;                 ///< Unique id of the handler, 0 if none
+
+    /**
+     * Check if the token refers to a handler
+     */
+    bool valid() const { return id != 0; }
+};
+
+/**
+ * The handlers registered for one type of event, called in the order they
+ * were added. Handlers are kept in a contiguous array. Handlers may add or
+ * remove handlers, including themselves, while being called: removed handlers
+ * are not called again, and added handlers are first called for the next
+ * event.
+ *
+ * @tparam T The event struct passed to the handlers
+ */
+template <typename T> class HandlerList {
+  public:
+    /**
+     * The type used to store the handlers
+     */
+    typedef SmallFunction<void(const T &ev)> Handler;
+
+    /**
+     * Add a handler with the specified id
+     */
+    void add(const uint64_t id, Handler &&handler) {
+        Entry entry;
+        entry.id = id;
+        entry.handler = std::move(handler);
+
+        // Adding to entries could move the handler that is running
+        if (dispatching > 0)
+            added.push_back(std::move(entry));
+        else
+            entries.push_back(std::move(entry));
+    }
+
+    /**
+     * Remove the handler with the specified id
+     *
+     * @return true if the handler was found
+     */
+    bool remove(const uint64_t id) {
+        for (auto it = added.begin(); it != added.end(); ++it) {
+            if (it->id == id) {
+                added.erase(it);
+                return true;
+            }
+        }
+
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->id != id)
+                continue;
+
+            if (dispatching > 0) {
+                // The handler may be the one running, so only mark it and
+                // destroy it once dispatching has finished
+                it->id = 0;
+                has_removed = true;
+            } else {
+                entries.erase(it);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Call every handler with the specified event
+     */
+    void dispatch(const T &ev) {
+        DispatchGuard guard(*this);
+
+        const size_t count = entries.size();
+        for (size_t i = 0; i < count; i++)
+            if (entries[i].id != 0)
+                entries[i].handler(ev);
+    }
+
+    /**
+     * Get the number of registered handlers
+     */
+    size_t size() const {
+        size_t n = added.size();
+        for (const auto &entry : entries)
+            n += entry.id != 0;
+        return n;
+    }
+
+  private:
+    struct Entry {
+        uint64_t id;
+        Handler handler;
+    };
+
+    /**
+     * Tracks nested dispatches and applies deferred changes once the
+     * outermost one finishes, even if a handler throws
+     */
+    struct DispatchGuard {
+        HandlerList &list;
+
+        DispatchGuard(HandlerList &list) : list(list) { list.dispatching++; }
+
+        ~DispatchGuard() {
+            if (--list.dispatching == 0)
+                list.apply_deferred();
+        }
+    };
+
+    std::vector<Entry> entries;
+    std::vector<Entry> added; ///< Handlers added while dispatching
+    size_t dispatching = 0;   ///< Depth of nested dispatch calls
+    bool has_removed = false; ///< Some entries were removed while dispatching
+
+    void apply_deferred() {
+        if (has_removed) {
+            entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                         [](const Entry &entry) {
+                                             return entry.id == 0;
+                                         }),
+                          entries.end());
+            has_removed = false;
+        }
+
+        for (auto &entry : added)
+            entries.push_back(std::move(entry));
+        added.clear();
+    }
+};
+
+/**
+ * A set of handlers for every type of event. Any number of handlers can be
+ * added for each event, and each one is stored without allocating as long as
+ * its captures fit in a SmallFunction. The registry is not thread safe: it
+ * must only be used from the thread that handles events.
+ *
+ * Handlers for focused title and layout changes can take a lazy view
+ * (FocusedTitleChangeView or LayoutChangeView) instead of the decoded event.
+ * View handlers are called after the other handlers of the event. If an event
+ * only has view handlers, it is never fully decoded. Events passed to view
+ * handlers are not coalesced.
+ */
+class HandlerRegistry {
+  public:
+    /**
+     * Add a handler for the event described by T, e.g.
+     * add<TagChangeEvent>([](const TagChangeEvent &ev) { ... })
+     *
+     * @param handler A callable taking a const T &. T is an event struct or
+     *   one of the event views.
+     *
+     * @return A token that can be passed to remove
+     */
+    template <typename T, typename F> HandlerToken add(F &&handler) {
+        HandlerToken token;
+        token.event = event_of(static_cast<T *>(nullptr));
+        token.id = ++last_id;
+        list(static_cast<T *>(nullptr))
+            .add(token.id,
+                 typename HandlerList<T>::Handler(std::forward<F>(handler)));
+        return token;
+    }
+
+    /**
+     * Remove a handler. It is safe to call this from a handler, including the
+     * handler being removed.
+     *
+     * @param token The token returned when the handler was added. It is reset
+     *   so it no longer refers to a handler.
+     *
+     * @return true if the handler was registered
+     */
+    bool remove(HandlerToken &token);
+
+    /**
+     * Get the number of handlers registered for an event, including view
+     * handlers
+     */
+    size_t count(Event ev) const;
+
+    /**
+     * Check if any handler taking the decoded event struct is registered for
+     * an event
+     */
+    bool has_event_handlers(Event ev) const;
+
+    /**
+     * Check if any view handler is registered for an event
+     */
+    bool has_view_handlers(Event ev) const;
+
+    /**
+     * Call every handler registered for the type of the specified event,
+     * except the view handlers
+     */
+    void dispatch(const EventMessage &msg);
+
+    /**
+     * Call every view handler registered for an event
+     *
+     * @param ev The type of the event
+     * @param body Pointer to the start of the event body in the payload
+     * @param end Pointer one past the end of the payload
+     */
+    void dispatch_view(Event ev, const char *body, const char *end);
+
+  private:
+    uint64_t last_id = 0;
+
+    HandlerList<TagChangeEvent> tag_change;
+    HandlerList<ClientFocusChangeEvent> client_focus_change;
+    HandlerList<LayoutChangeEvent> layout_change;
+    HandlerList<MonitorFocusChangeEvent> monitor_focus_change;
+    HandlerList<FocusedTitleChangeEvent> focused_title_change;
+    HandlerList<FocusedStateChangeEvent> focused_state_change;
+    HandlerList<FocusedTitleChangeView> focused_title_change_view;
+    HandlerList<LayoutChangeView> layout_change_view;
+
+    // Reused for every event so their scratch strings keep their capacity
+    FocusedTitleChangeView title_view;
+    LayoutChangeView layout_view;
+
+    // Overloads used by add to find the list and event for an event struct
+    HandlerList<TagChangeEvent> &list(TagChangeEvent *) { return tag_change; }
+    HandlerList<ClientFocusChangeEvent> &list(ClientFocusChangeEvent *) {
+        return client_focus_change;
+    }
+    HandlerList<LayoutChangeEvent> &list(LayoutChangeEvent *) {
+        return layout_change;
+    }
+    HandlerList<MonitorFocusChangeEvent> &list(MonitorFocusChangeEvent *) {
+        return monitor_focus_change;
+    }
+    HandlerList<FocusedTitleChangeEvent> &list(FocusedTitleChangeEvent *) {
+        return focused_title_change;
+    }
+    HandlerList<FocusedStateChangeEvent> &list(FocusedStateChangeEvent *) {
+        return focused_state_change;
+    }
+    HandlerList<FocusedTitleChangeView> &list(FocusedTitleChangeView *) {
+        return focused_title_change_view;
+    }
+    HandlerList<LayoutChangeView> &list(LayoutChangeView *) {
+        return layout_change_view;
+    }
+
+    static Event event_of(TagChangeEvent *) { return Event::TAG_CHANGE; }
+    static Event event_of(ClientFocusChangeEvent *) {
+        return Event::CLIENT_FOCUS_CHANGE;
+    }
+    static Event event_of(LayoutChangeEvent *) { return Event::LAYOUT_CHANGE; }
+    static Event event_of(MonitorFocusChangeEvent *) {
+        return Event::MONITOR_FOCUS_CHANGE;
+    }
+    static Event event_of(FocusedTitleChangeEvent *) {
+        return Event::FOCUSED_TITLE_CHANGE;
+    }
+    static Event event_of(FocusedStateChangeEvent *) {
+        return Event::FOCUSED_STATE_CHANGE;
+    }
+    static Event event_of(FocusedTitleChangeView *) {
+        return Event::FOCUSED_TITLE_CHANGE;
+    }
+    static Event event_of(LayoutChangeView *) { return Event::LAYOUT_CHANGE; }
+};
+
+} // namespace dwmipc
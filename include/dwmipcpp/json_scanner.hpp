@@ -0,0 +1,165 @@
+/**
+ * @file json_scanner.hpp
+ *
+ * This file contains the declarations for the JsonScanner class, a minimal
+ * pull-style JSON reader. This file is used internally by dwmipcpp to decode
+ * DWM's messages without building a Json::Value tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace dwmipc {
+/**
+ * A forward-only JSON reader that walks a buffer in place. The scanner never
+ * allocates memory itself; the only allocations happen when a string value is
+ * copied into a caller supplied std::string that is too small to hold it.
+ *
+ * Every method returns false if the expected token was not found. Once an
+ * error is encountered, failed() will return true and every subsequent call
+ * will return false. Reaching the end of an object or array also returns false
+ * from next_key() or next_element(), so failed() must be checked to tell the
+ * two cases apart.
+ */
+class JsonScanner {
+  public:
+    /**
+     * Construct a scanner over the specified buffer
+     *
+     * @param begin Pointer to the first character of the JSON document
+     * @param end Pointer one past the last character of the JSON document
+     */
+    JsonScanner(const char *begin, const char *end);
+
+    /**
+     * Consume the opening brace of an object
+     */
+    bool begin_object();
+
+    /**
+     * Consume the opening bracket of an array
+     */
+    bool begin_array();
+
+    /**
+     * Advance to the next key of the current object and consume the colon
+     * following it. The returned key points into the scanned buffer and is
+     * not unescaped.
+     *
+     * @param key Set to the first character of the key
+     * @param len Set to the length of the key
+     *
+     * @return true if a key was read, false if the end of the object was
+     *   reached (and consumed) or on error
+     */
+    bool next_key(const char *&key, size_t &len);
+
+    /**
+     * Advance to the next element of the current array.
+     *
+     * @return true if there is another element to read, false if the end of
+     *   the array was reached (and consumed) or on error
+     */
+    bool next_element();
+
+    /**
+     * Read an unsigned integer value. Fractional values are truncated.
+     */
+    bool read_uint(uint64_t &value);
+
+    /**
+     * Read a signed integer value. Fractional values are truncated.
+     */
+    bool read_int(int64_t &value);
+
+    /**
+     * Read a number as a double. The conversion does not depend on the
+     * current locale.
+     */
+    bool read_double(double &value);
+
+    /**
+     * Read a boolean value
+     */
+    bool read_bool(bool &value);
+
+    /**
+     * Read a string value, unescaping it into the specified string. The
+     * capacity of the string is reused.
+     */
+    bool read_string(std::string &value);
+
+    /**
+     * Read a string value without unescaping it.
+     *
+     * @param str Set to the first character after the opening quote
+     * @param len Set to the length of the raw string
+     * @param escaped Set to true if the raw string contains escape sequences
+     */
+    bool read_raw_string(const char *&str, size_t &len, bool &escaped);
+
+    /**
+     * Skip over the next value including any nested objects or arrays
+     */
+    bool skip_value();
+
+    /**
+     * Check if the scanner encountered malformed or unexpected input
+     */
+    bool failed() const { return this->error; }
+
+    /**
+     * Get the current position of the scanner in the buffer
+     */
+    const char *position() const { return this->cur; }
+
+    /**
+     * Unescape a raw JSON string into the specified buffer. The output is
+     * never longer than the input, so the output buffer may be the input
+     * buffer itself.
+     *
+     * @param str The raw string without its quotes
+     * @param len The length of the raw string
+     * @param out The buffer to write the unescaped string to
+     *
+     * @return The length of the unescaped string, or -1 if the string contains
+     *   an invalid escape sequence
+     */
+    static long unescape(const char *str, size_t len, char *out);
+
+    /**
+     * Compare a key returned by next_key() to a string literal
+     */
+    template <size_t N>
+    static bool key_is(const char *key, size_t len, const char (&lit)[N]) {
+        return len == N - 1 && std::memcmp(key, lit, N - 1) == 0;
+    }
+
+  private:
+    /**
+     * A parsed JSON number split into its components
+     */
+    struct Number {
+        bool negative;    ///< Was the number prefixed with a minus sign
+        uint64_t digits;  ///< Significant digits of the number
+        int exponent;     ///< Base 10 exponent to apply to digits
+        bool is_integral; ///< Did the number have no fraction or exponent
+    };
+
+    const char *cur;  ///< Current position in the buffer
+    const char *end;  ///< End of the buffer
+    bool error;       ///< Has an error been encountered
+    unsigned depth;   ///< Current nesting depth while skipping values
+
+    void skip_ws();
+    bool consume(char c);
+    bool fail();
+    bool read_number(Number &num);
+    bool skip_literal(const char *lit, size_t len);
+};
+
+} // namespace dwmipc
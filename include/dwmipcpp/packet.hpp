@@ -14,6 +14,15 @@
 #include "types.hpp"
 
 namespace dwmipc {
+/**
+ * A read-only reference to the bytes of a complete packet, header included
+ */
+struct PacketView {
+    const uint8_t *data; ///< Pointer to the start of the packet
+    uint32_t size;       ///< Size of the entire packet including the header
+    uint8_t type;        ///< Type of message, as specified in the header
+};
+
 /**
  * This class defines the structure of a basic message that can be sent to DWM
  * or received by DWM. The data allocated by this packet should not be
@@ -58,16 +67,50 @@ class Packet {
      */
     static constexpr int HEADER_SIZE = sizeof(Header);
 
-    uint8_t *data;  ///< Pointer to the start of the packet
-    Header *header; ///< Pointer to the start of the header
-    uint32_t size;  ///< Size of the entire packet including the header
-    char *payload;  ///< Pointer to the start of the payload
+    uint8_t *data;     ///< Pointer to the start of the packet
+    Header *header;    ///< Pointer to the start of the header
+    uint32_t size;     ///< Size of the entire packet including the header
+    char *payload;     ///< Pointer to the start of the payload
+    uint32_t capacity; ///< Size of the allocated payload buffer
 
     /**
      * Reallocate memory for the packet based on the size specified in the
-     * header.
+     * header. The buffer is only reallocated if it is too small.
      */
     void realloc_to_header_size();
+
+    /**
+     * Get a view of the packet for sending. The view is invalidated if the
+     * packet is modified or destroyed.
+     */
+    PacketView view() const { return {data, size, header->type}; }
+
+    /**
+     * Make sure the payload buffer can hold at least the specified number of
+     * bytes. The contents of the packet are preserved.
+     *
+     * @param payload_size The required payload capacity
+     */
+    void reserve(uint32_t payload_size);
+
+    /**
+     * Replace the contents of the packet with a new message, reusing the
+     * allocated buffer if it is large enough
+     *
+     * @param type The type of message to send
+     * @param msg The payload of the packet
+     */
+    void assign(MessageType type, const std::string &msg);
+
+    /**
+     * Replace the contents of the packet with a copy of a received payload,
+     * reusing the allocated buffer if it is large enough
+     *
+     * @param type The type of the message as specified in its header
+     * @param payload Pointer to the start of the payload
+     * @param payload_size Size of the payload including the terminating null
+     */
+    void assign(uint8_t type, const char *payload, uint32_t payload_size);
 };
 
 } // namespace dwmipc
@@ -0,0 +1,105 @@
+/**
+ * @file packet_pool.hpp
+ *
+ * This file contains the declarations for the PacketPool class. This file is
+ * used internally by dwmipcpp.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "packet.hpp"
+
+namespace dwmipc {
+/**
+ * Counters describing how well a PacketPool is reusing its packets
+ */
+struct PacketPoolStats {
+    size_t hits;   ///< Packets handed out by reusing a pooled packet
+    size_t misses; ///< Packets that had to be newly allocated, including
+                   ///< pooled packets replaced for being oversize
+    size_t grows;  ///< Reused packets whose buffer had to be enlarged
+    size_t pooled; ///< Packets currently owned by the pool
+
+    /**
+     * Fraction of packets handed out without allocating a new packet
+     */
+    double hit_rate() const {
+        const size_t total = hits + misses;
+        return total == 0 ? 0 : static_cast<double>(hits) / total;
+    }
+};
+
+/**
+ * A pool of packets that are reused for successive messages. A packet is
+ * returned to the pool as soon as every shared_ptr handed out for it is
+ * destroyed, so no custom deleter or extra allocation is needed. New packets
+ * are sized for a typical message, a running average of the messages seen so
+ * far, and a reused packet only grows to fit the message it holds. An
+ * occasional large reply therefore doesn't make every packet large. The pool
+ * is thread safe.
+ */
+class PacketPool {
+  public:
+    /**
+     * The maximum number of packets kept by default. This is enough for two
+     * full pipelines of requests and their replies.
+     */
+    static constexpr size_t DEFAULT_MAX_PACKETS = 256;
+
+    /**
+     * Packets with a larger buffer than this are not kept, so one unusually
+     * large reply does not pin memory for the rest of the connection
+     */
+    static constexpr uint32_t MAX_POOLED_CAPACITY = 1024 * 1024;
+
+    /**
+     * Construct an empty pool
+     *
+     * @param max_packets The maximum number of packets to keep for reuse
+     */
+    PacketPool(size_t max_packets = DEFAULT_MAX_PACKETS);
+
+    /**
+     * Get a packet to receive a message into. A new packet has room for a
+     * typical message; a reused one keeps its buffer as is.
+     */
+    std::shared_ptr<Packet> acquire();
+
+    /**
+     * Get a packet holding the specified message
+     *
+     * @param type The type of message to send
+     * @param msg The payload of the packet
+     */
+    std::shared_ptr<Packet> acquire(MessageType type, const std::string &msg);
+
+    /**
+     * Record the payload size of a message in the running average used to
+     * size new packets
+     */
+    void observe(uint32_t payload_size);
+
+    /**
+     * Get the pool's counters
+     */
+    PacketPoolStats get_stats() const;
+
+  private:
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<Packet>> packets;
+    size_t max_packets;
+    uint32_t typical_size = 0; ///< Running average of observed payload sizes
+    size_t next = 0;           ///< Where to resume searching for a free packet
+    PacketPoolStats stats = {};
+
+    std::shared_ptr<Packet> take(uint32_t payload_size);
+};
+
+} // namespace dwmipc
@@ -0,0 +1,172 @@
+/**
+ * @file small_function.hpp
+ *
+ * This file contains the SmallFunction class, a move-only replacement for
+ * std::function that stores typical callables without allocating.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace dwmipc {
+/**
+ * The default number of bytes a SmallFunction can store inline. This is
+ * enough for a lambda capturing six pointers or references.
+ */
+static constexpr size_t SMALL_FUNCTION_CAPACITY = 6 * sizeof(void *);
+
+template <typename Signature, size_t Capacity = SMALL_FUNCTION_CAPACITY>
+class SmallFunction;
+
+/**
+ * A type erased callable, like std::function, that constructs the callable in
+ * a fixed size buffer inside the object. Callables that are too large for the
+ * buffer, or that may throw when moved, are stored on the heap instead.
+ *
+ * @tparam R The return type
+ * @tparam Args The argument types
+ * @tparam Capacity The size of the inline buffer in bytes
+ */
+template <typename R, typename... Args, size_t Capacity>
+class SmallFunction<R(Args...), Capacity> {
+  public:
+    /**
+     * Construct an empty SmallFunction
+     */
+    SmallFunction() : invoke_fn(nullptr), manage_fn(nullptr) {}
+
+    /**
+     * Construct a SmallFunction holding the specified callable
+     */
+    template <typename F,
+              typename = typename std::enable_if<!std::is_same<
+                  typename std::decay<F>::type, SmallFunction>::value>::type>
+    SmallFunction(F &&f) {
+        typedef typename std::decay<F>::type Fn;
+        init<Fn>(std::forward<F>(f),
+                 std::integral_constant<bool, fits_inline<Fn>()>());
+    }
+
+    SmallFunction(SmallFunction &&other) noexcept
+        : invoke_fn(other.invoke_fn), manage_fn(other.manage_fn) {
+        if (manage_fn)
+            manage_fn(&storage, &other.storage);
+        other.invoke_fn = nullptr;
+        other.manage_fn = nullptr;
+    }
+
+    SmallFunction &operator=(SmallFunction &&other) noexcept {
+        if (this != &other) {
+            reset();
+            invoke_fn = other.invoke_fn;
+            manage_fn = other.manage_fn;
+            if (manage_fn)
+                manage_fn(&storage, &other.storage);
+            other.invoke_fn = nullptr;
+            other.manage_fn = nullptr;
+        }
+        return *this;
+    }
+
+    SmallFunction(const SmallFunction &) = delete;
+    SmallFunction &operator=(const SmallFunction &) = delete;
+
+    ~SmallFunction() { reset(); }
+
+    /**
+     * Call the stored callable. The SmallFunction must not be empty.
+     */
+    R operator()(Args... args) const {
+        return invoke_fn(storage, std::forward<Args>(args)...);
+    }
+
+    /**
+     * Check if a callable is stored
+     */
+    explicit operator bool() const { return invoke_fn != nullptr; }
+
+    /**
+     * Destroy the stored callable, leaving the SmallFunction empty
+     */
+    void reset() {
+        if (manage_fn)
+            manage_fn(nullptr, &storage);
+        invoke_fn = nullptr;
+        manage_fn = nullptr;
+    }
+
+    /**
+     * Check if a callable of the specified type is stored without allocating
+     */
+    template <typename F> static constexpr bool fits_inline() {
+        return sizeof(F) <= Capacity &&
+               alignof(Storage) % alignof(F) == 0 &&
+               std::is_nothrow_move_constructible<F>::value;
+    }
+
+  private:
+    typedef typename std::aligned_storage<Capacity,
+                                          alignof(std::max_align_t)>::type
+        Storage;
+
+    mutable Storage storage;
+
+    /**
+     * Call the callable held in storage
+     */
+    R (*invoke_fn)(Storage &storage, Args... args);
+
+    /**
+     * Move the callable held in src into dst, or destroy it if dst is null
+     */
+    void (*manage_fn)(Storage *dst, Storage *src);
+
+    template <typename Fn, typename F>
+    void init(F &&f, std::true_type /* inline */) {
+        new (&storage) Fn(std::forward<F>(f));
+        invoke_fn = &invoke_inline<Fn>;
+        manage_fn = &manage_inline<Fn>;
+    }
+
+    template <typename Fn, typename F>
+    void init(F &&f, std::false_type /* inline */) {
+        *reinterpret_cast<Fn **>(&storage) = new Fn(std::forward<F>(f));
+        invoke_fn = &invoke_heap<Fn>;
+        manage_fn = &manage_heap<Fn>;
+    }
+
+    template <typename Fn>
+    static R invoke_inline(Storage &storage, Args... args) {
+        return (*reinterpret_cast<Fn *>(&storage))(
+            std::forward<Args>(args)...);
+    }
+
+    template <typename Fn>
+    static void manage_inline(Storage *dst, Storage *src) {
+        Fn *f = reinterpret_cast<Fn *>(src);
+        if (dst)
+            new (dst) Fn(std::move(*f));
+        f->~Fn();
+    }
+
+    template <typename Fn>
+    static R invoke_heap(Storage &storage, Args... args) {
+        return (**reinterpret_cast<Fn **>(&storage))(
+            std::forward<Args>(args)...);
+    }
+
+    template <typename Fn>
+    static void manage_heap(Storage *dst, Storage *src) {
+        Fn *&f = *reinterpret_cast<Fn **>(src);
+        if (dst)
+            *reinterpret_cast<Fn **>(dst) = f;
+        else
+            delete f;
+    }
+};
+
+} // namespace dwmipc
@@ -0,0 +1,134 @@
+/**
+ * @file spsc_ring.hpp
+ *
+ * This file contains the SpscRing class, a bounded lock-free queue between
+ * one producer thread and one consumer thread. This file is used internally by
+ * dwmipcpp.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace dwmipc {
+/**
+ * A bounded single-producer/single-consumer ring of preallocated slots. The
+ * producer fills a slot in place and publishes it, and the consumer reads it
+ * in place and hands it back, so slots keep any capacity they hold (such as
+ * string buffers) and nothing is allocated after construction.
+ *
+ * Only one thread may call the producer functions and only one thread may
+ * call the consumer functions at a time.
+ *
+ * @tparam T The slot type. It must be default constructible.
+ */
+template <typename T> class SpscRing {
+  public:
+    /**
+     * Construct a ring
+     *
+     * @param capacity The number of slots, rounded up to a power of two
+     */
+    explicit SpscRing(const size_t capacity) {
+        size_t n = 1;
+        while (n < capacity)
+            n <<= 1;
+        slots.resize(n);
+        mask = n - 1;
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    /**
+     * Get the slot to fill next. Producer only.
+     *
+     * @return The slot, or nullptr if the ring is full
+     */
+    T *write_slot() {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head > mask) {
+            // Only look at the consumer's index when the ring looks full
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head > mask)
+                return nullptr;
+        }
+        return &slots[t & mask];
+    }
+
+    /**
+     * Publish the slot returned by write_slot. Producer only.
+     */
+    void commit_write() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+    }
+
+    /**
+     * Get the oldest published slot. Consumer only.
+     *
+     * @return The slot, or nullptr if the ring is empty
+     */
+    T *read_slot() {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail)
+                return nullptr;
+        }
+        return &slots[h & mask];
+    }
+
+    /**
+     * Hand the slot returned by read_slot back to the producer. Consumer only.
+     */
+    void commit_read() {
+        head.store(head.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+    }
+
+    /**
+     * Check if no slot is published. This may be called from either thread,
+     * and is only a snapshot while the other thread is running.
+     */
+    bool empty() const {
+        return head.load(std::memory_order_acquire) ==
+               tail.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Get the number of published slots. See empty.
+     */
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) -
+               head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Get the number of slots
+     */
+    size_t capacity() const { return mask + 1; }
+
+  private:
+    /**
+     * Assumed size of a cache line. The indices written by each thread are
+     * kept on separate lines so the threads don't invalidate each other's
+     * cache on every operation.
+     */
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::vector<T> slots;
+    size_t mask;
+
+    char pad0[CACHE_LINE];
+    std::atomic<size_t> head{0}; ///< Next slot to read, written by consumer
+    size_t cached_tail = 0;      ///< Consumer's copy of tail
+    char pad1[CACHE_LINE];
+    std::atomic<size_t> tail{0}; ///< Next slot to write, written by producer
+    size_t cached_head = 0;      ///< Producer's copy of head
+    char pad2[CACHE_LINE];
+};
+
+} // namespace dwmipc
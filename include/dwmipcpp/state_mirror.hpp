@@ -0,0 +1,229 @@
+/**
+ * @file state_mirror.hpp
+ *
+ * This file contains the declarations for the StateMirror class which keeps a
+ * client side copy of DWM's state up to date using events.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "connection.hpp"
+#include "diff.hpp"
+#include "types.hpp"
+
+namespace dwmipc {
+/**
+ * A copy of DWM's monitors, tags and layouts that is kept current by applying
+ * events as they are handled by the Connection. Queries are answered from
+ * memory. A round trip to DWM is only made when a value cannot be derived from
+ * events:
+ *
+ * - The title and state of the focused client are fetched the first time they
+ *   are requested for a newly focused window that has not raised a
+ *   focused_title_change_event or focused_state_change_event.
+ * - The client lists of the monitors are refetched after an event suggests
+ *   that a window was created, destroyed or moved, since no event describes
+ *   those changes.
+ *
+ * The mirror is updated on whichever thread calls Connection::handle_events,
+ * and it must only be queried from that thread.
+ *
+ * When the connection is re-established after losing a socket, the state is
+ * fetched again before the next event is applied or the next non-const query
+ * is answered. Until then, the const queries return the state from before the
+ * loss.
+ */
+class StateMirror {
+  public:
+    /**
+     * Subscribe to every event, fetch the current state from DWM and register
+     * event handlers with the connection. The connection's on_* handlers and
+     * handlers registered after the mirror are called after the mirror has
+     * applied the event, so they observe the updated state.
+     *
+     * The mirror wraps the connection's on_reconnected handler, which is
+     * still called. A handler assigned to on_reconnected after the mirror is
+     * constructed replaces the wrapper, so it must call refresh itself.
+     *
+     * @param connection The connection to mirror. It must outlive the
+     *   StateMirror.
+     *
+     * @throw ResultFailureError if DWM sends an error reply.
+     * @throw SocketClosedError if a socket is disconnected
+     */
+    StateMirror(Connection &connection);
+
+    /**
+     * Remove the mirror's event handlers from the connection
+     */
+    ~StateMirror();
+
+    StateMirror(const StateMirror &) = delete;
+    StateMirror &operator=(const StateMirror &) = delete;
+
+    /**
+     * Discard the mirrored state and fetch it again from DWM. This is done
+     * automatically after the connection has been re-established, since
+     * events may have been missed.
+     *
+     * @throw ResultFailureError if DWM sends an error reply.
+     * @throw SocketClosedError if the socket is disconnected
+     */
+    void refresh();
+
+    /**
+     * Get the mirrored monitors. The client lists are refetched first if they
+     * may be out of date.
+     *
+     * @throw SocketClosedError if a refetch was needed and the socket is
+     *   disconnected
+     */
+    const std::vector<Monitor> &get_monitors();
+
+    /**
+     * Get the tags defined by DWM. These never change while DWM is running.
+     */
+    const std::vector<Tag> &get_tags() const { return this->tags; }
+
+    /**
+     * Get the layouts defined by DWM. These never change while DWM is running.
+     */
+    const std::vector<Layout> &get_layouts() const { return this->layouts; }
+
+    /**
+     * Get the mirrored monitor with the specified index. The client lists of
+     * the returned monitor may be out of date; use get_monitors if they are
+     * needed.
+     *
+     * @param num Index of the monitor according to DWM
+     *
+     * @return The monitor, or nullptr if there is no such monitor
+     */
+    const Monitor *get_monitor(unsigned int num) const;
+
+    /**
+     * Get the monitor that is currently in focus, or nullptr if DWM reported
+     * no monitors. See get_monitor.
+     */
+    const Monitor *get_selected_monitor() const;
+
+    /**
+     * Get the window XID of the focused client, or 0 if no client is focused
+     */
+    Window get_focused_window() const;
+
+    /**
+     * Get the title of the focused client. A round trip is only made if the
+     * title is not known from events or an earlier call.
+     *
+     * @return The title, or an empty string if no client is focused
+     *
+     * @throw SocketClosedError if the socket is disconnected
+     */
+    const std::string &get_focused_title();
+
+    /**
+     * Get the state of the focused client. A round trip is only made if the
+     * state is not known from events or an earlier call.
+     *
+     * @return The state, or a zeroed state if no client is focused
+     *
+     * @throw SocketClosedError if the socket is disconnected
+     */
+    ClientState get_focused_state();
+
+    /**
+     * Get the number of round trips made to DWM since the mirror was
+     * constructed, including the initial fetch
+     */
+    size_t get_round_trips() const { return this->round_trips; }
+
+    /**
+     * Called with the differences between the old and new monitors whenever
+     * the monitors are refetched from DWM
+     */
+    std::function<void(const MonitorsDiff &diff)> on_monitors_changed;
+
+    /**
+     * Called for each window that appeared since the monitors were last
+     * fetched. DWM raises no event for this, so it is derived by comparing
+     * snapshots when the monitors are refetched.
+     */
+    std::function<void(Window win_id)> on_window_added;
+
+    /**
+     * Called for each window that disappeared since the monitors were last
+     * fetched. See on_window_added.
+     */
+    std::function<void(Window win_id)> on_window_removed;
+
+  private:
+    /**
+     * Cached properties of the focused client
+     */
+    struct FocusedClient {
+        Window window_id = 0;    ///< The client these properties belong to
+        bool has_name = false;   ///< Is name valid
+        bool has_state = false;  ///< Is state valid
+        std::string name;        ///< Window title
+        ClientState state = {};  ///< Client state
+    };
+
+    Connection &connection;
+    std::vector<Monitor> monitors;
+    std::vector<Tag> tags;
+    std::vector<Layout> layouts;
+    FocusedClient focused;
+
+    /**
+     * Set when an event suggests the monitors' client lists have changed
+     */
+    bool clients_stale = false;
+
+    size_t round_trips = 0;
+
+    /**
+     * Set by on_reconnected, possibly on another thread, when the state must
+     * be fetched again
+     */
+    std::atomic<bool> resync{false};
+
+    /**
+     * The connection's on_reconnected handler from before the mirror was
+     * constructed, called by the mirror's own and restored by the destructor
+     */
+    std::function<void()> chained_reconnected;
+
+    /**
+     * Reused between refetches to keep the capacity of its vectors
+     */
+    MonitorsDiff diff;
+
+    /**
+     * The handlers registered on the connection
+     */
+    std::vector<HandlerToken> tokens;
+
+    Monitor *find_monitor(unsigned int num);
+    void replace_monitors(std::vector<Monitor> &fresh);
+    void fetch_focused();
+
+    /**
+     * Refresh if the connection was re-established since the last refresh
+     */
+    void sync();
+
+    void apply(const TagChangeEvent &ev);
+    void apply(const ClientFocusChangeEvent &ev);
+    void apply(const LayoutChangeEvent &ev);
+    void apply(const MonitorFocusChangeEvent &ev);
+    void apply(const FocusedTitleChangeEvent &ev);
+    void apply(const FocusedStateChangeEvent &ev);
+};
+
+} // namespace dwmipc
@@ -0,0 +1,123 @@
+/**
+ * @file static_packet.hpp
+ *
+ * This file contains the declarations for packets that are serialized at
+ * compile time. This file is used internally by dwmipcpp.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "packet.hpp"
+#include "types.hpp"
+
+namespace dwmipc {
+/**
+ * A compile time sequence of indices, used to expand an array initializer
+ */
+template <size_t... I> struct IndexSequence {};
+
+/**
+ * Builds IndexSequence<0, 1, ..., N - 1>
+ */
+template <size_t N, size_t... I>
+struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...> {};
+
+template <size_t... I> struct MakeIndexSequence<0, I...> {
+    typedef IndexSequence<I...> type;
+};
+
+/**
+ * A complete packet, header included, whose bytes are known at compile time.
+ * Instances declared constexpr live in read-only memory and can be written to
+ * the socket as is.
+ *
+ * @tparam N The size of the payload including the terminating NUL
+ */
+template <size_t N> struct StaticPacket {
+    uint8_t data[Packet::HEADER_SIZE + N]; ///< The serialized packet
+
+    /**
+     * Get a view of the packet that can be passed to Connection::dwm_msg
+     */
+    PacketView view() const {
+        return {data, static_cast<uint32_t>(sizeof(data)),
+                data[Packet::HEADER_SIZE - 1]};
+    }
+};
+
+static constexpr size_t MAGIC_END = DWM_MAGIC_LEN;
+static constexpr size_t SIZE_END = MAGIC_END + sizeof(uint32_t);
+static constexpr size_t HEADER_END = SIZE_END + sizeof(uint8_t);
+
+static_assert(HEADER_END == Packet::HEADER_SIZE,
+              "Packet header layout does not match the static packet layout");
+
+/**
+ * Get byte i of the header's size field. The size is sent in host byte order,
+ * as DWM reads it straight into a uint32_t.
+ */
+constexpr uint8_t size_byte(const size_t size, const size_t i) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return static_cast<uint8_t>((size >> (8 * (sizeof(uint32_t) - 1 - i))) &
+                                0xff);
+#else
+    return static_cast<uint8_t>((size >> (8 * i)) & 0xff);
+#endif
+}
+
+/**
+ * Get byte i of the packet holding the specified message
+ */
+template <size_t N>
+constexpr uint8_t packet_byte(const MessageType type, const char (&msg)[N],
+                              const size_t i) {
+    return i < MAGIC_END    ? static_cast<uint8_t>(DWM_MAGIC[i])
+           : i < SIZE_END   ? size_byte(N, i - MAGIC_END)
+           : i < HEADER_END ? static_cast<uint8_t>(type)
+                            : static_cast<uint8_t>(msg[i - HEADER_END]);
+}
+
+template <size_t N, size_t... I>
+constexpr StaticPacket<N> make_static_packet(const MessageType type,
+                                             const char (&msg)[N],
+                                             IndexSequence<I...>) {
+    return StaticPacket<N>{{packet_byte(type, msg, I)...}};
+}
+
+/**
+ * Serialize a packet at compile time
+ *
+ * @param type The type of message to send
+ * @param msg The payload of the packet as a string literal
+ */
+template <size_t N>
+constexpr StaticPacket<N> make_static_packet(const MessageType type,
+                                             const char (&msg)[N]) {
+    return make_static_packet(
+        type, msg,
+        typename MakeIndexSequence<Packet::HEADER_SIZE + N>::type());
+}
+
+/**
+ * Get the precompiled packet for a request with an empty payload
+ *
+ * @param type GET_MONITORS, GET_TAGS, or GET_LAYOUTS
+ *
+ * @throw std::invalid_argument for any other type
+ */
+PacketView static_request(MessageType type);
+
+/**
+ * Get the precompiled packet for subscribing or unsubscribing to an event
+ *
+ * @param ev The event to subscribe to or unsubscribe from
+ * @param sub true to subscribe, false to unsubscribe
+ *
+ * @throw std::invalid_argument if ev is not a single known event
+ */
+PacketView static_subscribe(Event ev, bool sub);
+
+} // namespace dwmipc
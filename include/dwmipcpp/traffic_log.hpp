@@ -0,0 +1,154 @@
+/**
+ * @file traffic_log.hpp
+ *
+ * This file contains the declarations for recording the messages exchanged
+ * with DWM into a compact binary log and reading such a log back.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "packet.hpp"
+
+namespace dwmipc {
+/**
+ * The socket a recorded message was exchanged on
+ */
+enum class SocketRole : uint8_t {
+    MAIN, ///< The socket used for requests and replies
+    EVENT ///< The socket used for subscriptions and events
+};
+
+/**
+ * Whether a recorded message was sent to or received from DWM
+ */
+enum class Direction : uint8_t { SENT, RECEIVED };
+
+/**
+ * A message read from a traffic log
+ */
+struct TrafficRecord {
+    /// Nanoseconds between the start of the recording and the message. For a
+    /// received message, this is when the read that completed it returned, so
+    /// messages received in one read have the same time.
+    uint64_t time_ns;
+    SocketRole role;     ///< The socket the message was exchanged on
+    Direction direction; ///< Whether the message was sent or received
+    uint8_t type;        ///< The message type from the packet header
+    std::string payload; ///< The payload, including the null terminator
+};
+
+/**
+ * Writes every message passed to it into a traffic log file. The log starts
+ * with a short header, followed by one record per message:
+ *
+ *  - The time since the previous record in nanoseconds, zigzag encoded since
+ *    messages recorded by different threads may be slightly out of order
+ *  - One byte holding the socket role and direction
+ *  - The message type
+ *  - The payload size
+ *  - The payload
+ *
+ * The time and size are variable-length integers, so most records only add a
+ * few bytes to the payload. Records are buffered and written in large chunks.
+ *
+ * A recorder may be shared by several threads and connections.
+ */
+class TrafficRecorder {
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * Create a log file, replacing any existing file at the path. The
+     * recording starts now.
+     *
+     * @param path The path of the log file
+     *
+     * @throw ErrnoError if the file could not be created
+     */
+    TrafficRecorder(const std::string &path);
+
+    TrafficRecorder(const TrafficRecorder &) = delete;
+    TrafficRecorder &operator=(const TrafficRecorder &) = delete;
+
+    /**
+     * Flush the buffered records and close the file. Write errors are
+     * ignored, so call flush first to find out about them.
+     */
+    ~TrafficRecorder();
+
+    /**
+     * Record a message
+     *
+     * @param time When the message was sent or received
+     * @param role The socket the message was exchanged on
+     * @param direction Whether the message was sent or received
+     * @param type The message type from the packet header
+     * @param payload Pointer to the start of the payload
+     * @param size Size of the payload as specified in the packet header
+     *
+     * @throw ErrnoError if the buffered records could not be written
+     */
+    void record(Clock::time_point time, SocketRole role, Direction direction,
+                uint8_t type, const char *payload, uint32_t size);
+
+    /**
+     * Record a message that is about to be sent
+     *
+     * @param role The socket the message is sent on
+     * @param packet The complete packet, including its header
+     *
+     * @throw ErrnoError if the buffered records could not be written
+     */
+    void record_sent(SocketRole role, const PacketView &packet);
+
+    /**
+     * Write the buffered records to the file
+     *
+     * @throw ErrnoError if the records could not be written
+     */
+    void flush();
+
+    /**
+     * Get the number of messages recorded so far
+     */
+    size_t get_records() const;
+
+  private:
+    /**
+     * Buffered bytes are written once there are this many
+     */
+    static constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+    mutable std::mutex mutex;
+    int fd;
+    std::vector<char> buf;
+    const Clock::time_point start;
+    uint64_t last_ns = 0;
+    size_t records = 0;
+
+    /**
+     * Write the buffered bytes. The mutex must be held.
+     */
+    void write_buffer();
+};
+
+/**
+ * Read every record from a traffic log written by a TrafficRecorder
+ *
+ * @param path The path of the log file
+ *
+ * @return The records, in the order they were recorded
+ *
+ * @throw ErrnoError if the file could not be read
+ * @throw TrafficLogError if the file is not a traffic log or is truncated
+ */
+std::vector<TrafficRecord> read_traffic_log(const std::string &path);
+
+} // namespace dwmipc
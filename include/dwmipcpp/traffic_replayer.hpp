@@ -0,0 +1,92 @@
+/**
+ * @file traffic_replayer.hpp
+ *
+ * This file contains the declarations for the TrafficReplayer class which
+ * feeds a recorded traffic log back into a Connection.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "connection.hpp"
+#include "traffic_log.hpp"
+
+namespace dwmipc {
+/**
+ * What happened during a replay
+ */
+struct ReplayStats {
+    size_t events;     ///< Events passed to the connection's handlers
+    size_t replies;    ///< Replies parsed by the connection
+    size_t failures;   ///< Replies that were recorded as failed requests
+    double elapsed_ms; ///< Wall time taken by the replay
+    /// How far behind the scaled recorded time a message was handled at
+    /// worst. This is 0 when replaying as fast as possible.
+    double max_lag_ms;
+};
+
+/**
+ * Replays the messages received in a traffic log through a Connection's parse
+ * and dispatch path, without a DWM instance. Events go through the event
+ * filter, coalescing and handlers, and replies are parsed as by the requests
+ * that asked for them. Messages that were sent are skipped.
+ *
+ * Messages received in one read are replayed as one batch, as handle_events
+ * would have handled them. Events held by a coalescing time window when the
+ * replay ends are not dispatched.
+ */
+class TrafficReplayer {
+  public:
+    /**
+     * Pass as the speed to replay without waiting between messages
+     */
+    static constexpr double AS_FAST_AS_POSSIBLE = 0;
+
+    /**
+     * Construct a replayer for records that are already loaded
+     */
+    TrafficReplayer(std::vector<TrafficRecord> records);
+
+    /**
+     * Construct a replayer for a traffic log file, which is read entirely
+     * before returning so that replays are not slowed down by reading it
+     *
+     * @throw ErrnoError if the file could not be read
+     * @throw TrafficLogError if the file is not a valid traffic log
+     */
+    TrafficReplayer(const std::string &path);
+
+    /**
+     * Replay the log into a connection. The connection does not need to be
+     * connected. Exceptions thrown by handlers are passed on.
+     *
+     * @param conn The connection whose handlers and parsers are run
+     * @param speed How many times faster than recorded to replay, or
+     *   AS_FAST_AS_POSSIBLE. 1 replays at the original speed.
+     *
+     * @return What happened during the replay
+     */
+    ReplayStats replay(Connection &conn, double speed = 1) const;
+
+    /**
+     * Get the records being replayed
+     */
+    const std::vector<TrafficRecord> &get_records() const {
+        return this->records;
+    }
+
+  private:
+    std::vector<TrafficRecord> records;
+
+    /**
+     * Check if a record ends a batch of events received in one read
+     *
+     * @param i The index of a received record
+     */
+    bool ends_batch(size_t i) const;
+};
+
+} // namespace dwmipc
@@ -7,7 +7,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -162,6 +164,33 @@ struct Client {
     } states;               ///< Client states
 };
 
+/**
+ * A window that could not be fetched by Connection::get_clients
+ */
+struct ClientFailure {
+    Window window_id;   ///< Window XID that was requested
+    std::string reason; ///< Error message, such as DWM's error reply
+};
+
+/**
+ * The result of fetching several clients at once
+ */
+struct ClientList {
+    std::vector<Client> clients; ///< Clients that were fetched successfully,
+                                 ///< in the order they were requested
+    std::vector<ClientFailure> failures; ///< Windows that could not be fetched,
+                                         ///< such as ones closed mid-batch
+};
+
+/**
+ * The monitors, tags and layouts of DWM fetched together
+ */
+struct StateSnapshot {
+    std::shared_ptr<std::vector<Monitor>> monitors; ///< All monitors
+    std::shared_ptr<std::vector<Tag>> tags;         ///< All tags
+    std::shared_ptr<std::vector<Layout>> layouts;   ///< All layouts
+};
+
 /**
  * Struct describing a tag_change_event
  */
@@ -253,4 +282,16 @@ enum class Event : uint8_t {
  */
 extern const std::unordered_map<Event, std::string> event_map;
 
+/**
+ * Get the Event with the specified name. This takes the same small, constant
+ * amount of time for every event and does not allocate.
+ *
+ * @param name Pointer to the name, which need not be null terminated
+ * @param len Length of the name
+ * @param ev Set to the event if the name was recognized
+ *
+ * @return true if the name is the name of an event, false otherwise
+ */
+bool event_from_name(const char *name, size_t len, Event &ev);
+
 } // namespace dwmipc
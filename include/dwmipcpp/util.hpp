@@ -9,6 +9,7 @@
 #include <memory>
 #include <string>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 
@@ -47,6 +48,23 @@ void disconnect(int fd);
  */
 ssize_t swrite(const int fd, const void *buf, const uint32_t count);
 
+/**
+ * Helper function to keep attempting to write several buffers to a file
+ * descriptor with as few writev calls as possible, continuing on EINTR,
+ * EAGAIN, or EWOULDBLOCK errors and after partial writes.
+ *
+ * @param fd File descriptor to write to
+ * @param iov Array of buffers to write. The array may be modified to track
+ *   partially written buffers.
+ * @param iovcnt Number of buffers in the array
+ *
+ * @return Number of bytes written
+ *
+ * @throw SocketClosedError if the socket is closed
+ * @throw ErrnoError if the write fails
+ */
+ssize_t swritev(const int fd, struct iovec *iov, size_t iovcnt);
+
 /**
  * Receive any incoming messages from the specified socket. This is the main
  * helper function for attempting to read a message from DWM and validate the
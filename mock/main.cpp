@@ -0,0 +1,141 @@
+/**
+ * @file main.cpp
+ *
+ * mock-dwm serves a synthetic DWM IPC socket until it is interrupted, so that
+ * dwmipcpp and programs using it can be run without DWM.
+ */
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+
+#include "dwmipcpp/errors.hpp"
+#include "mock_server.hpp"
+
+static void usage(const char *name) {
+    std::printf(
+        "Usage: %s [options]\n"
+        "\n"
+        "  -s, --socket PATH   Socket to listen on (default /tmp/dwm.sock)\n"
+        "  -m, --monitors N    Number of monitors (default 2)\n"
+        "  -t, --tags N        Number of tags (default 9)\n"
+        "  -c, --clients N     Clients on each monitor (default 4)\n"
+        "  -e, --events MASK   Random event types as a mask of event bits,\n"
+        "                      0 for no event stream (default 63)\n"
+        "  -f, --script FILE   Send the events in FILE, one payload per line,\n"
+        "                      instead of random events\n"
+        "  -r, --rate N        Bursts per second, 0 for as fast as they are\n"
+        "                      read (default 10)\n"
+        "  -b, --burst N       Events per burst (default 1)\n"
+        "  -n, --count N       Stop the stream after N events (default 0,\n"
+        "                      never)\n"
+        "  -S, --seed N        Seed for random events (default 1)\n"
+        "  -h, --help          Show this help\n",
+        name);
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        {"socket", required_argument, nullptr, 's'},
+        {"monitors", required_argument, nullptr, 'm'},
+        {"tags", required_argument, nullptr, 't'},
+        {"clients", required_argument, nullptr, 'c'},
+        {"events", required_argument, nullptr, 'e'},
+        {"script", required_argument, nullptr, 'f'},
+        {"rate", required_argument, nullptr, 'r'},
+        {"burst", required_argument, nullptr, 'b'},
+        {"count", required_argument, nullptr, 'n'},
+        {"seed", required_argument, nullptr, 'S'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    std::string socket_path = "/tmp/dwm.sock";
+    unsigned int monitors = 2, tags = 9, clients = 4;
+    dwmipc::MockEventOptions events;
+    events.rate = 10;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:m:t:c:e:f:r:b:n:S:h",
+                              long_options, nullptr)) != -1) {
+        switch (opt) {
+        case 's':
+            socket_path = optarg;
+            break;
+        case 'm':
+            monitors = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 't':
+            tags = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'c':
+            clients = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'e':
+            events.types = std::strtoul(optarg, nullptr, 0);
+            break;
+        case 'f': {
+            std::ifstream file(optarg);
+            if (!file) {
+                std::cerr << "Failed to open " << optarg << std::endl;
+                return 1;
+            }
+            std::string line;
+            while (std::getline(file, line))
+                if (!line.empty())
+                    events.script.push_back(line);
+            break;
+        }
+        case 'r':
+            events.rate = std::strtod(optarg, nullptr);
+            break;
+        case 'b':
+            events.burst = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'n':
+            events.count = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'S':
+            events.seed = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Wait for these signals below instead of being killed by them. They are
+    // blocked before the server starts its threads, which inherit the mask.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try {
+        dwmipc::MockServer server(
+            socket_path,
+            dwmipc::MockModel::synthetic(monitors, tags, clients));
+        if (events.types || !events.script.empty())
+            server.start_events(events);
+
+        std::cout << "Listening on " << socket_path << std::endl;
+        int sig;
+        sigwait(&signals, &sig);
+
+        const dwmipc::MockServerStats stats = server.get_stats();
+        std::cout << "Served " << stats.connections << " connections, "
+                  << stats.requests << " requests and " << stats.events
+                  << " events" << std::endl;
+    } catch (const dwmipc::IPCError &err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,816 @@
+/**
+ * @file mock_server.cpp
+ *
+ * This file contains the implementation details for the MockServer class.
+ */
+
+#include "mock_server.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "dwmipcpp/decoder.hpp"
+#include "dwmipcpp/errors.hpp"
+#include "dwmipcpp/event_view.hpp"
+#include "dwmipcpp/frame_reader.hpp"
+#include "dwmipcpp/util.hpp"
+
+namespace dwmipc {
+typedef std::chrono::steady_clock Clock;
+
+static const char SUCCESS[] = "{\"result\":\"success\"}";
+
+/**
+ * Write a buffer to a socket, waiting for the socket to become writable
+ * whenever its buffer is full
+ *
+ * @return The time spent waiting for room in the socket buffer in nanoseconds
+ *
+ * @throw SocketClosedError if the peer closed the socket
+ * @throw ErrnoError if writing fails
+ */
+static uint64_t write_waiting(const int fd, const char *buf,
+                              const size_t count) {
+    uint64_t waited_ns = 0;
+    size_t written = 0;
+
+    while (written < count) {
+        const ssize_t n = send(fd, buf + written, count - written,
+                               MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n >= 0) {
+            written += n;
+            continue;
+        }
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // Only this wait counts, not the time taken to copy the data
+            const auto start = Clock::now();
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            poll(&pfd, 1, -1);
+            waited_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             Clock::now() - start)
+                             .count();
+        } else if (errno == EPIPE) {
+            throw SocketClosedError(fd);
+        } else if (errno != EINTR) {
+            throw ErrnoError("Error writing events");
+        }
+    }
+    return waited_ns;
+}
+
+/**
+ * Build the reply DWM sends when a request fails
+ */
+static std::string error_reply(const std::string &reason) {
+    Json::Value root;
+    root["result"] = "error";
+    root["reason"] = reason;
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    return Json::writeString(builder, root);
+}
+
+/**
+ * Quote and escape a string for a JSON document
+ */
+static std::string quote(const std::string &str) {
+    return Json::valueToQuotedString(str.c_str());
+}
+
+/**
+ * Serialize a message into a complete packet
+ */
+static void append_frame(std::string &out, const uint8_t type,
+                         const std::string &payload) {
+    const uint32_t size = payload.size() + 1;
+    out.append(DWM_MAGIC, DWM_MAGIC_LEN);
+    out.append(reinterpret_cast<const char *>(&size), sizeof(size));
+    out.push_back(static_cast<char>(type));
+    out.append(payload.c_str(), size);
+}
+
+static void write_geometry(std::ostream &out, const Geometry &geom) {
+    out << "{\"x\":" << geom.x << ",\"y\":" << geom.y
+        << ",\"width\":" << geom.width << ",\"height\":" << geom.height << "}";
+}
+
+static void write_size(std::ostream &out, const Size &size) {
+    out << "{\"width\":" << size.width << ",\"height\":" << size.height << "}";
+}
+
+static void write_windows(std::ostream &out, const std::vector<Window> &wins) {
+    out << "[";
+    for (size_t i = 0; i < wins.size(); i++)
+        out << (i ? "," : "") << wins[i];
+    out << "]";
+}
+
+static void write_tag_state(std::ostream &out, const TagState &state) {
+    out << "{\"selected\":" << state.selected
+        << ",\"occupied\":" << state.occupied << ",\"urgent\":" << state.urgent
+        << "}";
+}
+
+static void write_client_state(std::ostream &out, const ClientState &state) {
+    out << std::boolalpha << "{\"old_state\":" << state.old_state
+        << ",\"is_fixed\":" << state.is_fixed
+        << ",\"is_floating\":" << state.is_floating
+        << ",\"is_fullscreen\":" << state.is_fullscreen
+        << ",\"is_urgent\":" << state.is_urgent
+        << ",\"never_focus\":" << state.never_focus << "}";
+}
+
+/**
+ * Build a GET_MONITORS reply in the order DWM writes the fields
+ */
+static std::string monitors_json(const std::vector<Monitor> &monitors) {
+    std::ostringstream out;
+    out << std::boolalpha << "[";
+    for (size_t i = 0; i < monitors.size(); i++) {
+        const Monitor &mon = monitors[i];
+        out << (i ? "," : "") << "{\"master_factor\":" << mon.master_factor
+            << ",\"num_master\":" << mon.num_master << ",\"num\":" << mon.num
+            << ",\"is_selected\":" << mon.is_selected
+            << ",\"monitor_geometry\":";
+        write_geometry(out, mon.monitor_geom);
+        out << ",\"window_geometry\":";
+        write_geometry(out, mon.window_geom);
+        out << ",\"tagset\":{\"current\":" << mon.tagset.cur
+            << ",\"old\":" << mon.tagset.old << "},\"tag_state\":";
+        write_tag_state(out, mon.tag_state);
+        out << ",\"clients\":{\"selected\":" << mon.clients.selected
+            << ",\"stack\":";
+        write_windows(out, mon.clients.stack);
+        out << ",\"all\":";
+        write_windows(out, mon.clients.all);
+        out << "},\"layout\":{\"symbol\":{\"current\":"
+            << quote(mon.layout.symbol.cur)
+            << ",\"old\":" << quote(mon.layout.symbol.old)
+            << "},\"address\":{\"current\":" << mon.layout.address.cur
+            << ",\"old\":" << mon.layout.address.old
+            << "}},\"bar\":{\"y\":" << mon.bar.y
+            << ",\"is_shown\":" << mon.bar.is_shown
+            << ",\"is_top\":" << mon.bar.is_top
+            << ",\"window_id\":" << mon.bar.window_id << "}}";
+    }
+    out << "]";
+    return out.str();
+}
+
+static std::string tags_json(const std::vector<Tag> &tags) {
+    std::ostringstream out;
+    out << "[";
+    for (size_t i = 0; i < tags.size(); i++)
+        out << (i ? "," : "") << "{\"bit_mask\":" << tags[i].bit_mask
+            << ",\"name\":" << quote(tags[i].tag_name) << "}";
+    out << "]";
+    return out.str();
+}
+
+static std::string layouts_json(const std::vector<Layout> &layouts) {
+    std::ostringstream out;
+    out << "[";
+    for (size_t i = 0; i < layouts.size(); i++)
+        out << (i ? "," : "") << "{\"symbol\":" << quote(layouts[i].symbol)
+            << ",\"address\":" << layouts[i].address << "}";
+    out << "]";
+    return out.str();
+}
+
+/**
+ * Build a GET_DWM_CLIENT reply in the order DWM writes the fields
+ */
+static std::string client_json(const Client &client) {
+    std::ostringstream out;
+    out << std::boolalpha << "{\"name\":" << quote(client.name)
+        << ",\"tags\":" << client.tags << ",\"window_id\":" << client.window_id
+        << ",\"monitor_number\":" << client.monitor_num
+        << ",\"geometry\":{\"current\":";
+    write_geometry(out, client.geom.cur);
+    out << ",\"old\":";
+    write_geometry(out, client.geom.old);
+    out << "},\"size_hints\":{\"base\":";
+    write_size(out, client.size_hints.base);
+    out << ",\"step\":";
+    write_size(out, client.size_hints.step);
+    out << ",\"max\":";
+    write_size(out, client.size_hints.max);
+    out << ",\"min\":";
+    write_size(out, client.size_hints.min);
+    out << ",\"aspect_ratio\":{\"min\":" << client.size_hints.aspect_ratio.min
+        << ",\"max\":" << client.size_hints.aspect_ratio.max
+        << "}},\"border_width\":{\"current\":" << client.border_width.cur
+        << ",\"old\":" << client.border_width.old
+        << "},\"states\":{\"is_fixed\":" << client.states.is_fixed
+        << ",\"is_floating\":" << client.states.is_floating
+        << ",\"is_urgent\":" << client.states.is_urgent
+        << ",\"never_focus\":" << client.states.never_focus
+        << ",\"old_state\":" << client.states.old_state
+        << ",\"is_fullscreen\":" << client.states.is_fullscreen << "}}";
+    return out.str();
+}
+
+static std::string tag_change_json(const unsigned int mon,
+                                   const TagState &old_state,
+                                   const TagState &new_state) {
+    std::ostringstream out;
+    out << "{\"tag_change_event\":{\"monitor_number\":" << mon
+        << ",\"old_state\":";
+    write_tag_state(out, old_state);
+    out << ",\"new_state\":";
+    write_tag_state(out, new_state);
+    out << "}}";
+    return out.str();
+}
+
+static std::string layout_change_json(const Monitor &mon) {
+    std::ostringstream out;
+    out << "{\"layout_change_event\":{\"monitor_number\":" << mon.num
+        << ",\"old_symbol\":" << quote(mon.layout.symbol.old)
+        << ",\"old_address\":" << mon.layout.address.old
+        << ",\"new_symbol\":" << quote(mon.layout.symbol.cur)
+        << ",\"new_address\":" << mon.layout.address.cur << "}}";
+    return out.str();
+}
+
+/**
+ * Get the monitor that has focus
+ */
+static Monitor &selected_monitor(std::vector<Monitor> &monitors) {
+    for (Monitor &mon : monitors)
+        if (mon.is_selected)
+            return mon;
+    return monitors.front();
+}
+
+/**
+ * Find the client with the specified window id
+ *
+ * @return The client, or nullptr if there is none
+ */
+static Client *find_client(std::vector<Client> &clients, const Window win) {
+    for (Client &client : clients)
+        if (client.window_id == win)
+            return &client;
+    return nullptr;
+}
+
+MockModel MockModel::synthetic(const unsigned int monitors,
+                               const unsigned int tags,
+                               const unsigned int clients_per_monitor) {
+    static const char *const symbols[] = {"[]=", "><>", "[M]"};
+
+    MockModel model;
+
+    for (unsigned int t = 0; t < tags && t < 32; t++)
+        model.tags.push_back({1u << t, std::to_string(t + 1)});
+
+    for (unsigned int l = 0; l < 3; l++)
+        model.layouts.push_back({symbols[l], 94229782593760u + l * 24});
+
+    const unsigned int all_tags =
+        tags >= 32 ? 0xffffffff : (1u << tags) - 1;
+
+    for (unsigned int m = 0; m < monitors; m++) {
+        Monitor mon = {};
+        mon.master_factor = 0.55f;
+        mon.num_master = 1;
+        mon.num = m;
+        mon.is_selected = m == 0;
+        mon.monitor_geom = {static_cast<int>(m) * 1920, 0, 1920, 1080};
+        mon.window_geom = {static_cast<int>(m) * 1920, 22, 1920, 1058};
+        mon.tagset.cur = 1;
+        mon.tagset.old = 1;
+        mon.tag_state.selected = 1;
+        mon.layout.symbol.cur = model.layouts[0].symbol;
+        mon.layout.symbol.old = model.layouts[0].symbol;
+        mon.layout.address.cur = model.layouts[0].address;
+        mon.layout.address.old = model.layouts[0].address;
+        mon.bar.is_shown = true;
+        mon.bar.is_top = true;
+        mon.bar.window_id = 8388614 + m;
+
+        for (unsigned int c = 0; c < clients_per_monitor; c++) {
+            Client client = {};
+            client.window_id = 41943041 + m * 1000 + c;
+            client.name = "client " + std::to_string(client.window_id);
+            client.monitor_num = m;
+            client.tags = tags ? 1u << (c % std::min(tags, 3u)) : 0;
+            client.border_width.cur = 1;
+            client.geom.cur = {mon.window_geom.x, 22, 958, 1056};
+            client.geom.old = client.geom.cur;
+            client.size_hints.base = {4, 4};
+            client.size_hints.step = {9, 18};
+            client.size_hints.min = {13, 22};
+
+            mon.tag_state.occupied |= client.tags & all_tags;
+            mon.clients.all.push_back(client.window_id);
+            mon.clients.stack.push_back(client.window_id);
+            model.clients.push_back(client);
+        }
+        if (!mon.clients.all.empty())
+            mon.clients.selected = mon.clients.all.front();
+
+        model.monitors.push_back(mon);
+    }
+    return model;
+}
+
+MockServer::MockServer(const std::string &socket_path,
+                       const MockModel &model)
+    : socket_path(socket_path), model(model) {
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket_path.c_str(),
+                 sizeof(addr.sun_path) - 1);
+
+    unlink(socket_path.c_str());
+    this->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (this->listen_fd < 0 ||
+        bind(this->listen_fd, reinterpret_cast<struct sockaddr *>(&addr),
+             sizeof(addr)) < 0 ||
+        listen(this->listen_fd, 64) < 0) {
+        const ErrnoError err("Failed to listen on " + socket_path);
+        if (this->listen_fd >= 0)
+            close(this->listen_fd);
+        throw err;
+    }
+
+    acceptor = std::thread(&MockServer::accept_loop, this);
+}
+
+MockServer::~MockServer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->shutting_down = true;
+    }
+    // Wakes the acceptor up
+    shutdown(this->listen_fd, SHUT_RDWR);
+    acceptor.join();
+    close(this->listen_fd);
+
+    // Wakes up the peers' threads and any blocked write of the event stream
+    for (const auto &peer : peers)
+        shutdown(peer->fd, SHUT_RDWR);
+    stop_events();
+
+    for (const auto &peer : peers) {
+        peer->thread.join();
+        close(peer->fd);
+    }
+
+    unlink(socket_path.c_str());
+}
+
+void MockServer::start_events(const MockEventOptions &options) {
+    stop_events();
+
+    this->events_stopping = false;
+    events_thread = std::thread(&MockServer::event_loop, this, options);
+}
+
+void MockServer::stop_events() {
+    if (!events_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(events_mutex);
+        this->events_stopping = true;
+    }
+    events_cv.notify_all();
+    events_thread.join();
+}
+
+void MockServer::wait_events() {
+    if (events_thread.joinable())
+        events_thread.join();
+}
+
+void MockServer::emit(const std::string &payload) {
+    Burst burst;
+    if (!burst.add(payload))
+        return;
+
+    this->events++;
+    broadcast(burst);
+}
+
+bool MockServer::wait_subscribers(const Event ev, const size_t count,
+                                  const unsigned int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return subscribers_changed.wait_for(
+        lock, std::chrono::milliseconds(timeout_ms),
+        [&]() { return count_subscribers(ev) == count; });
+}
+
+MockModel MockServer::get_model() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return this->model;
+}
+
+void MockServer::set_model(const MockModel &model) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->model = model;
+}
+
+MockServerStats MockServer::get_stats() const {
+    MockServerStats stats;
+    stats.connections = this->connections.load();
+    stats.requests = this->requests.load();
+    stats.events = this->events.load();
+    stats.blocked_ms = this->blocked_ns.load() / 1e6;
+    return stats;
+}
+
+void MockServer::accept_loop() {
+    int fd;
+    while ((fd = accept4(this->listen_fd, nullptr, nullptr, SOCK_CLOEXEC)) >=
+           0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (this->shutting_down) {
+            close(fd);
+            break;
+        }
+
+        std::unique_ptr<Peer> peer(new Peer);
+        peer->fd = fd;
+        peer->thread = std::thread(&MockServer::serve, this, peer.get());
+        peers.push_back(std::move(peer));
+        this->connections++;
+    }
+}
+
+void MockServer::serve(Peer *peer) {
+    FrameReader reader;
+    Frame request;
+    bool drained;
+    std::string reply;
+    std::vector<std::string> raised;
+
+    while (true) {
+        try {
+            while (!reader.next(request))
+                reader.fill(peer->fd, drained);
+        } catch (const IPCError &) {
+            break;
+        }
+
+        const uint8_t type = request.type;
+        const uint32_t size = request.size;
+        // The payload should end with a null terminator
+        const std::string payload(request.payload,
+                                  size && !request.payload[size - 1] ? size - 1
+                                                                     : size);
+
+        raised.clear();
+        reply.clear();
+        std::string body;
+        try {
+            body = answer(peer, type, payload, raised);
+        } catch (const Json::Exception &err) {
+            // A request the checks above missed gets an error reply rather
+            // than taking the whole server down
+            raised.clear();
+            body = error_reply(err.what());
+        }
+        append_frame(reply, type, body);
+        this->requests++;
+
+        try {
+            std::lock_guard<std::mutex> lock(peer->write_mutex);
+            swrite(peer->fd, reply.data(), reply.size());
+        } catch (const IPCError &) {
+            break;
+        }
+
+        // DWM raises the events of a command after answering it
+        for (const std::string &event : raised)
+            emit(event);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(peer->write_mutex);
+        peer->closed = true;
+        shutdown(peer->fd, SHUT_RDWR);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    peer->subscriptions = 0;
+    subscribers_changed.notify_all();
+}
+
+std::string MockServer::answer(Peer *peer, const uint8_t type,
+                               const std::string &payload,
+                               std::vector<std::string> &raised) {
+    Json::Value root;
+    if (type == static_cast<uint8_t>(MessageType::GET_DWM_CLIENT) ||
+        type == static_cast<uint8_t>(MessageType::RUN_COMMAND) ||
+        type == static_cast<uint8_t>(MessageType::SUBSCRIBE)) {
+        try {
+            pre_parse_reply(root, payload.c_str(), payload.size() + 1);
+        } catch (const IPCError &) {
+        }
+        if (!root.isObject())
+            return error_reply("Invalid JSON in request");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    switch (static_cast<MessageType>(type)) {
+    case MessageType::GET_MONITORS:
+        return monitors_json(model.monitors);
+    case MessageType::GET_TAGS:
+        return tags_json(model.tags);
+    case MessageType::GET_LAYOUTS:
+        return layouts_json(model.layouts);
+    case MessageType::GET_DWM_CLIENT: {
+        if (!root["client_window_id"].isUInt64())
+            return error_reply("Invalid client window id");
+        const Window win = root["client_window_id"].asUInt64();
+        const Client *client = find_client(model.clients, win);
+        if (!client)
+            return error_reply("Client with window id " + std::to_string(win) +
+                               " not found");
+        return client_json(*client);
+    }
+    case MessageType::RUN_COMMAND:
+        return run_command(payload, raised);
+    case MessageType::SUBSCRIBE: {
+        if (!root["event"].isString() || !root["action"].isString())
+            return error_reply("Invalid subscribe request");
+        const std::string name = root["event"].asString();
+        const std::string action = root["action"].asString();
+
+        Event ev;
+        if (!event_from_name(name.c_str(), name.size(), ev))
+            return error_reply("Invalid event name specified: " + name);
+
+        const uint8_t bit = static_cast<uint8_t>(ev);
+        if (action == "subscribe")
+            peer->subscriptions |= bit;
+        else if (action == "unsubscribe")
+            peer->subscriptions &= ~bit;
+        else
+            return error_reply("Invalid action specified: " + action);
+
+        subscribers_changed.notify_all();
+        return SUCCESS;
+    }
+    default:
+        return error_reply("Invalid message type");
+    }
+}
+
+std::string MockServer::run_command(const std::string &payload,
+                                    std::vector<std::string> &raised) {
+    Json::Value root;
+    pre_parse_reply(root, payload.c_str(), payload.size() + 1);
+    if (!root["command"].isString())
+        return error_reply("Invalid command name");
+    const std::string name = root["command"].asString();
+    const Json::Value &args = root["args"];
+    if (!args.isNull() && !args.isArray())
+        return error_reply("Invalid command arguments");
+
+    if (model.monitors.empty())
+        return SUCCESS;
+    Monitor &mon = selected_monitor(model.monitors);
+
+    if (name == "view") {
+        if (args.empty() || !args[0].isUInt())
+            return error_reply("Invalid tag mask");
+        const unsigned int tags = args[0].asUInt();
+        if (!tags || tags == mon.tagset.cur)
+            return SUCCESS;
+
+        const TagState old_state = mon.tag_state;
+        mon.tagset.old = mon.tagset.cur;
+        mon.tagset.cur = tags;
+        mon.tag_state.selected = tags;
+        raised.push_back(tag_change_json(mon.num, old_state, mon.tag_state));
+    } else if (name == "setlayoutsafe") {
+        if (args.empty() || !args[0].isUInt64())
+            return error_reply("Invalid layout address");
+        const uint64_t address = args[0].asUInt64();
+        for (const Layout &layout : model.layouts) {
+            if (layout.address != address)
+                continue;
+
+            mon.layout.symbol.old = mon.layout.symbol.cur;
+            mon.layout.address.old = mon.layout.address.cur;
+            mon.layout.symbol.cur = layout.symbol;
+            mon.layout.address.cur = layout.address;
+            raised.push_back(layout_change_json(mon));
+            return SUCCESS;
+        }
+        return error_reply("Invalid layout address");
+    }
+    return SUCCESS;
+}
+
+std::string MockServer::random_event(const uint8_t types, std::mt19937 &rng) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (model.monitors.empty() || !(types & 0x3f))
+        return std::string();
+
+    // Pick one of the requested types
+    std::vector<Event> choices;
+    for (uint8_t bit = 1; bit <= 0x20; bit <<= 1)
+        if (types & bit)
+            choices.push_back(static_cast<Event>(bit));
+    const Event ev = choices[rng() % choices.size()];
+
+    Monitor &mon = model.monitors[rng() % model.monitors.size()];
+    Client *client = find_client(model.clients, mon.clients.selected);
+    std::ostringstream out;
+
+    switch (ev) {
+    case Event::TAG_CHANGE: {
+        const TagState old_state = mon.tag_state;
+        const size_t tags = model.tags.empty() ? 1 : model.tags.size();
+        mon.tagset.old = mon.tagset.cur;
+        mon.tagset.cur = 1u << (rng() % tags);
+        mon.tag_state.selected = mon.tagset.cur;
+        return tag_change_json(mon.num, old_state, mon.tag_state);
+    }
+    case Event::CLIENT_FOCUS_CHANGE: {
+        const Window old_win = mon.clients.selected;
+        if (!mon.clients.all.empty())
+            mon.clients.selected =
+                mon.clients.all[rng() % mon.clients.all.size()];
+        out << "{\"client_focus_change_event\":{\"monitor_number\":"
+            << mon.num << ",\"old_win_id\":" << old_win
+            << ",\"new_win_id\":" << mon.clients.selected << "}}";
+        return out.str();
+    }
+    case Event::LAYOUT_CHANGE: {
+        if (model.layouts.empty())
+            return std::string();
+        const Layout &layout = model.layouts[rng() % model.layouts.size()];
+        mon.layout.symbol.old = mon.layout.symbol.cur;
+        mon.layout.address.old = mon.layout.address.cur;
+        mon.layout.symbol.cur = layout.symbol;
+        mon.layout.address.cur = layout.address;
+        return layout_change_json(mon);
+    }
+    case Event::MONITOR_FOCUS_CHANGE: {
+        Monitor &old_mon = selected_monitor(model.monitors);
+        old_mon.is_selected = false;
+        mon.is_selected = true;
+        out << "{\"monitor_focus_change_event\":{\"old_monitor_number\":"
+            << old_mon.num << ",\"new_monitor_number\":" << mon.num << "}}";
+        return out.str();
+    }
+    case Event::FOCUSED_TITLE_CHANGE: {
+        if (!client)
+            return std::string();
+        const std::string old_name = client->name;
+        client->name = "vim src/file" + std::to_string(rng() % 1000) + ".cpp";
+        out << "{\"focused_title_change_event\":{\"monitor_number\":"
+            << mon.num << ",\"client_window_id\":" << client->window_id
+            << ",\"old_name\":" << quote(old_name)
+            << ",\"new_name\":" << quote(client->name) << "}}";
+        return out.str();
+    }
+    case Event::FOCUSED_STATE_CHANGE: {
+        if (!client)
+            return std::string();
+        ClientState old_state;
+        old_state.is_fixed = client->states.is_fixed;
+        old_state.is_floating = client->states.is_floating;
+        old_state.is_urgent = client->states.is_urgent;
+        old_state.never_focus = client->states.never_focus;
+        old_state.old_state = client->states.old_state;
+        old_state.is_fullscreen = client->states.is_fullscreen;
+        ClientState new_state = old_state;
+        new_state.is_floating = !new_state.is_floating;
+        client->states.is_floating = new_state.is_floating;
+
+        out << "{\"focused_state_change_event\":{\"monitor_number\":"
+            << mon.num << ",\"client_window_id\":" << client->window_id
+            << ",\"old_state\":";
+        write_client_state(out, old_state);
+        out << ",\"new_state\":";
+        write_client_state(out, new_state);
+        out << "}}";
+        return out.str();
+    }
+    }
+    return std::string();
+}
+
+bool MockServer::Burst::add(const std::string &payload) {
+    Event ev;
+    const char *body;
+    if (!locate_event(payload.c_str(), payload.size() + 1, ev, body))
+        return false;
+
+    append_frame(frames, static_cast<uint8_t>(MessageType::EVENT), payload);
+    ends.push_back(frames.size());
+    types.push_back(static_cast<uint8_t>(ev));
+    mask |= static_cast<uint8_t>(ev);
+    return true;
+}
+
+void MockServer::Burst::clear() {
+    frames.clear();
+    ends.clear();
+    types.clear();
+    mask = 0;
+}
+
+void MockServer::event_loop(const MockEventOptions options) {
+    std::mt19937 rng(options.seed);
+    const unsigned int size = std::max(options.burst, 1u);
+    Burst burst;
+
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.rate > 0 ? 1 / options.rate
+                                                       : 0));
+    auto next = Clock::now();
+    size_t n = 0;
+
+    while ((options.count == 0 || n < options.count) && !events_stopping) {
+        burst.clear();
+        for (unsigned int i = 0;
+             i < size && (options.count == 0 || n < options.count); i++) {
+            if (options.generate)
+                burst.add(options.generate(n));
+            else if (!options.script.empty())
+                burst.add(options.script[n % options.script.size()]);
+            else
+                burst.add(random_event(options.types, rng));
+            n++;
+        }
+
+        this->events += burst.types.size();
+        broadcast(burst);
+
+        if (options.rate > 0) {
+            next += period;
+            std::unique_lock<std::mutex> lock(events_mutex);
+            events_cv.wait_until(lock, next, [this]() {
+                return this->events_stopping.load();
+            });
+        }
+    }
+}
+
+void MockServer::broadcast(Burst &burst) {
+    if (burst.types.empty())
+        return;
+
+    burst.targets.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto &peer : peers)
+            if (peer->subscriptions & burst.mask)
+                burst.targets.push_back(peer.get());
+    }
+
+    for (Peer *peer : burst.targets) {
+        const uint8_t subscriptions = peer->subscriptions;
+        const std::string *out = &burst.frames;
+
+        // Only gather the frames if some of them are not wanted
+        if ((subscriptions & burst.mask) != burst.mask) {
+            burst.out.clear();
+            size_t begin = 0;
+            for (size_t i = 0; i < burst.types.size(); i++) {
+                if (subscriptions & burst.types[i])
+                    burst.out.append(burst.frames, begin,
+                                     burst.ends[i] - begin);
+                begin = burst.ends[i];
+            }
+            out = &burst.out;
+        }
+
+        std::lock_guard<std::mutex> lock(peer->write_mutex);
+        if (peer->closed)
+            continue;
+        try {
+            this->blocked_ns +=
+                write_waiting(peer->fd, out->data(), out->size());
+        } catch (const IPCError &) {
+            // The connection is closed by its own thread
+        }
+    }
+}
+
+size_t MockServer::count_subscribers(const Event ev) const {
+    size_t count = 0;
+    for (const auto &peer : peers)
+        if (peer->subscriptions & static_cast<uint8_t>(ev))
+            count++;
+    return count;
+}
+
+} // namespace dwmipc
@@ -0,0 +1,289 @@
+/**
+ * @file mock_server.hpp
+ *
+ * This file contains the declarations for MockServer, a stand-in for DWM's
+ * IPC socket used to exercise and benchmark dwmipcpp without a running DWM.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dwmipcpp/packet.hpp"
+#include "dwmipcpp/types.hpp"
+
+namespace dwmipc {
+/**
+ * The window manager state reported by a MockServer
+ */
+struct MockModel {
+    std::vector<Monitor> monitors; ///< Reported by GET_MONITORS
+    std::vector<Tag> tags;         ///< Reported by GET_TAGS
+    std::vector<Layout> layouts;   ///< Reported by GET_LAYOUTS
+    std::vector<Client> clients;   ///< Reported by GET_DWM_CLIENT
+
+    /**
+     * Build the model of a typical session. Monitors sit side by side, each
+     * showing its first tag in the first layout, and the clients of each
+     * monitor are spread over its first tags.
+     *
+     * @param monitors The number of monitors
+     * @param tags The number of tags, at most 32
+     * @param clients_per_monitor The number of clients on each monitor
+     */
+    static MockModel synthetic(unsigned int monitors = 2,
+                               unsigned int tags = 9,
+                               unsigned int clients_per_monitor = 4);
+};
+
+/**
+ * How a MockServer generates events
+ */
+struct MockEventOptions {
+    /**
+     * Produce the payload of the nth event, without the null terminator. If
+     * this is set, script is not used.
+     */
+    std::function<std::string(size_t n)> generate;
+
+    /**
+     * Event payloads to send in order, starting over at the end. If this and
+     * generate are empty, random events are made up from the model.
+     */
+    std::vector<std::string> script;
+
+    /**
+     * The types of random events to make up, as a mask of Event values
+     */
+    uint8_t types = 0x3f;
+
+    /**
+     * Bursts to send per second, 0 to send them as fast as the subscribers
+     * read them
+     */
+    double rate = 100;
+
+    /**
+     * Events written together in each burst
+     */
+    unsigned int burst = 1;
+
+    /**
+     * Stop after this many events, 0 to go on until stop_events is called
+     */
+    size_t count = 0;
+
+    /**
+     * Seed for the random events, so that runs can be repeated
+     */
+    unsigned int seed = 1;
+};
+
+/**
+ * Counters describing the traffic handled by a MockServer
+ */
+struct MockServerStats {
+    size_t connections; ///< Connections accepted so far
+    size_t requests;    ///< Requests answered, including subscriptions
+    size_t events;      ///< Events generated, whether or not anyone got them
+    double blocked_ms;  ///< Time spent waiting for clients' full socket
+                        ///< buffers while writing events
+};
+
+/**
+ * A server speaking DWM's IPC protocol on a Unix socket. It answers
+ * GET_MONITORS, GET_TAGS, GET_LAYOUTS, GET_DWM_CLIENT, RUN_COMMAND and
+ * SUBSCRIBE from a MockModel and sends events to the connections subscribed
+ * to them. The view and setlayoutsafe commands update the model and raise
+ * the matching events, any other command only succeeds.
+ *
+ * Each connection is served on its own thread, and events are written by a
+ * thread of their own with blocking writes, so a subscriber that does not
+ * keep up slows the event stream down as it would slow DWM down.
+ */
+class MockServer {
+  public:
+    /**
+     * Start listening on a socket, replacing any socket file at the path
+     *
+     * @param socket_path The path of the socket
+     * @param model The state to report
+     *
+     * @throw ErrnoError if the socket could not be created
+     */
+    MockServer(const std::string &socket_path,
+               const MockModel &model = MockModel::synthetic());
+
+    MockServer(const MockServer &) = delete;
+    MockServer &operator=(const MockServer &) = delete;
+
+    /**
+     * Stop the event stream, close every connection and remove the socket
+     */
+    ~MockServer();
+
+    /**
+     * Start sending a stream of events, replacing any stream already running
+     *
+     * @param options How to generate the events
+     */
+    void start_events(const MockEventOptions &options);
+
+    /**
+     * Stop sending the event stream and wait for it to exit
+     */
+    void stop_events();
+
+    /**
+     * Wait for the event stream to send all of its events
+     */
+    void wait_events();
+
+    /**
+     * Send an event to the connections subscribed to it right away
+     *
+     * @param payload The event payload, without the null terminator
+     */
+    void emit(const std::string &payload);
+
+    /**
+     * Wait until exactly the specified number of connections are subscribed
+     * to an event. Waiting for 0 is useful to know that a connection closed
+     * by the client is gone before starting the next measurement.
+     *
+     * @param ev The event
+     * @param count The number of subscribed connections to wait for
+     * @param timeout_ms How long to wait at most
+     *
+     * @return true if the count was reached, false on timeout
+     */
+    bool wait_subscribers(Event ev, size_t count,
+                          unsigned int timeout_ms = 5000);
+
+    /**
+     * Get a copy of the current model
+     */
+    MockModel get_model() const;
+
+    /**
+     * Replace the model reported from now on
+     */
+    void set_model(const MockModel &model);
+
+    /**
+     * Get the counters of the server
+     */
+    MockServerStats get_stats() const;
+
+    /**
+     * The path of the socket the server listens on
+     */
+    const std::string socket_path;
+
+  private:
+    /**
+     * A connection to the server
+     */
+    struct Peer {
+        int fd; ///< Closed by the destructor, so it is never reused early
+        std::atomic<uint8_t> subscriptions{0};
+        std::mutex write_mutex; ///< Serializes replies and events
+        bool closed = false;    ///< Set under write_mutex once fd is shut down
+        std::thread thread;
+    };
+
+    /**
+     * Events to be written together, along with scratch space for writing
+     * them, reused from one burst to the next
+     */
+    struct Burst {
+        std::string frames;        ///< The framed events, back to back
+        std::vector<size_t> ends;  ///< Offset one past each event's frame
+        std::vector<uint8_t> types; ///< The Event value of each frame
+        uint8_t mask = 0;           ///< The types of all the frames
+
+        std::vector<Peer *> targets; ///< The connections being written to
+        std::string out; ///< Frames gathered for a partly subscribed peer
+
+        /**
+         * Add an event to the burst
+         *
+         * @return false if the payload is not a known event
+         */
+        bool add(const std::string &payload);
+
+        void clear();
+    };
+
+    int listen_fd = -1;
+    std::thread acceptor;
+
+    mutable std::mutex mutex; ///< Protects model and peers
+    std::condition_variable subscribers_changed;
+    MockModel model;
+    std::vector<std::unique_ptr<Peer>> peers;
+    bool shutting_down = false;
+
+    std::thread events_thread;
+    std::mutex events_mutex; ///< Used with events_cv to wait between bursts
+    std::condition_variable events_cv;
+    std::atomic<bool> events_stopping{false};
+
+    std::atomic<size_t> connections{0};
+    std::atomic<size_t> requests{0};
+    std::atomic<size_t> events{0};
+    std::atomic<uint64_t> blocked_ns{0};
+
+    void accept_loop();
+    void serve(Peer *peer);
+    void event_loop(MockEventOptions options);
+
+    /**
+     * Build the reply to a request
+     *
+     * @param peer The connection the request came from
+     * @param type The message type of the request
+     * @param payload The payload of the request
+     * @param raised Set to events raised by the request, such as by a view
+     *   command
+     */
+    std::string answer(Peer *peer, uint8_t type, const std::string &payload,
+                       std::vector<std::string> &raised);
+
+    /**
+     * Run a command against the model. The mutex must be held.
+     */
+    std::string run_command(const std::string &payload,
+                            std::vector<std::string> &raised);
+
+    /**
+     * Make up a random event and apply it to the model
+     *
+     * @return The event payload, empty if the model has no monitors
+     */
+    std::string random_event(uint8_t types, std::mt19937 &rng);
+
+    /**
+     * Write a burst of events to the connections subscribed to them. The
+     * events each connection is subscribed to are written at once.
+     */
+    void broadcast(Burst &burst);
+
+    /**
+     * Count the open connections subscribed to an event. The mutex must be
+     * held.
+     */
+    size_t count_subscribers(Event ev) const;
+};
+
+} // namespace dwmipc
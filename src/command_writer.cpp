@@ -0,0 +1,212 @@
+/**
+ * @file command_writer.cpp
+ *
+ * This file contains the implementation details for the CommandWriter class.
+ */
+
+#include "dwmipcpp/command_writer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace dwmipc {
+static const char COMMAND_PREFIX[] = "{\"command\":";
+static const char ARGS_PREFIX[] = ",\"args\":[";
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+CommandWriter::CommandWriter(Packet &packet, const std::string &name)
+    : packet(packet) {
+    put(COMMAND_PREFIX, sizeof(COMMAND_PREFIX) - 1);
+    string(name.data(), name.size());
+    put(ARGS_PREFIX, sizeof(ARGS_PREFIX) - 1);
+}
+
+void CommandWriter::value(const std::string &arg) {
+    separate();
+    string(arg.data(), arg.size());
+}
+
+void CommandWriter::value(const char *arg) {
+    separate();
+    string(arg, std::strlen(arg));
+}
+
+void CommandWriter::value(const bool arg) {
+    separate();
+    bool_value(arg);
+}
+
+void CommandWriter::values(const Json::Value &arr) {
+    for (const auto &arg : arr) {
+        separate();
+        json_value(arg);
+    }
+}
+
+void CommandWriter::finish() {
+    put("]}", 3); // Includes the terminating null
+
+    packet.size = pos + Packet::HEADER_SIZE;
+    packet.header->size = pos;
+    packet.header->type = static_cast<uint8_t>(MessageType::RUN_COMMAND);
+}
+
+char *CommandWriter::grow(const size_t n) {
+    const uint32_t needed = pos + n;
+    if (needed > packet.capacity)
+        packet.reserve(std::max(needed, packet.capacity * 2));
+    return packet.payload + pos;
+}
+
+void CommandWriter::put(const char c) {
+    *grow(1) = c;
+    pos++;
+}
+
+void CommandWriter::put(const char *str, const size_t len) {
+    std::memcpy(grow(len), str, len);
+    pos += len;
+}
+
+void CommandWriter::separate() {
+    if (!first)
+        put(',');
+    first = false;
+}
+
+void CommandWriter::string(const char *str, const size_t len) {
+    // Every character takes at most 6 bytes when escaped, so reserve the worst
+    // case once instead of checking each character
+    char *out = grow(len * 6 + 2);
+    char *const start = out;
+
+    *out++ = '"';
+    for (size_t i = 0; i < len; i++) {
+        const unsigned char c = str[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            *out++ = c;
+            continue;
+        }
+
+        *out++ = '\\';
+        switch (c) {
+        case '"':
+        case '\\':
+            *out++ = c;
+            break;
+        case '\b':
+            *out++ = 'b';
+            break;
+        case '\f':
+            *out++ = 'f';
+            break;
+        case '\n':
+            *out++ = 'n';
+            break;
+        case '\r':
+            *out++ = 'r';
+            break;
+        case '\t':
+            *out++ = 't';
+            break;
+        default:
+            *out++ = 'u';
+            *out++ = '0';
+            *out++ = '0';
+            *out++ = HEX_DIGITS[c >> 4];
+            *out++ = HEX_DIGITS[c & 0xf];
+            break;
+        }
+    }
+    *out++ = '"';
+
+    pos += out - start;
+}
+
+void CommandWriter::bool_value(const bool arg) {
+    if (arg)
+        put("true", 4);
+    else
+        put("false", 5);
+}
+
+void CommandWriter::int_value(const int64_t arg) {
+    if (arg >= 0) {
+        uint_value(arg);
+        return;
+    }
+
+    put('-');
+    // Negate in unsigned arithmetic so INT64_MIN does not overflow
+    uint_value(0 - static_cast<uint64_t>(arg));
+}
+
+void CommandWriter::uint_value(uint64_t arg) {
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[sizeof(digits) - ++n] = '0' + arg % 10;
+        arg /= 10;
+    } while (arg != 0);
+    put(digits + sizeof(digits) - n, n);
+}
+
+void CommandWriter::double_value(const double arg) {
+    if (!std::isfinite(arg)) {
+        put("null", 4);
+        return;
+    }
+
+    // Same precision as jsoncpp's writer
+    char buf[32];
+    const int len = std::snprintf(buf, sizeof(buf), "%.17g", arg);
+
+    // snprintf uses the decimal separator of LC_NUMERIC, so put back the one
+    // JSON requires, as jsoncpp's writer does
+    std::replace(buf, buf + len, ',', '.');
+    put(buf, len);
+
+    // Keep the decimal point so DWM sees a float and not an integer
+    if (!std::strpbrk(buf, ".e"))
+        put(".0", 2);
+}
+
+void CommandWriter::json_value(const Json::Value &arg) {
+    const char *begin;
+    const char *end;
+
+    switch (arg.type()) {
+    case Json::nullValue:
+        put("null", 4);
+        break;
+    case Json::intValue:
+        int_value(arg.asInt64());
+        break;
+    case Json::uintValue:
+        uint_value(arg.asUInt64());
+        break;
+    case Json::realValue:
+        double_value(arg.asDouble());
+        break;
+    case Json::booleanValue:
+        bool_value(arg.asBool());
+        break;
+    case Json::stringValue:
+        arg.getString(&begin, &end);
+        string(begin, end - begin);
+        break;
+    default: {
+        // Nested arrays and objects are not used by any DWM command, so just
+        // let jsoncpp serialize them
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+        const std::string json = Json::writeString(builder, arg);
+        put(json.data(), json.size());
+        break;
+    }
+    }
+}
+
+} // namespace dwmipc
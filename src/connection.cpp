@@ -5,144 +5,39 @@
  * well as some helper functions for writing/reading sockets.
  */
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
 #include <json/json.h>
+#include <poll.h>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
 
 #include "dwmipcpp/connection.hpp"
+#include "dwmipcpp/decoder.hpp"
 #include "dwmipcpp/errors.hpp"
+#include "dwmipcpp/static_packet.hpp"
 #include "dwmipcpp/util.hpp"
 
 namespace dwmipc {
-/**
- * Parse a reply packet from DWM into a Json::Value. Throw a ResultFailureError
- * if DWM sends an error reply.
- */
-static void pre_parse_reply(Json::Value &root,
-                            const std::shared_ptr<Packet> &reply) {
-    const char *start = reply->payload;
-    const char *end = start + reply->header->size - 1;
-
-    std::string errs;
-
-    const Json::CharReaderBuilder builder;
-    const auto reader = builder.newCharReader();
-    reader->parse(start, end, &root, &errs);
-
-    // Not properly documented, but if the reply is an array any type of
-    // function that checks for the existance of a key throws a Json::LogicError
-    if (!root.isArray() && root.get("result", "") == "error")
-        throw ResultFailureError(root["reason"].asString());
-
-    delete reader;
-}
+constexpr size_t Connection::PIPELINE_DEPTH;
 
 /**
- * Parse a Event::TAG_CHANGE message
+ * The Connection whose I/O thread is the current thread, if any
  */
-static void parse_tag_change_event(const Json::Value &root,
-                                   TagChangeEvent &event) {
-    const std::string ev_name = event_map.at(Event::TAG_CHANGE);
-    auto v_event = root[ev_name];
-    auto v_old_state = v_event["old_state"];
-    auto v_new_state = v_event["new_state"];
-
-    event.monitor_num = v_event["monitor_number"].asUInt();
-    event.old_state.selected = v_old_state["selected"].asUInt();
-    event.old_state.occupied = v_old_state["occupied"].asUInt();
-    event.old_state.urgent = v_old_state["urgent"].asUInt();
-    event.new_state.selected = v_new_state["selected"].asUInt();
-    event.new_state.occupied = v_new_state["occupied"].asUInt();
-    event.new_state.urgent = v_new_state["urgent"].asUInt();
-}
+static thread_local const Connection *io_thread_owner = nullptr;
 
 /**
- * Parse a Event::LAYOUT_CHANGE message
+ * Every Event bit DWM knows about
  */
-static void parse_layout_change_event(const Json::Value &root,
-                                      LayoutChangeEvent &event) {
-    const std::string ev_name = event_map.at(Event::LAYOUT_CHANGE);
-    auto v_event = root[ev_name];
-
-    event.monitor_num = v_event["monitor_number"].asUInt();
-    event.old_symbol = v_event["old_symbol"].asString();
-    event.old_address = v_event["old_address"].asUInt64();
-    event.new_symbol = v_event["new_symbol"].asString();
-    event.new_address = v_event["new_address"].asUInt64();
-}
-
-/**
- * Parse a Event::CLIENT_FOCUS_CHANGE message
- */
-static void parse_client_focus_change_event(const Json::Value &root,
-                                            ClientFocusChangeEvent &event) {
-    const std::string ev_name = event_map.at(Event::CLIENT_FOCUS_CHANGE);
-    auto v_event = root[ev_name];
-
-    event.monitor_num = v_event["monitor_number"].asUInt();
-    event.old_win_id = v_event["old_win_id"].asUInt();
-    event.new_win_id = v_event["new_win_id"].asUInt();
-}
-
-/**
- * Parse a Event::FOCUSED_TITLE_CHANGE message
- */
-static void parse_focused_title_change_event(const Json::Value &root,
-                                             FocusedTitleChangeEvent &event) {
-    const std::string ev_name = event_map.at(Event::FOCUSED_TITLE_CHANGE);
-    auto v_event = root[ev_name];
-
-    event.monitor_num = v_event["monitor_number"].asUInt();
-    event.client_window_id = v_event["client_window_id"].asUInt();
-    event.old_name = v_event["old_name"].asString();
-    event.new_name = v_event["new_name"].asString();
-}
-
-/**
- * Parse a Event::MONITOR_FOCUS_CHANGE message
- */
-static void parse_monitor_focus_change(const Json::Value &root,
-                                       MonitorFocusChangeEvent &event) {
-    const std::string ev_name = event_map.at(Event::MONITOR_FOCUS_CHANGE);
-    auto v_event = root[ev_name];
-
-    event.old_mon_num = v_event["old_monitor_number"].asUInt();
-    event.new_mon_num = v_event["new_monitor_number"].asUInt();
-}
-
-/**
- * Parse a Event::FOCUSED_STATE_CHANGE message
- */
-static void parse_focused_state_change_event(const Json::Value &root,
-                                             FocusedStateChangeEvent &event) {
-    const std::string ev_name = event_map.at(Event::FOCUSED_STATE_CHANGE);
-    auto v_event = root[ev_name];
-    auto v_old_state = v_event["old_state"];
-    auto v_new_state = v_event["new_state"];
-
-    event.monitor_num = v_event["monitor_number"].asUInt();
-    event.client_window_id = v_event["client_window_id"].asUInt();
-
-    event.old_state.old_state = v_old_state["old_state"].asBool();
-    event.old_state.is_fixed = v_old_state["is_fixed"].asBool();
-    event.old_state.is_floating = v_old_state["is_floating"].asBool();
-    event.old_state.is_fullscreen = v_old_state["is_fullscreen"].asBool();
-    event.old_state.is_urgent = v_old_state["is_urgent"].asBool();
-    event.old_state.never_focus = v_old_state["never_focus"].asBool();
-
-    event.new_state.old_state = v_new_state["old_state"].asBool();
-    event.new_state.is_fixed = v_new_state["is_fixed"].asBool();
-    event.new_state.is_floating = v_new_state["is_floating"].asBool();
-    event.new_state.is_fullscreen = v_new_state["is_fullscreen"].asBool();
-    event.new_state.is_urgent = v_new_state["is_urgent"].asBool();
-    event.new_state.never_focus = v_new_state["never_focus"].asBool();
-}
+static constexpr uint8_t ALL_EVENTS =
+    (static_cast<uint8_t>(Event::FOCUSED_STATE_CHANGE) << 1) - 1;
 
 Connection::Connection(const std::string &socket_path, bool connect)
     : socket_path(socket_path) {
@@ -153,6 +48,8 @@ Connection::Connection(const std::string &socket_path, bool connect)
 }
 
 Connection::~Connection() {
+    stop_io_thread();
+
     if (is_main_socket_connected())
         disconnect_main_socket();
 
@@ -164,6 +61,7 @@ bool Connection::is_main_socket_connected() {
     if (this->main_sockfd != -1 && !is_socket_alive(this->main_sockfd)) {
         dwmipc::disconnect(this->main_sockfd);
         this->main_sockfd = -1;
+        main_reader.clear();
     }
 
     return this->main_sockfd != -1;
@@ -171,8 +69,10 @@ bool Connection::is_main_socket_connected() {
 
 bool Connection::is_event_socket_connected() {
     if (this->event_sockfd != -1 && !is_socket_alive(this->event_sockfd)) {
+        pause_event_thread();
         dwmipc::disconnect(this->event_sockfd);
         this->event_sockfd = -1;
+        event_reader.clear();
     }
 
     return this->event_sockfd != -1;
@@ -183,6 +83,7 @@ void Connection::connect_main_socket() {
         throw InvalidOperationError(
             "Cannot connect to main socket. Already connected.");
     this->main_sockfd = dwmipc::connect(socket_path, true);
+    main_reader.clear();
 }
 
 void Connection::connect_event_socket() {
@@ -190,6 +91,8 @@ void Connection::connect_event_socket() {
         throw InvalidOperationError(
             "Cannot connect to event socket. Already connected.");
     this->event_sockfd = dwmipc::connect(socket_path, false);
+    this->event_socket_generation++;
+    event_reader.clear();
     resubscribe();
 }
 
@@ -199,14 +102,17 @@ void Connection::disconnect_main_socket() {
             "Cannot disconnect from main socket. Already disconnected.");
     dwmipc::disconnect(this->main_sockfd);
     this->main_sockfd = -1;
+    main_reader.clear();
 }
 
 void Connection::disconnect_event_socket() {
     if (this->event_sockfd == -1)
         throw InvalidOperationError(
             "Cannot disconnect from event socket. Already disconnected.");
+    pause_event_thread();
     dwmipc::disconnect(this->event_sockfd);
     this->event_sockfd = -1;
+    event_reader.clear();
 }
 
 int Connection::get_socket_fd(const MessageType type) const {
@@ -218,131 +124,512 @@ int Connection::get_socket_fd(const MessageType type) const {
 }
 
 void Connection::assert_socket_connected(const MessageType type) {
-    int sockfd = get_socket_fd(type);
+    const bool is_event =
+        type == MessageType::SUBSCRIBE || type == MessageType::EVENT;
 
     // Check if appropriate socket is connected
-    if (sockfd == this->main_sockfd && !is_main_socket_connected())
-        throw SocketClosedError("Disconnected main socket: Cannot read/write");
-    else if (sockfd == this->event_sockfd && !is_event_socket_connected())
-        throw SocketClosedError("Disconnected event socket: Cannot read/write");
+    if (is_event) {
+        const bool was_open = this->event_sockfd != -1;
+        if (is_event_socket_connected())
+            return;
+        // A socket that was open but found dead was lost, rather than closed
+        // on purpose, so try to get it back
+        if (!was_open || !reconnect_socket(true))
+            throw SocketClosedError(
+                "Disconnected event socket: Cannot read/write");
+    } else {
+        const bool was_open = this->main_sockfd != -1;
+        if (is_main_socket_connected())
+            return;
+        if (!was_open || !reconnect_socket(false))
+            throw SocketClosedError(
+                "Disconnected main socket: Cannot read/write");
+    }
 }
 
 void Connection::resubscribe() {
-    uint8_t mask = 1;
-
-    while (mask < subscriptions) {
-        if (subscriptions & mask) {
-            auto ev = static_cast<Event>(mask);
-            subscribe(ev);
-        }
-        mask <<= 1;
-    }
+    if (subscriptions)
+        subscribe_mask(subscriptions, true);
 }
 
 std::shared_ptr<Packet> Connection::dwm_msg(const MessageType type,
                                             const std::string &msg) {
-    auto packet = std::make_shared<Packet>(type, msg);
-    auto sockfd = get_socket_fd(type);
+    const auto packet = packet_pool.acquire(type, msg);
+    return dwm_msg(packet->view());
+}
+
+std::shared_ptr<Packet> Connection::dwm_msg(const PacketView &request) {
+    const MessageType type = static_cast<MessageType>(request.type);
+    const bool is_event = type == MessageType::SUBSCRIBE;
+
+    // The I/O thread may be using the main socket
+    std::unique_lock<std::recursive_mutex> lock(main_mutex, std::defer_lock);
+    if (!is_event)
+        lock.lock();
 
     // Throw error if disconnected socket
     assert_socket_connected(type);
 
-    try {
-        send_message(sockfd, packet);
-    } catch (const SocketClosedError &err) {
-        if (type == MessageType::SUBSCRIBE)
-            disconnect_event_socket();
+    std::shared_ptr<Packet> reply;
+    for (bool retried = false;; retried = true) {
+        const int sockfd = get_socket_fd(type);
+        bool sent = false;
+
+        try {
+            record_sent(is_event ? SocketRole::EVENT : SocketRole::MAIN,
+                        &request, 1);
+            swrite(sockfd, request.data, request.size);
+            sent = true;
+            reply = recv_reply(sockfd);
+            break;
+        } catch (const SocketClosedError &err) {
+            if (is_event)
+                disconnect_event_socket();
+            else
+                disconnect_main_socket();
+
+            if (retried || !reconnect_socket(is_event))
+                throw;
+
+            // DWM may have run the command before the socket was lost, so
+            // only a command that was never sent can safely be resent
+            if (type == MessageType::RUN_COMMAND && sent)
+                throw;
+        }
+    }
+
+    // Check if message type matches
+    if (reply->header->type != static_cast<uint8_t>(type))
+        throw ReplyError(static_cast<uint8_t>(type), reply->header->type);
+
+    return reply;
+}
+
+std::shared_ptr<Packet> Connection::recv_reply(const int sockfd) {
+    FrameReader &reader =
+        sockfd == this->main_sockfd ? main_reader : event_reader;
+
+    Frame frame;
+    bool drained;
+    while (true) {
+        while (!reader.next(frame)) {
+            if (fill_reader(reader, sockfd, drained) > 0)
+                continue;
+
+            // The event socket is non-blocking, so wait for the rest of the
+            // reply
+            struct pollfd pfd = {sockfd, POLLIN, 0};
+            if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+                throw ErrnoError("Error waiting for reply");
+        }
+        record_received(reader, frame);
+
+        // Events raised before DWM answers are kept for handle_events
+        if (sockfd == this->event_sockfd &&
+            frame.type == static_cast<uint8_t>(MessageType::EVENT)) {
+            if (!event_filter.accepts(frame.payload, frame.size))
+                continue;
+            auto event = packet_pool.acquire();
+            event->assign(frame.type, frame.payload, frame.size);
+            deferred_events.push_back(event);
+            continue;
+        }
+        break;
+    }
+
+    // Copy the payload out, since the buffer is reused by the next read
+    auto reply = packet_pool.acquire();
+    reply->assign(frame.type, frame.payload, frame.size);
+    packet_pool.observe(frame.size);
+    return reply;
+}
+
+size_t Connection::fill_reader(FrameReader &reader, const int sockfd,
+                               bool &drained) {
+    const size_t n = reader.fill(sockfd, drained);
+    if (recorder && n > 0) {
+        const auto now = TrafficRecorder::Clock::now();
+        if (&reader == &main_reader)
+            this->main_filled = now;
         else
-            disconnect_main_socket();
-        throw;
+            this->event_filled = now;
     }
+    return n;
+}
 
-    std::shared_ptr<Packet> reply;
+void Connection::record_received(const FrameReader &reader,
+                                 const Frame &frame) {
+    if (!recorder)
+        return;
+
+    if (&reader == &main_reader)
+        recorder->record(main_filled, SocketRole::MAIN, Direction::RECEIVED,
+                         frame.type, frame.payload, frame.size);
+    else
+        recorder->record(event_filled, SocketRole::EVENT, Direction::RECEIVED,
+                         frame.type, frame.payload, frame.size);
+}
+
+void Connection::record_sent(const SocketRole role,
+                             const PacketView *requests, const size_t count) {
+    if (!recorder)
+        return;
+
+    for (size_t i = 0; i < count; i++)
+        recorder->record_sent(role, requests[i]);
+}
+
+bool Connection::reconnect_socket(const bool event_socket) {
+    // Resubscribing while reconnecting the event socket may lose the socket
+    // again. The outer attempt handles that, so don't start another one.
+    if (!reconnect_policy.enabled ||
+        (event_socket && (event_reconnecting || !event_reconnect_blocking)))
+        return false;
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto &backoff = reconnect_policy.backoff_ms;
+    size_t attempt = 0;
+
+    if (event_socket)
+        event_reconnecting = true;
+
+    while (true) {
+        const unsigned int delay_ms =
+            backoff.empty() ? 0
+                            : backoff[std::min(attempt, backoff.size() - 1)];
+        const auto elapsed_ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+
+        if (reconnect_policy.timeout_ms != 0 &&
+            elapsed_ms + delay_ms > reconnect_policy.timeout_ms) {
+            if (event_socket)
+                event_reconnecting = false;
+            return false;
+        }
+
+        if (delay_ms > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+
+        try {
+            if (event_socket)
+                connect_event_socket();
+            else
+                connect_main_socket();
+            break;
+        } catch (const IPCError &) {
+            // Resubscribing may have failed after the socket was connected
+            if (event_socket && this->event_sockfd != -1)
+                disconnect_event_socket();
+        }
+        attempt++;
+    }
+
+    if (event_socket)
+        event_reconnecting = false;
+
+    if (on_reconnected)
+        on_reconnected();
+    return true;
+}
+
+void Connection::set_reconnect_policy(const ReconnectPolicy &policy) {
+    this->reconnect_policy = policy;
+}
+
+const ReconnectPolicy &Connection::get_reconnect_policy() const {
+    return this->reconnect_policy;
+}
+
+void Connection::set_event_reconnect_blocking(const bool blocking) {
+    this->event_reconnect_blocking = blocking;
+}
+
+bool Connection::is_event_reconnect_blocking() const {
+    return this->event_reconnect_blocking;
+}
+
+bool Connection::try_reconnect_event_socket() {
+    if (is_event_socket_connected())
+        return true;
+
+    // A failure to resubscribe must not start a reconnect of its own
+    event_reconnecting = true;
     try {
-        reply = recv_message(sockfd, true);
-    } catch (const SocketClosedError &err) {
-        if (type == MessageType::SUBSCRIBE)
+        connect_event_socket();
+    } catch (const IPCError &) {
+        // Resubscribing may have failed after the socket was connected
+        if (this->event_sockfd != -1)
             disconnect_event_socket();
-        else
-            disconnect_main_socket();
-        throw;
+        event_reconnecting = false;
+        return false;
     }
+    event_reconnecting = false;
 
-    // Check if message type matches
-    if (packet->header->type != static_cast<uint8_t>(type))
-        throw ReplyError(packet->header->type, static_cast<uint8_t>(type));
+    if (on_reconnected)
+        on_reconnected();
+    return true;
+}
 
-    return reply;
+bool Connection::has_pending_events() const {
+    // The event thread owns event_reader while it runs
+    if (event_thread.running())
+        return !deferred_events.empty() || !event_thread.empty();
+
+    return !deferred_events.empty() || !event_thread.empty() ||
+           event_reader.buffered() > 0 || event_thread_enabled;
 }
 
-std::shared_ptr<std::vector<Monitor>> Connection::get_monitors() {
-    auto reply = dwm_msg(MessageType::GET_MONITORS);
-    Json::Value root;
-    pre_parse_reply(root, reply);
-    auto monitors = std::make_shared<std::vector<Monitor>>();
+void Connection::start_event_thread(const size_t capacity) {
+    if (event_thread_enabled)
+        throw InvalidOperationError(
+            "Cannot start event thread. Already started.");
+
+    event_thread.init(capacity);
+    event_thread_enabled = true;
+    resume_event_thread();
+}
+
+void Connection::stop_event_thread() {
+    pause_event_thread();
+    event_thread_enabled = false;
+}
+
+bool Connection::is_event_thread_enabled() const {
+    return this->event_thread_enabled;
+}
+
+EventThreadStats Connection::get_event_thread_stats() const {
+    return event_thread.get_stats();
+}
+
+int Connection::get_event_wait_fd() const {
+    if (this->event_sockfd == -1 || !this->event_thread_enabled)
+        return this->event_sockfd;
+    return event_thread.notify_fd();
+}
+
+void Connection::resume_event_thread() {
+    if (event_thread_enabled && !event_thread.running() &&
+        this->event_sockfd != -1)
+        event_thread.start(this->event_sockfd, event_reader, decoder,
+                           event_filter, recorder.get());
+}
 
-    for (Json::Value v_mon : root) {
-        Monitor mon;
+void Connection::pause_event_thread() {
+    event_thread.stop();
 
-        mon.master_factor = v_mon["master_factor"].asFloat();
-        mon.num_master = v_mon["num_master"].asInt();
-        mon.num = v_mon["num"].asUInt();
-        mon.is_selected = v_mon["is_selected"].asBool();
+    // Anything deferred from now on was received after the queued events
+    event_thread_backlog = event_thread.size();
+}
+
+void Connection::set_traffic_recorder(
+    const std::shared_ptr<TrafficRecorder> &recorder) {
+    // The I/O thread and the event thread record as they go. handle_events
+    // resumes the event thread.
+    std::lock_guard<std::recursive_mutex> lock(main_mutex);
+    pause_event_thread();
+    this->recorder = recorder;
+}
+
+void Connection::replay_message(const uint8_t type, const char *payload,
+                                const uint32_t size, const bool batch_end) {
+    if (type == static_cast<uint8_t>(MessageType::EVENT)) {
+        handle_event_payload(payload, size);
+        dispatch_coalesced(batch_end);
+        return;
+    }
+
+    auto reply = packet_pool.acquire();
+    reply->assign(type, payload, size);
+
+    switch (static_cast<MessageType>(type)) {
+    case MessageType::GET_MONITORS:
+        parse_monitors_reply(reply);
+        break;
+    case MessageType::GET_TAGS:
+        parse_tags_reply(reply);
+        break;
+    case MessageType::GET_LAYOUTS:
+        parse_layouts_reply(reply);
+        break;
+    case MessageType::GET_DWM_CLIENT:
+        parse_client_reply(reply);
+        break;
+    default:
+        // Commands and subscriptions only report a result
+        Json::Value root;
+        pre_parse_reply(root, reply->payload, reply->header->size);
+        break;
+    }
+}
+
+void Connection::set_event_filter(const EventFilter &filter) {
+    // The event thread filters with its own copy. handle_events resumes it.
+    pause_event_thread();
+    this->event_filter = filter;
+
+    // Queued events passed the old filter, not necessarily this one
+    event_thread_stale = event_thread.size();
+}
+
+const EventFilter &Connection::get_event_filter() const {
+    return this->event_filter;
+}
+
+void Connection::set_coalesce_policy(const Event ev,
+                                     const CoalescePolicy &policy) {
+    coalescer.set_policy(ev, policy);
+}
+
+const CoalescePolicy &Connection::get_coalesce_policy(const Event ev) const {
+    return coalescer.get_policy(ev);
+}
+
+int Connection::get_coalesce_timeout_ms() const {
+    return coalescer.get_timeout_ms();
+}
 
-        auto v_monitor_geom = v_mon["monitor_geometry"];
-        mon.monitor_geom.x = v_monitor_geom["x"].asInt();
-        mon.monitor_geom.y = v_monitor_geom["y"].asInt();
-        mon.monitor_geom.width = v_monitor_geom["width"].asInt();
-        mon.monitor_geom.height = v_monitor_geom["height"].asInt();
+unsigned int Connection::get_event_socket_generation() const {
+    return this->event_socket_generation;
+}
 
-        auto v_window_geom = v_mon["window_geometry"];
-        mon.window_geom.x = v_window_geom["x"].asInt();
-        mon.window_geom.y = v_window_geom["y"].asInt();
-        mon.window_geom.width = v_window_geom["width"].asInt();
-        mon.window_geom.height = v_window_geom["height"].asInt();
+void Connection::set_thread_safe(const bool enabled) {
+    this->thread_safe = enabled;
+}
 
-        auto v_layout = v_mon["layout"];
-        auto v_symbol = v_layout["symbol"];
-        mon.layout.symbol.cur = v_symbol["current"].asString();
-        mon.layout.symbol.old = v_symbol["old"].asString();
+bool Connection::is_thread_safe() const { return this->thread_safe; }
 
-        auto v_address = v_layout["address"];
-        mon.layout.address.cur = v_address["current"].asUInt64();
-        mon.layout.address.old = v_address["old"].asUInt64();
+PacketPoolStats Connection::get_packet_pool_stats() const {
+    return packet_pool.get_stats();
+}
 
-        auto v_bar = v_mon["bar"];
-        mon.bar.y = v_bar["y"].asInt();
-        mon.bar.is_shown = v_bar["is_shown"].asBool();
-        mon.bar.is_top = v_bar["is_top"].asBool();
-        mon.bar.window_id = v_bar["window_id"].asUInt();
+std::vector<std::shared_ptr<Packet>>
+Connection::dwm_msgs(const PacketView *requests, const size_t count) {
+    std::vector<std::shared_ptr<Packet>> replies;
+    pipeline(requests, count, replies);
 
-        auto v_tagset = v_mon["tagset"];
-        mon.tagset.cur = v_tagset["current"].asUInt();
-        mon.tagset.old = v_tagset["old"].asUInt();
+    // Replies come back in the order the requests were sent
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t type = requests[i].type;
+        if (replies[i]->header->type != type)
+            throw ReplyError(type, replies[i]->header->type);
+    }
 
-        auto v_tag_state = v_mon["tag_state"];
-        mon.tag_state.selected = v_tag_state["selected"].asUInt();
-        mon.tag_state.occupied = v_tag_state["occupied"].asUInt();
-        mon.tag_state.urgent = v_tag_state["urgent"].asUInt();
+    return replies;
+}
+
+void Connection::pipeline(const PacketView *requests, const size_t count,
+                          std::vector<std::shared_ptr<Packet>> &replies) {
+    std::vector<struct iovec> iov;
+    replies.clear();
 
-        auto v_clients = v_mon["clients"];
-        mon.clients.selected = v_clients["selected"].asUInt();
+    // The I/O thread and the calling thread may both pipeline requests
+    std::lock_guard<std::recursive_mutex> lock(main_mutex);
+
+    // Throw error if disconnected socket
+    assert_socket_connected(MessageType::GET_MONITORS);
+
+    replies.reserve(count);
+    iov.reserve(std::min(count, PIPELINE_DEPTH));
+
+    bool retried = false;
+    while (replies.size() < count) {
+        // Resume after the last request that was answered
+        const size_t first = replies.size();
+        const size_t last = std::min(first + PIPELINE_DEPTH, count);
+
+        iov.clear();
+        for (size_t i = first; i < last; i++) {
+            struct iovec v;
+            // writev does not modify the buffers
+            v.iov_base = const_cast<uint8_t *>(requests[i].data);
+            v.iov_len = requests[i].size;
+            iov.push_back(v);
+        }
 
-        for (Json::Value v : v_clients["stack"])
-            mon.clients.stack.push_back(v.asUInt());
+        try {
+            // Write the whole chunk back to back, then collect the replies
+            record_sent(SocketRole::MAIN, requests + first, last - first);
+            swritev(main_sockfd, iov.data(), iov.size());
+            for (size_t i = first; i < last; i++)
+                replies.push_back(recv_reply(main_sockfd));
+        } catch (const SocketClosedError &err) {
+            disconnect_main_socket();
 
-        for (Json::Value v : v_clients["all"])
-            mon.clients.all.push_back(v.asUInt());
+            if (retried || !reconnect_socket(false))
+                throw;
+            retried = true;
 
-        monitors->push_back(mon);
+            // Unanswered commands may or may not have been run by DWM.
+            // Commands answered before the socket was lost are safe.
+            for (size_t i = replies.size(); i < last; i++)
+                if (requests[i].type ==
+                    static_cast<uint8_t>(MessageType::RUN_COMMAND))
+                    throw;
+        }
     }
+}
+
+bool Connection::use_io_thread() const {
+    return this->thread_safe && io_thread_owner != this;
+}
+
+std::shared_ptr<Packet> Connection::send_request(const PacketView &request) {
+    if (!use_io_thread())
+        return dwm_msg(request);
+
+    // The caller blocks until the reply arrives, so the bytes of request
+    // outlive the queued request. The reply is decoded by the caller.
+    return submit<std::shared_ptr<Packet>>(
+               request, nullptr,
+               [](const std::shared_ptr<Packet> &reply) { return reply; })
+        .get();
+}
+
+std::vector<std::shared_ptr<Packet>>
+Connection::send_requests(const PacketView *requests, const size_t count) {
+    if (!use_io_thread())
+        return dwm_msgs(requests, count);
+
+    std::vector<std::future<std::shared_ptr<Packet>>> futures;
+    futures.reserve(count);
+    for (size_t i = 0; i < count; i++)
+        futures.push_back(submit<std::shared_ptr<Packet>>(
+            requests[i], nullptr,
+            [](const std::shared_ptr<Packet> &reply) { return reply; }));
+
+    // Wait for every request before throwing, since the queued requests refer
+    // to the caller's buffers
+    for (auto &future : futures)
+        future.wait();
+
+    std::vector<std::shared_ptr<Packet>> replies;
+    replies.reserve(count);
+    for (auto &future : futures)
+        replies.push_back(future.get());
+    return replies;
+}
+
+std::shared_ptr<std::vector<Monitor>>
+Connection::parse_monitors_reply(const std::shared_ptr<Packet> &reply) const {
+    auto monitors = std::make_shared<std::vector<Monitor>>();
+
+    if (decoder == Decoder::STREAMING &&
+        decode_monitors(reply->payload, reply->header->size, *monitors))
+        return monitors;
+
+    Json::Value root;
+    pre_parse_reply(root, reply->payload, reply->header->size);
+    parse_monitors(root, *monitors);
     return monitors;
 }
 
-std::shared_ptr<std::vector<Tag>> Connection::get_tags() {
-    auto reply = dwm_msg(MessageType::GET_TAGS);
+std::shared_ptr<std::vector<Tag>>
+Connection::parse_tags_reply(const std::shared_ptr<Packet> &reply) const {
     Json::Value root;
-    pre_parse_reply(root, reply);
+    pre_parse_reply(root, reply->payload, reply->header->size);
     auto tags = std::make_shared<std::vector<Tag>>();
 
     for (Json::Value v_tag : root) {
@@ -355,10 +642,10 @@ std::shared_ptr<std::vector<Tag>> Connection::get_tags() {
     return tags;
 }
 
-std::shared_ptr<std::vector<Layout>> Connection::get_layouts() {
-    auto reply = dwm_msg(MessageType::GET_LAYOUTS);
+std::shared_ptr<std::vector<Layout>>
+Connection::parse_layouts_reply(const std::shared_ptr<Packet> &reply) const {
     Json::Value root;
-    pre_parse_reply(root, reply);
+    pre_parse_reply(root, reply->payload, reply->header->size);
     auto layouts = std::make_shared<std::vector<Layout>>();
 
     for (Json::Value v_lt : root) {
@@ -372,88 +659,170 @@ std::shared_ptr<std::vector<Layout>> Connection::get_layouts() {
     return layouts;
 }
 
+std::shared_ptr<Client>
+Connection::parse_client_reply(const std::shared_ptr<Packet> &reply) const {
+    auto client = std::make_shared<Client>();
+    parse_client_reply(reply, *client);
+    return client;
+}
+
+void Connection::parse_client_reply(const std::shared_ptr<Packet> &reply,
+                                    Client &client) const {
+    if (decoder == Decoder::STREAMING &&
+        decode_client(reply->payload, reply->header->size, client))
+        return;
+
+    Json::Value root;
+    pre_parse_reply(root, reply->payload, reply->header->size);
+    parse_client(root, client);
+}
+
+std::shared_ptr<std::vector<Monitor>> Connection::get_monitors() {
+    auto reply = send_request(static_request(MessageType::GET_MONITORS));
+    return parse_monitors_reply(reply);
+}
+
+std::shared_ptr<std::vector<Tag>> Connection::get_tags() {
+    auto reply = send_request(static_request(MessageType::GET_TAGS));
+    return parse_tags_reply(reply);
+}
+
+std::shared_ptr<std::vector<Layout>> Connection::get_layouts() {
+    auto reply = send_request(static_request(MessageType::GET_LAYOUTS));
+    return parse_layouts_reply(reply);
+}
+
 std::shared_ptr<Client> Connection::get_client(Window win_id) {
     // No need to generate the JSON using library since it is so simple
     // Format: { "client_window_id": <window id> }
     const std::string msg =
         "{\"client_window_id\":" + std::to_string(win_id) + "}";
-    auto reply = dwm_msg(MessageType::GET_DWM_CLIENT, msg);
-    Json::Value root;
-    pre_parse_reply(root, reply);
-    auto client = std::make_shared<Client>();
+    const auto packet = packet_pool.acquire(MessageType::GET_DWM_CLIENT, msg);
+    return parse_client_reply(send_request(packet->view()));
+}
 
-    client->name = root["name"].asString();
-    client->tags = root["tags"].asUInt();
-    client->window_id = root["window_id"].asUInt();
-    client->monitor_num = root["monitor_num"].asUInt();
-
-    auto v_geom = root["geometry"];
-    auto v_geom_cur = v_geom["current"];
-    client->geom.cur.x = v_geom_cur["x"].asInt();
-    client->geom.cur.y = v_geom_cur["y"].asInt();
-    client->geom.cur.width = v_geom_cur["width"].asInt();
-    client->geom.cur.height = v_geom_cur["height"].asInt();
-
-    auto v_geom_old = v_geom["old"];
-    client->geom.old.x = v_geom_old["x"].asInt();
-    client->geom.old.y = v_geom_old["y"].asInt();
-    client->geom.old.width = v_geom_old["width"].asInt();
-    client->geom.old.height = v_geom_old["height"].asInt();
-
-    auto v_size_hints = root["size_hints"];
-    auto v_base = v_size_hints["base"];
-    client->size_hints.base.width = v_base["width"].asInt();
-    client->size_hints.base.height = v_base["height"].asInt();
-
-    auto v_step = v_size_hints["step"];
-    client->size_hints.step.width = v_step["width"].asInt();
-    client->size_hints.step.height = v_step["height"].asInt();
-
-    auto v_max = v_size_hints["max"];
-    client->size_hints.max.width = v_max["width"].asInt();
-    client->size_hints.max.height = v_max["height"].asInt();
-
-    auto v_min = v_size_hints["min"];
-    client->size_hints.min.width = v_min["width"].asInt();
-    client->size_hints.min.height = v_min["height"].asInt();
-
-    auto v_aspect_ratio = v_size_hints["aspect_ratio"];
-    client->size_hints.aspect_ratio.min = v_aspect_ratio["min"].asInt();
-    client->size_hints.aspect_ratio.max = v_aspect_ratio["max"].asInt();
-
-    auto v_border_width = root["border_width"];
-    client->border_width.cur = v_border_width["current"].asInt();
-    client->border_width.old = v_border_width["old"].asInt();
-
-    auto v_states = root["states"];
-    client->states.is_fixed = v_states["is_fixed"].asBool();
-    client->states.is_floating = v_states["is_floating"].asBool();
-    client->states.is_urgent = v_states["is_urgent"].asBool();
-    client->states.is_fullscreen = v_states["is_fullscreen"].asBool();
-    client->states.never_focus = v_states["never_focus"].asBool();
-    client->states.old_state = v_states["old_state"].asBool();
+std::shared_ptr<ClientList>
+Connection::get_clients(const std::vector<Window> &win_ids) {
+    std::vector<std::shared_ptr<Packet>> packets;
+    std::vector<PacketView> requests;
+    packets.reserve(win_ids.size());
+    requests.reserve(win_ids.size());
+    for (const Window win_id : win_ids) {
+        const std::string msg =
+            "{\"client_window_id\":" + std::to_string(win_id) + "}";
+        packets.push_back(
+            packet_pool.acquire(MessageType::GET_DWM_CLIENT, msg));
+        requests.push_back(packets.back()->view());
+    }
 
-    return client;
+    const auto replies = send_requests(requests.data(), requests.size());
+
+    auto list = std::make_shared<ClientList>();
+    list->clients.resize(win_ids.size());
+
+    // Decode straight into the vector, compacting over failed windows
+    size_t found = 0;
+    for (size_t i = 0; i < replies.size(); i++) {
+        try {
+            parse_client_reply(replies[i], list->clients[found]);
+            found++;
+        } catch (const ResultFailureError &err) {
+            list->failures.push_back({win_ids[i], err.what()});
+        }
+    }
+    list->clients.resize(found);
+    return list;
+}
+
+StateSnapshot Connection::get_state() {
+    const PacketView requests[] = {static_request(MessageType::GET_MONITORS),
+                                   static_request(MessageType::GET_TAGS),
+                                   static_request(MessageType::GET_LAYOUTS)};
+
+    const auto replies = send_requests(requests, 3);
+
+    StateSnapshot state;
+    state.monitors = parse_monitors_reply(replies[0]);
+    state.tags = parse_tags_reply(replies[1]);
+    state.layouts = parse_layouts_reply(replies[2]);
+    return state;
 }
 
 void Connection::subscribe(const Event ev, const bool sub) {
-    // Get string representation of event
-    const std::string ev_name = event_map.at(ev);
+    subscribe_mask(static_cast<uint8_t>(ev), sub);
+}
 
-    Json::StreamWriterBuilder builder;
-    // No need to waste bytes on pretty JSON
-    builder["indentation"] = "";
+void Connection::subscribe_mask(const uint8_t mask, const bool sub) {
+    std::vector<PacketView> requests;
+    std::vector<struct iovec> iov;
 
-    Json::Value root;
-    root["event"] = ev_name;
-    root["action"] = (sub ? "subscribe" : "unsubscribe");
+    // Checked before anything is paused or written, and before the bits can
+    // reach subscriptions and be replayed by resubscribe
+    if (mask & ~ALL_EVENTS)
+        throw std::invalid_argument("Invalid event mask " +
+                                    std::to_string(mask));
 
-    const std::string msg = Json::writeString(builder, root);
-    auto reply = dwm_msg(MessageType::SUBSCRIBE, msg);
+    // The replies are read from the event socket on this thread.
+    // handle_events resumes the event thread.
+    pause_event_thread();
 
-    // Throws error on failure result, we don't care about success result
-    Json::Value dummy;
-    pre_parse_reply(dummy, reply);
+    // Throw error if disconnected socket
+    assert_socket_connected(MessageType::SUBSCRIBE);
+
+    for (uint8_t bit = 1; bit && bit <= mask; bit <<= 1) {
+        if (!(mask & bit))
+            continue;
+
+        // Sent straight from the packets built at compile time
+        requests.push_back(static_subscribe(static_cast<Event>(bit), sub));
+
+        struct iovec v;
+        v.iov_base = const_cast<uint8_t *>(requests.back().data);
+        v.iov_len = requests.back().size;
+        iov.push_back(v);
+    }
+
+    std::vector<std::shared_ptr<Packet>> replies;
+    replies.reserve(requests.size());
+
+    for (bool retried = false;; retried = true) {
+        try {
+            // Write every request at once, then collect the replies
+            record_sent(SocketRole::EVENT, requests.data(), requests.size());
+            swritev(event_sockfd, iov.data(), iov.size());
+            for (size_t i = 0; i < requests.size(); i++)
+                replies.push_back(recv_reply(event_sockfd));
+            break;
+        } catch (const SocketClosedError &err) {
+            disconnect_event_socket();
+
+            // Subscribing is idempotent, so simply start over
+            if (retried || !reconnect_socket(true))
+                throw;
+            replies.clear();
+
+            // swritev advances the iovecs as it writes
+            for (size_t i = 0; i < requests.size(); i++) {
+                iov[i].iov_base = const_cast<uint8_t *>(requests[i].data);
+                iov[i].iov_len = requests[i].size;
+            }
+        }
+    }
+
+    for (const auto &reply : replies) {
+        const uint8_t type = static_cast<uint8_t>(MessageType::SUBSCRIBE);
+        if (reply->header->type != type)
+            throw ReplyError(type, reply->header->type);
+
+        // Throws error on failure result, we don't care about success result
+        Json::Value dummy;
+        pre_parse_reply(dummy, reply->payload, reply->header->size);
+    }
+}
+
+void Connection::subscribe_many(const uint8_t mask) {
+    subscribe_mask(mask, true);
+    this->subscriptions |= mask;
 }
 
 void Connection::subscribe(const Event ev) {
@@ -467,94 +836,384 @@ void Connection::unsubscribe(const Event ev) {
         this->subscriptions -= static_cast<uint8_t>(ev);
 }
 
-bool Connection::handle_event() {
-    std::shared_ptr<Packet> reply;
+bool Connection::handle_event() { return handle_events(1) > 0; }
+
+size_t Connection::handle_events(const size_t max) {
     // Throw error if disconnected socket
     assert_socket_connected(MessageType::EVENT);
 
-    try {
-        reply = recv_message(event_sockfd, false);
-    } catch (NoMsgError &) {
-        return false;
-    } catch (const SocketClosedError &err) {
-        disconnect_event_socket();
-        throw;
+    // Events queued before the event thread was paused come first
+    size_t handled =
+        handle_queued_events(std::min(max, event_thread_backlog));
+    event_thread_backlog -= handled;
+
+    // Then events received while waiting for a reply
+    while (handled < max && !deferred_events.empty()) {
+        const auto event = std::move(deferred_events.front());
+        deferred_events.pop_front();
+        handle_event_payload(event->payload, event->header->size);
+        handled++;
     }
 
-    if (reply->header->type != static_cast<uint8_t>(MessageType::EVENT))
-        throw IPCError("Invalid message type received");
+    if (event_thread_enabled) {
+        resume_event_thread();
+        handled += handle_queued_events(max - handled);
+        check_event_thread();
+        dispatch_coalesced(true);
+        return handled;
+    }
 
-    Json::Value root;
-    pre_parse_reply(root, reply);
-
-    // First key of JSON will be event name
-    if (root.get(event_map.at(Event::TAG_CHANGE), Json::nullValue) !=
-        Json::nullValue) {
-        if (on_tag_change) {
-            TagChangeEvent event;
-            parse_tag_change_event(root, event);
-            on_tag_change(event);
-        }
-    } else if (root.get(event_map.at(Event::LAYOUT_CHANGE), Json::nullValue) !=
-               Json::nullValue) {
-        if (on_layout_change) {
-            LayoutChangeEvent event;
-            parse_layout_change_event(root, event);
-            on_layout_change(event);
-        }
-    } else if (root.get(event_map.at(Event::CLIENT_FOCUS_CHANGE),
-                        Json::nullValue) != Json::nullValue) {
-        if (on_client_focus_change) {
-            ClientFocusChangeEvent event;
-            parse_client_focus_change_event(root, event);
-            on_client_focus_change(event);
-        }
-    } else if (root.get(event_map.at(Event::MONITOR_FOCUS_CHANGE),
-                        Json::nullValue) != Json::nullValue) {
-        if (on_monitor_focus_change) {
-            MonitorFocusChangeEvent event;
-            parse_monitor_focus_change(root, event);
-            on_monitor_focus_change(event);
-        }
-    } else if (root.get(event_map.at(Event::FOCUSED_TITLE_CHANGE),
-                        Json::nullValue) != Json::nullValue) {
-        if (on_focused_title_change) {
-            FocusedTitleChangeEvent event;
-            parse_focused_title_change_event(root, event);
-            on_focused_title_change(event);
+    bool drained = false;
+    Frame frame;
+
+    while (handled < max) {
+        if (!event_reader.next(frame)) {
+            // Only read again if the last read did not empty the socket
+            if (drained)
+                break;
+
+            try {
+                fill_reader(event_reader, event_sockfd, drained);
+            } catch (const SocketClosedError &err) {
+                disconnect_event_socket();
+                if (!reconnect_socket(true))
+                    throw;
+                // Any events raised while disconnected are lost
+                break;
+            }
+            continue;
         }
-    } else if (root.get(event_map.at(Event::FOCUSED_STATE_CHANGE),
-                        Json::nullValue) != Json::nullValue) {
-        if (on_focused_state_change) {
-            FocusedStateChangeEvent event;
-            parse_focused_state_change_event(root, event);
-            on_focused_state_change(event);
+
+        record_received(event_reader, frame);
+        if (frame.type != static_cast<uint8_t>(MessageType::EVENT))
+            throw IPCError("Invalid message type received");
+
+        handle_event_payload(frame.payload, frame.size);
+        handled++;
+    }
+
+    dispatch_coalesced(true);
+    return handled;
+}
+
+size_t Connection::handle_queued_events(const size_t max) {
+    // Events queued from now on signal the wait fd again
+    event_thread.clear_notify();
+
+    size_t handled = 0;
+    EventReaderThread::Slot *slot;
+    while (handled < max && (slot = event_thread.front())) {
+        // The event thread already applied the filter, unless it has been
+        // replaced since the event was queued
+        const bool filtered = event_thread_stale == 0;
+        if (!filtered)
+            event_thread_stale--;
+
+        // The slot is reused once popped, so pop it even if a handler throws
+        try {
+            if (slot->type != static_cast<uint8_t>(MessageType::EVENT))
+                throw IPCError("Invalid message type received");
+
+            handle_event_payload(slot->payload.data(), slot->payload.size(),
+                                 slot->decoded ? &slot->msg : nullptr,
+                                 filtered);
+        } catch (...) {
+            event_thread.pop();
+            throw;
         }
-    } else
-        throw IPCError("Invalid event type received" +
-                       std::string(reply->payload, reply->header->size));
+        event_thread.pop();
+        handled++;
+    }
+    return handled;
+}
 
-    return true;
+void Connection::check_event_thread() {
+    if (!event_thread.empty())
+        return;
+
+    if (event_thread.lost()) {
+        disconnect_event_socket();
+        if (!reconnect_socket(true))
+            throw SocketClosedError(
+                "Disconnected event socket: Cannot read/write");
+        // Any events raised while disconnected are lost
+    } else if (const std::exception_ptr err = event_thread.error()) {
+        // Restarted by the next call
+        pause_event_thread();
+        std::rethrow_exception(err);
+    }
+}
+
+void Connection::handle_event_payload(const char *payload,
+                                      const uint32_t size,
+                                      const EventMessage *decoded,
+                                      const bool filtered) {
+    // Rejected events are dropped before anything is decoded
+    if (!filtered && !event_filter.accepts(payload, size))
+        return;
+
+    Event type;
+    const char *body;
+    if (locate_event(payload, size, type, body) &&
+        handlers.has_view_handlers(type)) {
+        // Only decode the whole event if a handler needs the decoded struct
+        if (has_event_handler(type))
+            decode_event_payload(payload, size, decoded);
+        handlers.dispatch_view(type, body, payload + size);
+        return;
+    }
+
+    decode_event_payload(payload, size, decoded);
+}
+
+void Connection::decode_event_payload(const char *payload,
+                                      const uint32_t size,
+                                      const EventMessage *decoded) {
+    if (decoded) {
+        if (!coalescer.add(*decoded))
+            dispatch_event(*decoded);
+        return;
+    }
+
+    bool ok = false;
+    if (decoder == Decoder::STREAMING)
+        ok = decode_event(payload, size, event_msg);
+
+    if (!ok) {
+        Json::Value root;
+        pre_parse_reply(root, payload, size);
+        if (!parse_event(root, event_msg))
+            throw IPCError("Invalid event type received" +
+                           std::string(payload, size));
+    }
+
+    if (!coalescer.add(event_msg))
+        dispatch_event(event_msg);
+}
+
+bool Connection::has_event_handler(const Event ev) const {
+    if (handlers.has_event_handlers(ev))
+        return true;
+
+    switch (ev) {
+    case Event::TAG_CHANGE:
+        return static_cast<bool>(on_tag_change);
+    case Event::LAYOUT_CHANGE:
+        return static_cast<bool>(on_layout_change);
+    case Event::CLIENT_FOCUS_CHANGE:
+        return static_cast<bool>(on_client_focus_change);
+    case Event::MONITOR_FOCUS_CHANGE:
+        return static_cast<bool>(on_monitor_focus_change);
+    case Event::FOCUSED_TITLE_CHANGE:
+        return static_cast<bool>(on_focused_title_change);
+    case Event::FOCUSED_STATE_CHANGE:
+        return static_cast<bool>(on_focused_state_change);
+    }
+    return false;
+}
+
+void Connection::dispatch_coalesced(const bool batch_end) {
+    while (coalescer.release(coalesced_msg, batch_end))
+        dispatch_event(coalesced_msg);
+}
+
+void Connection::dispatch_event(const EventMessage &msg) {
+    handlers.dispatch(msg);
+
+    switch (msg.type) {
+    case Event::TAG_CHANGE:
+        if (on_tag_change)
+            on_tag_change(msg.tag_change);
+        break;
+    case Event::LAYOUT_CHANGE:
+        if (on_layout_change)
+            on_layout_change(msg.layout_change);
+        break;
+    case Event::CLIENT_FOCUS_CHANGE:
+        if (on_client_focus_change)
+            on_client_focus_change(msg.client_focus_change);
+        break;
+    case Event::MONITOR_FOCUS_CHANGE:
+        if (on_monitor_focus_change)
+            on_monitor_focus_change(msg.monitor_focus_change);
+        break;
+    case Event::FOCUSED_TITLE_CHANGE:
+        if (on_focused_title_change)
+            on_focused_title_change(msg.focused_title_change);
+        break;
+    case Event::FOCUSED_STATE_CHANGE:
+        if (on_focused_state_change)
+            on_focused_state_change(msg.focused_state_change);
+        break;
+    }
 }
 
+void Connection::set_decoder(const Decoder decoder) { this->decoder = decoder; }
+
+Decoder Connection::get_decoder() const { return this->decoder; }
+
 uint8_t Connection::get_subscriptions() const { return this->subscriptions; }
 
-void Connection::run_command(const std::string name, const Json::Value &arr) {
-    Json::Value root;
-    root["command"] = name;
-    root["args"] = Json::Value(arr);
+int Connection::get_main_socket_fd() const { return this->main_sockfd; }
+
+int Connection::get_event_socket_fd() const { return this->event_sockfd; }
 
-    Json::StreamWriterBuilder builder;
-    // No need to waste bytes on pretty JSON
-    builder["indentation"] = "";
-    const std::string msg = Json::writeString(builder, root);
+std::shared_ptr<Packet>
+Connection::build_command_packet(const std::string &name,
+                                 const Json::Value &arr) {
+    auto packet = packet_pool.acquire();
+    CommandWriter writer(*packet, name);
+    writer.values(arr);
+    writer.finish();
+    return packet;
+}
+
+void Connection::run_command(const std::string name, const Json::Value &arr) {
+    send_command(build_command_packet(name, arr));
+}
 
-    auto reply = dwm_msg(MessageType::RUN_COMMAND, msg);
+void Connection::send_command(const std::shared_ptr<Packet> &packet) {
+    auto reply = send_request(packet->view());
 
     // Dummy value
     Json::Value dummy;
     // Throws exception on failure result
-    pre_parse_reply(dummy, reply);
+    pre_parse_reply(dummy, reply->payload, reply->header->size);
+}
+
+std::future<std::shared_ptr<std::vector<Monitor>>>
+Connection::get_monitors_async() {
+    return submit<std::shared_ptr<std::vector<Monitor>>>(
+        static_request(MessageType::GET_MONITORS), nullptr,
+        [this](const std::shared_ptr<Packet> &reply) {
+            return parse_monitors_reply(reply);
+        });
+}
+
+std::future<std::shared_ptr<std::vector<Tag>>> Connection::get_tags_async() {
+    return submit<std::shared_ptr<std::vector<Tag>>>(
+        static_request(MessageType::GET_TAGS), nullptr,
+        [this](const std::shared_ptr<Packet> &reply) {
+            return parse_tags_reply(reply);
+        });
+}
+
+std::future<std::shared_ptr<std::vector<Layout>>>
+Connection::get_layouts_async() {
+    return submit<std::shared_ptr<std::vector<Layout>>>(
+        static_request(MessageType::GET_LAYOUTS), nullptr,
+        [this](const std::shared_ptr<Packet> &reply) {
+            return parse_layouts_reply(reply);
+        });
+}
+
+std::future<std::shared_ptr<Client>>
+Connection::get_client_async(Window win_id) {
+    const std::string msg =
+        "{\"client_window_id\":" + std::to_string(win_id) + "}";
+    auto packet = packet_pool.acquire(MessageType::GET_DWM_CLIENT, msg);
+    return submit<std::shared_ptr<Client>>(
+        packet->view(), packet, [this](const std::shared_ptr<Packet> &reply) {
+            return parse_client_reply(reply);
+        });
+}
+
+std::future<void> Connection::run_command_async(const std::string name,
+                                                const Json::Value &arr) {
+    return send_command_async(build_command_packet(name, arr));
+}
+
+std::future<void>
+Connection::send_command_async(const std::shared_ptr<Packet> &packet) {
+    return submit<void>(packet->view(), packet,
+                        [](const std::shared_ptr<Packet> &reply) {
+        // Throws exception on failure result
+        Json::Value dummy;
+        pre_parse_reply(dummy, reply->payload, reply->header->size);
+    });
+}
+
+void Connection::enqueue(AsyncRequest &&request) {
+    std::lock_guard<std::mutex> lock(io_mutex);
+
+    if (io_stopping)
+        throw InvalidOperationError(
+            "Cannot queue request. Connection is being destroyed.");
+
+    // Start the I/O thread on first use
+    if (!io_thread.joinable())
+        io_thread = std::thread(&Connection::io_loop, this);
+
+    io_queue.push_back(std::move(request));
+    io_cv.notify_one();
+}
+
+void Connection::io_loop() {
+    std::vector<AsyncRequest> batch;
+    std::vector<PacketView> requests;
+    std::vector<std::shared_ptr<Packet>> replies;
+
+    io_thread_owner = this;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(io_mutex);
+            io_cv.wait(lock, [this]() {
+                return io_stopping || !io_queue.empty();
+            });
+
+            if (io_queue.empty())
+                return;
+
+            // Take everything queued so far and pipeline it together
+            batch.clear();
+            for (auto &request : io_queue)
+                batch.push_back(std::move(request));
+            io_queue.clear();
+        }
+
+        requests.clear();
+        for (const auto &request : batch)
+            requests.push_back(request.request);
+
+        // Requests answered before a failure still get their replies, and
+        // only the unanswered ones get the error
+        std::exception_ptr err;
+        try {
+            pipeline(requests.data(), requests.size(), replies);
+        } catch (...) {
+            err = std::current_exception();
+        }
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (i >= replies.size()) {
+                batch[i].fail(err);
+                continue;
+            }
+
+            try {
+                const uint8_t type = requests[i].type;
+                if (replies[i]->header->type != type)
+                    throw ReplyError(type, replies[i]->header->type);
+                batch[i].fulfill(replies[i]);
+            } catch (...) {
+                batch[i].fail(std::current_exception());
+            }
+        }
+        replies.clear();
+    }
+}
+
+void Connection::stop_io_thread() {
+    {
+        std::lock_guard<std::mutex> lock(io_mutex);
+        io_stopping = true;
+        io_cv.notify_one();
+    }
+
+    // The thread finishes any queued requests before exiting
+    if (io_thread.joinable())
+        io_thread.join();
 }
 
 } // namespace dwmipc
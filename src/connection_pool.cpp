@@ -0,0 +1,266 @@
+/**
+ * @file connection_pool.cpp
+ *
+ * This file contains the implementation details for the ConnectionPool and
+ * ConnectionLease classes.
+ */
+
+#include "dwmipcpp/connection_pool.hpp"
+
+#include "dwmipcpp/errors.hpp"
+
+namespace dwmipc {
+/**
+ * Convert a duration to fractional milliseconds
+ */
+template <typename Duration> static double to_ms(const Duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+ConnectionLease::ConnectionLease(ConnectionPool *pool, Connection *conn)
+    : pool(pool), conn(conn) {}
+
+ConnectionLease::ConnectionLease(ConnectionLease &&other)
+    : pool(other.pool), conn(other.conn) {
+    other.pool = nullptr;
+    other.conn = nullptr;
+}
+
+ConnectionLease &ConnectionLease::operator=(ConnectionLease &&other) {
+    if (this != &other) {
+        release();
+        this->pool = other.pool;
+        this->conn = other.conn;
+        other.pool = nullptr;
+        other.conn = nullptr;
+    }
+    return *this;
+}
+
+ConnectionLease::~ConnectionLease() { release(); }
+
+void ConnectionLease::release() {
+    if (this->conn)
+        this->pool->give_back(this->conn);
+    this->pool = nullptr;
+    this->conn = nullptr;
+}
+
+ConnectionPool::ConnectionPool(const std::string &socket_path,
+                               const ConnectionPoolOptions &options)
+    : socket_path(socket_path), options(options),
+      event_conn(socket_path, false) {
+    event_conn.connect_event_socket();
+
+    const auto now = Clock::now();
+    for (size_t i = 0; i < options.min_connections; i++) {
+        std::unique_ptr<Entry> entry(new Entry);
+        entry->conn = open_connection();
+        entry->id = ++last_id;
+        entry->opened = now;
+        entry->last_used = now;
+        entries.push_back(std::move(entry));
+        stats.opened++;
+    }
+}
+
+ConnectionLease ConnectionPool::lease() {
+    // Declared before the lock so connections are closed after it is released
+    std::vector<std::unique_ptr<Entry>> closed;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    const auto deadline =
+        Clock::now() + std::chrono::milliseconds(options.lease_timeout_ms);
+    const auto check_after = std::chrono::milliseconds(options.health_check_ms);
+    bool waited = false;
+
+    while (true) {
+        const auto now = Clock::now();
+        take_expired(closed, now);
+
+        // Prefer the most recently used connection, so that the others can
+        // time out when demand drops
+        Entry *idle = nullptr;
+        for (const auto &entry : entries)
+            if (!entry->leased &&
+                (!idle || entry->last_used > idle->last_used))
+                idle = entry.get();
+
+        if (idle) {
+            const bool stale = now - idle->last_used >= check_after;
+            idle->leased = true;
+            idle->leases++;
+            idle->last_used = now;
+            if (!stale)
+                return ConnectionLease(this, idle->conn.get());
+
+            // Checking may reconnect, so don't block other callers meanwhile
+            lock.unlock();
+            const bool healthy = check(*idle->conn);
+            lock.lock();
+            if (healthy)
+                return ConnectionLease(this, idle->conn.get());
+
+            take_entry(idle, closed);
+            stats.replaced++;
+            continue;
+        }
+
+        if (entries.size() + opening < options.max_connections) {
+            opening++;
+            lock.unlock();
+
+            std::unique_ptr<Connection> conn;
+            try {
+                conn = open_connection();
+            } catch (...) {
+                lock.lock();
+                opening--;
+                available.notify_one();
+                throw;
+            }
+
+            lock.lock();
+            opening--;
+
+            std::unique_ptr<Entry> entry(new Entry);
+            entry->conn = std::move(conn);
+            entry->id = ++last_id;
+            entry->leased = true;
+            entry->leases = 1;
+            entry->opened = Clock::now();
+            entry->last_used = entry->opened;
+            stats.opened++;
+
+            Connection *leased = entry->conn.get();
+            entries.push_back(std::move(entry));
+            return ConnectionLease(this, leased);
+        }
+
+        if (!waited) {
+            stats.waits++;
+            waited = true;
+        }
+
+        if (options.lease_timeout_ms == 0) {
+            available.wait(lock);
+        } else if (available.wait_until(lock, deadline) ==
+                   std::cv_status::timeout) {
+            throw TimeoutError("Timed out waiting for a pooled connection");
+        }
+    }
+}
+
+Connection &ConnectionPool::events() { return event_conn; }
+
+void ConnectionPool::prune() {
+    std::vector<std::unique_ptr<Entry>> closed;
+    std::lock_guard<std::mutex> lock(mutex);
+    take_expired(closed, Clock::now());
+}
+
+size_t ConnectionPool::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+ConnectionPoolStats ConnectionPool::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto now = Clock::now();
+
+    ConnectionPoolStats result = stats;
+    result.connections.reserve(entries.size());
+    for (const auto &entry : entries) {
+        auto busy = entry->busy;
+        if (entry->leased)
+            busy += now - entry->last_used;
+
+        PooledConnectionStats conn;
+        conn.id = entry->id;
+        conn.leased = entry->leased;
+        conn.leases = entry->leases;
+        conn.busy_ms = to_ms(busy);
+        conn.lifetime_ms = to_ms(now - entry->opened);
+        result.connections.push_back(conn);
+    }
+    return result;
+}
+
+std::unique_ptr<Connection> ConnectionPool::open_connection() const {
+    std::unique_ptr<Connection> conn(new Connection(socket_path, false));
+    conn->connect_main_socket();
+    return conn;
+}
+
+bool ConnectionPool::check(Connection &conn) const {
+    // A lost socket is closed by is_main_socket_connected
+    if (conn.is_main_socket_connected())
+        return true;
+
+    try {
+        conn.connect_main_socket();
+        return true;
+    } catch (const IPCError &) {
+        return false;
+    }
+}
+
+ConnectionPool::Entry *ConnectionPool::find(const Connection *conn) const {
+    for (const auto &entry : entries)
+        if (entry->conn.get() == conn)
+            return entry.get();
+    return nullptr;
+}
+
+void ConnectionPool::give_back(Connection *conn) {
+    std::vector<std::unique_ptr<Entry>> closed;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Entry *entry = find(conn);
+    if (!entry)
+        return;
+
+    const auto now = Clock::now();
+    entry->busy += now - entry->last_used;
+    entry->last_used = now;
+    entry->leased = false;
+
+    // A socket that was lost and could not be reconnected is of no further
+    // use, so make room for a new connection
+    if (conn->get_main_socket_fd() == -1) {
+        take_entry(entry, closed);
+        stats.replaced++;
+    }
+
+    take_expired(closed, now);
+    available.notify_one();
+}
+
+void ConnectionPool::take_entry(const Entry *entry,
+                                std::vector<std::unique_ptr<Entry>> &closed) {
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->get() == entry) {
+            closed.push_back(std::move(*it));
+            entries.erase(it);
+            return;
+        }
+    }
+}
+
+void ConnectionPool::take_expired(std::vector<std::unique_ptr<Entry>> &closed,
+                                  const Clock::time_point now) {
+    const auto timeout = std::chrono::milliseconds(options.idle_timeout_ms);
+
+    auto it = entries.begin();
+    while (it != entries.end() && entries.size() > options.min_connections) {
+        if (!(*it)->leased && now - (*it)->last_used >= timeout) {
+            closed.push_back(std::move(*it));
+            it = entries.erase(it);
+            stats.closed++;
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace dwmipc
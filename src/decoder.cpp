@@ -0,0 +1,1060 @@
+/**
+ * @file decoder.cpp
+ *
+ * This file contains the implementation details for the jsoncpp based and the
+ * streaming decoders declared in decoder.hpp.
+ */
+
+#include "dwmipcpp/decoder.hpp"
+
+#include <string>
+
+#include "dwmipcpp/errors.hpp"
+#include "dwmipcpp/json_scanner.hpp"
+
+namespace dwmipc {
+void pre_parse_reply(Json::Value &root, const char *payload,
+                     const uint32_t size) {
+    const char *start = payload;
+    const char *end = start + size - 1;
+
+    std::string errs;
+
+    const Json::CharReaderBuilder builder;
+    const auto reader = builder.newCharReader();
+    reader->parse(start, end, &root, &errs);
+    delete reader;
+
+    // Not properly documented, but if the reply is an array any type of
+    // function that checks for the existance of a key throws a Json::LogicError
+    if (!root.isArray() && root.get("result", "") == "error")
+        throw ResultFailureError(root["reason"].asString());
+}
+
+/**
+ * Parse the body of a Event::TAG_CHANGE message
+ */
+static void parse_tag_change_event(const Json::Value &v_event,
+                                   TagChangeEvent &event) {
+    const Json::Value &v_old_state = v_event["old_state"];
+    const Json::Value &v_new_state = v_event["new_state"];
+
+    event.monitor_num = v_event["monitor_number"].asUInt();
+    event.old_state.selected = v_old_state["selected"].asUInt();
+    event.old_state.occupied = v_old_state["occupied"].asUInt();
+    event.old_state.urgent = v_old_state["urgent"].asUInt();
+    event.new_state.selected = v_new_state["selected"].asUInt();
+    event.new_state.occupied = v_new_state["occupied"].asUInt();
+    event.new_state.urgent = v_new_state["urgent"].asUInt();
+}
+
+/**
+ * Parse the body of a Event::LAYOUT_CHANGE message
+ */
+static void parse_layout_change_event(const Json::Value &v_event,
+                                      LayoutChangeEvent &event) {
+    event.monitor_num = v_event["monitor_number"].asUInt();
+    event.old_symbol = v_event["old_symbol"].asString();
+    event.old_address = v_event["old_address"].asUInt64();
+    event.new_symbol = v_event["new_symbol"].asString();
+    event.new_address = v_event["new_address"].asUInt64();
+}
+
+/**
+ * Parse the body of a Event::CLIENT_FOCUS_CHANGE message
+ */
+static void parse_client_focus_change_event(const Json::Value &v_event,
+                                            ClientFocusChangeEvent &event) {
+    event.monitor_num = v_event["monitor_number"].asUInt();
+    event.old_win_id = v_event["old_win_id"].asUInt();
+    event.new_win_id = v_event["new_win_id"].asUInt();
+}
+
+/**
+ * Parse the body of a Event::FOCUSED_TITLE_CHANGE message
+ */
+static void parse_focused_title_change_event(const Json::Value &v_event,
+                                             FocusedTitleChangeEvent &event) {
+    event.monitor_num = v_event["monitor_number"].asUInt();
+    event.client_window_id = v_event["client_window_id"].asUInt();
+    event.old_name = v_event["old_name"].asString();
+    event.new_name = v_event["new_name"].asString();
+}
+
+/**
+ * Parse the body of a Event::MONITOR_FOCUS_CHANGE message
+ */
+static void parse_monitor_focus_change(const Json::Value &v_event,
+                                       MonitorFocusChangeEvent &event) {
+    event.old_mon_num = v_event["old_monitor_number"].asUInt();
+    event.new_mon_num = v_event["new_monitor_number"].asUInt();
+}
+
+/**
+ * Parse the body of a Event::FOCUSED_STATE_CHANGE message
+ */
+static void parse_focused_state_change_event(const Json::Value &v_event,
+                                             FocusedStateChangeEvent &event) {
+    const Json::Value &v_old_state = v_event["old_state"];
+    const Json::Value &v_new_state = v_event["new_state"];
+
+    event.monitor_num = v_event["monitor_number"].asUInt();
+    event.client_window_id = v_event["client_window_id"].asUInt();
+
+    event.old_state.old_state = v_old_state["old_state"].asBool();
+    event.old_state.is_fixed = v_old_state["is_fixed"].asBool();
+    event.old_state.is_floating = v_old_state["is_floating"].asBool();
+    event.old_state.is_fullscreen = v_old_state["is_fullscreen"].asBool();
+    event.old_state.is_urgent = v_old_state["is_urgent"].asBool();
+    event.old_state.never_focus = v_old_state["never_focus"].asBool();
+
+    event.new_state.old_state = v_new_state["old_state"].asBool();
+    event.new_state.is_fixed = v_new_state["is_fixed"].asBool();
+    event.new_state.is_floating = v_new_state["is_floating"].asBool();
+    event.new_state.is_fullscreen = v_new_state["is_fullscreen"].asBool();
+    event.new_state.is_urgent = v_new_state["is_urgent"].asBool();
+    event.new_state.never_focus = v_new_state["never_focus"].asBool();
+}
+
+/**
+ * Get the position of an event's bit, used to index the dispatch tables
+ */
+static size_t event_index(const Event ev) {
+    return __builtin_ctz(static_cast<unsigned int>(ev));
+}
+
+/**
+ * Function that copies the body of one type of event into an EventMessage
+ */
+typedef void (*EventParser)(const Json::Value &v_event, EventMessage &msg);
+
+/**
+ * Event parsers indexed by event_index
+ */
+static const EventParser event_parsers[] = {
+    [](const Json::Value &v_event, EventMessage &msg) {
+        parse_tag_change_event(v_event, msg.tag_change);
+    },
+    [](const Json::Value &v_event, EventMessage &msg) {
+        parse_client_focus_change_event(v_event, msg.client_focus_change);
+    },
+    [](const Json::Value &v_event, EventMessage &msg) {
+        parse_layout_change_event(v_event, msg.layout_change);
+    },
+    [](const Json::Value &v_event, EventMessage &msg) {
+        parse_monitor_focus_change(v_event, msg.monitor_focus_change);
+    },
+    [](const Json::Value &v_event, EventMessage &msg) {
+        parse_focused_title_change_event(v_event, msg.focused_title_change);
+    },
+    [](const Json::Value &v_event, EventMessage &msg) {
+        parse_focused_state_change_event(v_event, msg.focused_state_change);
+    },
+};
+
+bool parse_event(const Json::Value &root, EventMessage &msg) {
+    if (!root.isObject() || root.empty())
+        return false;
+
+    // First key of JSON will be event name
+    const auto it = root.begin();
+    const char *end;
+    const char *name = it.memberName(&end);
+
+    Event type;
+    if (!event_from_name(name, end - name, type))
+        return false;
+
+    msg.type = type;
+    event_parsers[event_index(type)](*it, msg);
+    return true;
+}
+
+void parse_monitors(const Json::Value &root, std::vector<Monitor> &monitors) {
+    monitors.clear();
+
+    for (Json::Value v_mon : root) {
+        Monitor mon;
+
+        mon.master_factor = v_mon["master_factor"].asFloat();
+        mon.num_master = v_mon["num_master"].asInt();
+        mon.num = v_mon["num"].asUInt();
+        mon.is_selected = v_mon["is_selected"].asBool();
+
+        auto v_monitor_geom = v_mon["monitor_geometry"];
+        mon.monitor_geom.x = v_monitor_geom["x"].asInt();
+        mon.monitor_geom.y = v_monitor_geom["y"].asInt();
+        mon.monitor_geom.width = v_monitor_geom["width"].asInt();
+        mon.monitor_geom.height = v_monitor_geom["height"].asInt();
+
+        auto v_window_geom = v_mon["window_geometry"];
+        mon.window_geom.x = v_window_geom["x"].asInt();
+        mon.window_geom.y = v_window_geom["y"].asInt();
+        mon.window_geom.width = v_window_geom["width"].asInt();
+        mon.window_geom.height = v_window_geom["height"].asInt();
+
+        auto v_layout = v_mon["layout"];
+        auto v_symbol = v_layout["symbol"];
+        mon.layout.symbol.cur = v_symbol["current"].asString();
+        mon.layout.symbol.old = v_symbol["old"].asString();
+
+        auto v_address = v_layout["address"];
+        mon.layout.address.cur = v_address["current"].asUInt64();
+        mon.layout.address.old = v_address["old"].asUInt64();
+
+        auto v_bar = v_mon["bar"];
+        mon.bar.y = v_bar["y"].asInt();
+        mon.bar.is_shown = v_bar["is_shown"].asBool();
+        mon.bar.is_top = v_bar["is_top"].asBool();
+        mon.bar.window_id = v_bar["window_id"].asUInt();
+
+        auto v_tagset = v_mon["tagset"];
+        mon.tagset.cur = v_tagset["current"].asUInt();
+        mon.tagset.old = v_tagset["old"].asUInt();
+
+        auto v_tag_state = v_mon["tag_state"];
+        mon.tag_state.selected = v_tag_state["selected"].asUInt();
+        mon.tag_state.occupied = v_tag_state["occupied"].asUInt();
+        mon.tag_state.urgent = v_tag_state["urgent"].asUInt();
+
+        auto v_clients = v_mon["clients"];
+        mon.clients.selected = v_clients["selected"].asUInt();
+
+        for (Json::Value v : v_clients["stack"])
+            mon.clients.stack.push_back(v.asUInt());
+
+        for (Json::Value v : v_clients["all"])
+            mon.clients.all.push_back(v.asUInt());
+
+        monitors.push_back(mon);
+    }
+}
+
+void parse_client(const Json::Value &root, Client &client) {
+    client.name = root["name"].asString();
+    client.tags = root["tags"].asUInt();
+    client.window_id = root["window_id"].asUInt();
+    client.monitor_num =
+        root.get("monitor_number", root["monitor_num"]).asUInt();
+
+    auto v_geom = root["geometry"];
+    auto v_geom_cur = v_geom["current"];
+    client.geom.cur.x = v_geom_cur["x"].asInt();
+    client.geom.cur.y = v_geom_cur["y"].asInt();
+    client.geom.cur.width = v_geom_cur["width"].asInt();
+    client.geom.cur.height = v_geom_cur["height"].asInt();
+
+    auto v_geom_old = v_geom["old"];
+    client.geom.old.x = v_geom_old["x"].asInt();
+    client.geom.old.y = v_geom_old["y"].asInt();
+    client.geom.old.width = v_geom_old["width"].asInt();
+    client.geom.old.height = v_geom_old["height"].asInt();
+
+    auto v_size_hints = root["size_hints"];
+    auto v_base = v_size_hints["base"];
+    client.size_hints.base.width = v_base["width"].asInt();
+    client.size_hints.base.height = v_base["height"].asInt();
+
+    auto v_step = v_size_hints["step"];
+    client.size_hints.step.width = v_step["width"].asInt();
+    client.size_hints.step.height = v_step["height"].asInt();
+
+    auto v_max = v_size_hints["max"];
+    client.size_hints.max.width = v_max["width"].asInt();
+    client.size_hints.max.height = v_max["height"].asInt();
+
+    auto v_min = v_size_hints["min"];
+    client.size_hints.min.width = v_min["width"].asInt();
+    client.size_hints.min.height = v_min["height"].asInt();
+
+    auto v_aspect_ratio = v_size_hints["aspect_ratio"];
+    client.size_hints.aspect_ratio.min = v_aspect_ratio["min"].asFloat();
+    client.size_hints.aspect_ratio.max = v_aspect_ratio["max"].asFloat();
+
+    auto v_border_width = root["border_width"];
+    client.border_width.cur = v_border_width["current"].asInt();
+    client.border_width.old = v_border_width["old"].asInt();
+
+    auto v_states = root["states"];
+    client.states.is_fixed = v_states["is_fixed"].asBool();
+    client.states.is_floating = v_states["is_floating"].asBool();
+    client.states.is_urgent = v_states["is_urgent"].asBool();
+    client.states.is_fullscreen = v_states["is_fullscreen"].asBool();
+    client.states.never_focus = v_states["never_focus"].asBool();
+    client.states.old_state = v_states["old_state"].asBool();
+}
+
+// Shorthand for matching the keys returned by JsonScanner::next_key
+#define KEY_IS(lit) JsonScanner::key_is(key, len, lit)
+
+/**
+ * Read an unsigned integer that should fit in an unsigned int
+ */
+static bool decode_uint(JsonScanner &s, unsigned int &value) {
+    uint64_t v;
+    if (!s.read_uint(v))
+        return false;
+    value = static_cast<unsigned int>(v);
+    return true;
+}
+
+/**
+ * Read an unsigned integer that should fit in a Window or uintptr_t
+ */
+template <typename T>
+static bool decode_uint64(JsonScanner &s, T &value) {
+    uint64_t v;
+    if (!s.read_uint(v))
+        return false;
+    value = static_cast<T>(v);
+    return true;
+}
+
+/**
+ * Decode a TagState object
+ */
+static bool decode_tag_state(JsonScanner &s, TagState &state) {
+    const char *key;
+    size_t len;
+
+    state = TagState();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("selected"))
+            ok = decode_uint(s, state.selected);
+        else if (KEY_IS("occupied"))
+            ok = decode_uint(s, state.occupied);
+        else if (KEY_IS("urgent"))
+            ok = decode_uint(s, state.urgent);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode a ClientState object
+ */
+static bool decode_client_state(JsonScanner &s, ClientState &state) {
+    const char *key;
+    size_t len;
+
+    state = ClientState();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("old_state"))
+            ok = s.read_bool(state.old_state);
+        else if (KEY_IS("is_fixed"))
+            ok = s.read_bool(state.is_fixed);
+        else if (KEY_IS("is_floating"))
+            ok = s.read_bool(state.is_floating);
+        else if (KEY_IS("is_fullscreen"))
+            ok = s.read_bool(state.is_fullscreen);
+        else if (KEY_IS("is_urgent"))
+            ok = s.read_bool(state.is_urgent);
+        else if (KEY_IS("never_focus"))
+            ok = s.read_bool(state.never_focus);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode the body of a Event::TAG_CHANGE message
+ */
+static bool decode_tag_change_event(JsonScanner &s, TagChangeEvent &event) {
+    const char *key;
+    size_t len;
+
+    event = TagChangeEvent();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("monitor_number"))
+            ok = decode_uint(s, event.monitor_num);
+        else if (KEY_IS("old_state"))
+            ok = decode_tag_state(s, event.old_state);
+        else if (KEY_IS("new_state"))
+            ok = decode_tag_state(s, event.new_state);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode the body of a Event::LAYOUT_CHANGE message
+ */
+static bool decode_layout_change_event(JsonScanner &s,
+                                       LayoutChangeEvent &event) {
+    const char *key;
+    size_t len;
+
+    event.monitor_num = 0;
+    event.old_address = 0;
+    event.new_address = 0;
+    event.old_symbol.clear();
+    event.new_symbol.clear();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("monitor_number"))
+            ok = decode_uint(s, event.monitor_num);
+        else if (KEY_IS("old_symbol"))
+            ok = s.read_string(event.old_symbol);
+        else if (KEY_IS("old_address"))
+            ok = decode_uint64(s, event.old_address);
+        else if (KEY_IS("new_symbol"))
+            ok = s.read_string(event.new_symbol);
+        else if (KEY_IS("new_address"))
+            ok = decode_uint64(s, event.new_address);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode the body of a Event::CLIENT_FOCUS_CHANGE message
+ */
+static bool decode_client_focus_change_event(JsonScanner &s,
+                                             ClientFocusChangeEvent &event) {
+    const char *key;
+    size_t len;
+
+    event = ClientFocusChangeEvent();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("monitor_number"))
+            ok = decode_uint(s, event.monitor_num);
+        else if (KEY_IS("old_win_id"))
+            ok = decode_uint64(s, event.old_win_id);
+        else if (KEY_IS("new_win_id"))
+            ok = decode_uint64(s, event.new_win_id);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode the body of a Event::FOCUSED_TITLE_CHANGE message
+ */
+static bool decode_focused_title_change_event(JsonScanner &s,
+                                              FocusedTitleChangeEvent &event) {
+    const char *key;
+    size_t len;
+
+    event.monitor_num = 0;
+    event.client_window_id = 0;
+    event.old_name.clear();
+    event.new_name.clear();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("monitor_number"))
+            ok = decode_uint(s, event.monitor_num);
+        else if (KEY_IS("client_window_id"))
+            ok = decode_uint64(s, event.client_window_id);
+        else if (KEY_IS("old_name"))
+            ok = s.read_string(event.old_name);
+        else if (KEY_IS("new_name"))
+            ok = s.read_string(event.new_name);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode the body of a Event::MONITOR_FOCUS_CHANGE message
+ */
+static bool decode_monitor_focus_change_event(JsonScanner &s,
+                                              MonitorFocusChangeEvent &event) {
+    const char *key;
+    size_t len;
+
+    event = MonitorFocusChangeEvent();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("old_monitor_number"))
+            ok = decode_uint(s, event.old_mon_num);
+        else if (KEY_IS("new_monitor_number"))
+            ok = decode_uint(s, event.new_mon_num);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode the body of a Event::FOCUSED_STATE_CHANGE message
+ */
+static bool decode_focused_state_change_event(JsonScanner &s,
+                                              FocusedStateChangeEvent &event) {
+    const char *key;
+    size_t len;
+
+    event = FocusedStateChangeEvent();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("monitor_number"))
+            ok = decode_uint(s, event.monitor_num);
+        else if (KEY_IS("client_window_id"))
+            ok = decode_uint64(s, event.client_window_id);
+        else if (KEY_IS("old_state"))
+            ok = decode_client_state(s, event.old_state);
+        else if (KEY_IS("new_state"))
+            ok = decode_client_state(s, event.new_state);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Function that decodes the body of one type of event into an EventMessage
+ */
+typedef bool (*EventDecoder)(JsonScanner &s, EventMessage &msg);
+
+/**
+ * Event decoders indexed by event_index
+ */
+static const EventDecoder event_decoders[] = {
+    [](JsonScanner &s, EventMessage &msg) {
+        return decode_tag_change_event(s, msg.tag_change);
+    },
+    [](JsonScanner &s, EventMessage &msg) {
+        return decode_client_focus_change_event(s, msg.client_focus_change);
+    },
+    [](JsonScanner &s, EventMessage &msg) {
+        return decode_layout_change_event(s, msg.layout_change);
+    },
+    [](JsonScanner &s, EventMessage &msg) {
+        return decode_monitor_focus_change_event(s, msg.monitor_focus_change);
+    },
+    [](JsonScanner &s, EventMessage &msg) {
+        return decode_focused_title_change_event(s, msg.focused_title_change);
+    },
+    [](JsonScanner &s, EventMessage &msg) {
+        return decode_focused_state_change_event(s, msg.focused_state_change);
+    },
+};
+
+bool decode_event(const char *payload, const uint32_t size,
+                  EventMessage &msg) {
+    JsonScanner s(payload, payload + size);
+    const char *key;
+    size_t len;
+
+    // The event name is the only key of the top level object
+    if (!s.begin_object() || !s.next_key(key, len))
+        return false;
+
+    Event type;
+    if (!event_from_name(key, len, type))
+        return false;
+
+    msg.type = type;
+    return event_decoders[event_index(type)](s, msg);
+}
+
+/**
+ * Read a signed integer that should fit in an int
+ */
+static bool decode_int(JsonScanner &s, int &value) {
+    int64_t v;
+    if (!s.read_int(v))
+        return false;
+    value = static_cast<int>(v);
+    return true;
+}
+
+/**
+ * Read a number that should fit in a float
+ */
+static bool decode_float(JsonScanner &s, float &value) {
+    double v;
+    if (!s.read_double(v))
+        return false;
+    value = static_cast<float>(v);
+    return true;
+}
+
+/**
+ * Decode a Geometry object
+ */
+static bool decode_geometry(JsonScanner &s, Geometry &geom) {
+    const char *key;
+    size_t len;
+
+    geom = Geometry();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("x"))
+            ok = decode_int(s, geom.x);
+        else if (KEY_IS("y"))
+            ok = decode_int(s, geom.y);
+        else if (KEY_IS("width"))
+            ok = decode_int(s, geom.width);
+        else if (KEY_IS("height"))
+            ok = decode_int(s, geom.height);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode a Size object
+ */
+static bool decode_size(JsonScanner &s, Size &size) {
+    const char *key;
+    size_t len;
+
+    size = Size();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("width"))
+            ok = decode_int(s, size.width);
+        else if (KEY_IS("height"))
+            ok = decode_int(s, size.height);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode an array of window XIDs. The capacity of the vector is reused.
+ */
+static bool decode_window_list(JsonScanner &s, std::vector<Window> &windows) {
+    windows.clear();
+    if (!s.begin_array())
+        return false;
+
+    while (s.next_element()) {
+        Window win;
+        if (!decode_uint64(s, win))
+            return false;
+        windows.push_back(win);
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode an object with unsigned "current" and "old" members
+ */
+template <typename T>
+static bool decode_cur_old(JsonScanner &s, T &cur, T &old) {
+    const char *key;
+    size_t len;
+
+    cur = T();
+    old = T();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("current"))
+            ok = decode_uint64(s, cur);
+        else if (KEY_IS("old"))
+            ok = decode_uint64(s, old);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode the "clients" member of a monitor
+ */
+static bool decode_monitor_clients(JsonScanner &s, Monitor &mon) {
+    const char *key;
+    size_t len;
+
+    mon.clients.selected = 0;
+    mon.clients.stack.clear();
+    mon.clients.all.clear();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("selected"))
+            ok = decode_uint64(s, mon.clients.selected);
+        else if (KEY_IS("stack"))
+            ok = decode_window_list(s, mon.clients.stack);
+        else if (KEY_IS("all"))
+            ok = decode_window_list(s, mon.clients.all);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode the "layout" member of a monitor
+ */
+static bool decode_monitor_layout(JsonScanner &s, Monitor &mon) {
+    const char *key;
+    size_t len;
+
+    mon.layout.symbol.cur.clear();
+    mon.layout.symbol.old.clear();
+    mon.layout.address.cur = 0;
+    mon.layout.address.old = 0;
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("symbol")) {
+            const char *sym_key;
+            size_t sym_len;
+
+            ok = s.begin_object();
+            while (ok && s.next_key(sym_key, sym_len)) {
+                if (JsonScanner::key_is(sym_key, sym_len, "current"))
+                    ok = s.read_string(mon.layout.symbol.cur);
+                else if (JsonScanner::key_is(sym_key, sym_len, "old"))
+                    ok = s.read_string(mon.layout.symbol.old);
+                else
+                    ok = s.skip_value();
+            }
+            ok = ok && !s.failed();
+        } else if (KEY_IS("address")) {
+            ok = decode_cur_old(s, mon.layout.address.cur,
+                                mon.layout.address.old);
+        } else {
+            ok = s.skip_value();
+        }
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode the "bar" member of a monitor
+ */
+static bool decode_monitor_bar(JsonScanner &s, Monitor &mon) {
+    const char *key;
+    size_t len;
+
+    mon.bar.y = 0;
+    mon.bar.is_shown = false;
+    mon.bar.is_top = false;
+    mon.bar.window_id = 0;
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("y"))
+            ok = decode_int(s, mon.bar.y);
+        else if (KEY_IS("is_shown"))
+            ok = s.read_bool(mon.bar.is_shown);
+        else if (KEY_IS("is_top"))
+            ok = s.read_bool(mon.bar.is_top);
+        else if (KEY_IS("window_id"))
+            ok = decode_uint64(s, mon.bar.window_id);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode a single monitor object
+ */
+static bool decode_monitor(JsonScanner &s, Monitor &mon) {
+    const char *key;
+    size_t len;
+
+    mon.master_factor = 0;
+    mon.num_master = 0;
+    mon.num = 0;
+    mon.is_selected = false;
+    mon.monitor_geom = Geometry();
+    mon.window_geom = Geometry();
+    mon.tagset.cur = 0;
+    mon.tagset.old = 0;
+    mon.tag_state = TagState();
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("master_factor"))
+            ok = decode_float(s, mon.master_factor);
+        else if (KEY_IS("num_master"))
+            ok = decode_int(s, mon.num_master);
+        else if (KEY_IS("num"))
+            ok = decode_uint(s, mon.num);
+        else if (KEY_IS("is_selected"))
+            ok = s.read_bool(mon.is_selected);
+        else if (KEY_IS("monitor_geometry"))
+            ok = decode_geometry(s, mon.monitor_geom);
+        else if (KEY_IS("window_geometry"))
+            ok = decode_geometry(s, mon.window_geom);
+        else if (KEY_IS("tagset"))
+            ok = decode_cur_old(s, mon.tagset.cur, mon.tagset.old);
+        else if (KEY_IS("tag_state"))
+            ok = decode_tag_state(s, mon.tag_state);
+        else if (KEY_IS("clients"))
+            ok = decode_monitor_clients(s, mon);
+        else if (KEY_IS("layout"))
+            ok = decode_monitor_layout(s, mon);
+        else if (KEY_IS("bar"))
+            ok = decode_monitor_bar(s, mon);
+        else
+            ok = s.skip_value();
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+bool decode_monitors(const char *payload, const uint32_t size,
+                     std::vector<Monitor> &monitors) {
+    JsonScanner s(payload, payload + size);
+    size_t count = 0;
+
+    // Error replies are objects, so they are left to the jsoncpp decoder
+    if (!s.begin_array())
+        return false;
+
+    while (s.next_element()) {
+        // Decode into existing elements so their vectors and strings keep
+        // their capacity
+        if (count == monitors.size())
+            monitors.emplace_back();
+        if (!decode_monitor(s, monitors[count]))
+            return false;
+        count++;
+    }
+    monitors.resize(count);
+    return !s.failed();
+}
+
+/**
+ * Decode the "size_hints" member of a client
+ */
+static bool decode_size_hints(JsonScanner &s, Client &client) {
+    const char *key;
+    size_t len;
+
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("base")) {
+            ok = decode_size(s, client.size_hints.base);
+        } else if (KEY_IS("step")) {
+            ok = decode_size(s, client.size_hints.step);
+        } else if (KEY_IS("max")) {
+            ok = decode_size(s, client.size_hints.max);
+        } else if (KEY_IS("min")) {
+            ok = decode_size(s, client.size_hints.min);
+        } else if (KEY_IS("aspect_ratio")) {
+            const char *ar_key;
+            size_t ar_len;
+
+            ok = s.begin_object();
+            while (ok && s.next_key(ar_key, ar_len)) {
+                if (JsonScanner::key_is(ar_key, ar_len, "min"))
+                    ok = decode_float(s, client.size_hints.aspect_ratio.min);
+                else if (JsonScanner::key_is(ar_key, ar_len, "max"))
+                    ok = decode_float(s, client.size_hints.aspect_ratio.max);
+                else
+                    ok = s.skip_value();
+            }
+            ok = ok && !s.failed();
+        } else {
+            ok = s.skip_value();
+        }
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+/**
+ * Decode the "states" member of a client
+ */
+static bool decode_client_states(JsonScanner &s, Client &client) {
+    ClientState state;
+    if (!decode_client_state(s, state))
+        return false;
+
+    client.states.is_fixed = state.is_fixed;
+    client.states.is_floating = state.is_floating;
+    client.states.is_urgent = state.is_urgent;
+    client.states.never_focus = state.never_focus;
+    client.states.old_state = state.old_state;
+    client.states.is_fullscreen = state.is_fullscreen;
+    return true;
+}
+
+bool decode_client(const char *payload, const uint32_t size, Client &client) {
+    JsonScanner s(payload, payload + size);
+    const char *key;
+    size_t len;
+
+    client.name.clear();
+    client.window_id = 0;
+    client.monitor_num = 0;
+    client.tags = 0;
+    client.border_width.cur = 0;
+    client.border_width.old = 0;
+    client.geom.cur = Geometry();
+    client.geom.old = Geometry();
+    client.size_hints.base = Size();
+    client.size_hints.step = Size();
+    client.size_hints.max = Size();
+    client.size_hints.min = Size();
+    client.size_hints.aspect_ratio.min = 0;
+    client.size_hints.aspect_ratio.max = 0;
+    client.states.is_fixed = false;
+    client.states.is_floating = false;
+    client.states.is_urgent = false;
+    client.states.never_focus = false;
+    client.states.old_state = false;
+    client.states.is_fullscreen = false;
+    if (!s.begin_object())
+        return false;
+
+    while (s.next_key(key, len)) {
+        bool ok;
+        if (KEY_IS("name")) {
+            ok = s.read_string(client.name);
+        } else if (KEY_IS("tags")) {
+            ok = decode_uint(s, client.tags);
+        } else if (KEY_IS("window_id")) {
+            ok = decode_uint64(s, client.window_id);
+        } else if (KEY_IS("monitor_number") || KEY_IS("monitor_num")) {
+            ok = decode_uint(s, client.monitor_num);
+        } else if (KEY_IS("geometry")) {
+            const char *geom_key;
+            size_t geom_len;
+
+            ok = s.begin_object();
+            while (ok && s.next_key(geom_key, geom_len)) {
+                if (JsonScanner::key_is(geom_key, geom_len, "current"))
+                    ok = decode_geometry(s, client.geom.cur);
+                else if (JsonScanner::key_is(geom_key, geom_len, "old"))
+                    ok = decode_geometry(s, client.geom.old);
+                else
+                    ok = s.skip_value();
+            }
+            ok = ok && !s.failed();
+        } else if (KEY_IS("size_hints")) {
+            ok = decode_size_hints(s, client);
+        } else if (KEY_IS("border_width")) {
+            int64_t cur = 0, old = 0;
+            const char *bw_key;
+            size_t bw_len;
+
+            ok = s.begin_object();
+            while (ok && s.next_key(bw_key, bw_len)) {
+                if (JsonScanner::key_is(bw_key, bw_len, "current"))
+                    ok = s.read_int(cur);
+                else if (JsonScanner::key_is(bw_key, bw_len, "old"))
+                    ok = s.read_int(old);
+                else
+                    ok = s.skip_value();
+            }
+            ok = ok && !s.failed();
+            client.border_width.cur = static_cast<int>(cur);
+            client.border_width.old = static_cast<int>(old);
+        } else if (KEY_IS("states")) {
+            ok = decode_client_states(s, client);
+        } else if (KEY_IS("result")) {
+            // Error replies are left to the jsoncpp decoder
+            return false;
+        } else {
+            ok = s.skip_value();
+        }
+
+        if (!ok)
+            return false;
+    }
+    return !s.failed();
+}
+
+#undef KEY_IS
+
+} // namespace dwmipc
@@ -0,0 +1,233 @@
+/**
+ * @file diff.cpp
+ *
+ * This file contains the implementation details for diff.hpp.
+ */
+
+#include "dwmipcpp/diff.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace dwmipc {
+static bool equal(const Geometry &a, const Geometry &b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width &&
+           a.height == b.height;
+}
+
+static bool equal(const Size &a, const Size &b) {
+    return a.width == b.width && a.height == b.height;
+}
+
+static bool equal(const TagState &a, const TagState &b) {
+    return a.selected == b.selected && a.occupied == b.occupied &&
+           a.urgent == b.urgent;
+}
+
+/**
+ * Compare lengths before contents, so most changes are caught without looking
+ * at the data at all
+ */
+static bool equal(const std::string &a, const std::string &b) {
+    return a.size() == b.size() &&
+           std::memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+static bool equal(const std::vector<Window> &a, const std::vector<Window> &b) {
+    return a.size() == b.size() &&
+           (a.empty() ||
+            std::memcmp(a.data(), b.data(), a.size() * sizeof(Window)) == 0);
+}
+
+/**
+ * Copy the windows into out and sort them
+ */
+static void sorted_copy(const std::vector<Window> &windows,
+                        std::vector<Window> &out) {
+    out.assign(windows.begin(), windows.end());
+    std::sort(out.begin(), out.end());
+}
+
+/**
+ * Store the windows in a that are not in b. Both must be sorted.
+ */
+static void difference(const std::vector<Window> &a,
+                       const std::vector<Window> &b, std::vector<Window> &out) {
+    out.clear();
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(),
+                        std::back_inserter(out));
+}
+
+void MonitorsDiff::clear() {
+    monitors.clear();
+    added_monitors.clear();
+    removed_monitors.clear();
+    added_windows.clear();
+    removed_windows.clear();
+}
+
+bool diff_monitor(const Monitor &old_mon, const Monitor &new_mon,
+                  MonitorDiff &diff) {
+    uint32_t changed = 0;
+    auto mark = [&changed](const MonitorField field) {
+        changed |= static_cast<uint32_t>(field);
+    };
+
+    diff.num = new_mon.num;
+    diff.added.clear();
+    diff.removed.clear();
+    diff.stack_reordered = false;
+
+    if (old_mon.master_factor != new_mon.master_factor)
+        mark(MonitorField::MASTER_FACTOR);
+    if (old_mon.num_master != new_mon.num_master)
+        mark(MonitorField::NUM_MASTER);
+    if (old_mon.is_selected != new_mon.is_selected)
+        mark(MonitorField::IS_SELECTED);
+    if (!equal(old_mon.monitor_geom, new_mon.monitor_geom))
+        mark(MonitorField::MONITOR_GEOM);
+    if (!equal(old_mon.window_geom, new_mon.window_geom))
+        mark(MonitorField::WINDOW_GEOM);
+    if (old_mon.tagset.cur != new_mon.tagset.cur ||
+        old_mon.tagset.old != new_mon.tagset.old)
+        mark(MonitorField::TAGSET);
+    if (!equal(old_mon.tag_state, new_mon.tag_state))
+        mark(MonitorField::TAG_STATE);
+    if (old_mon.clients.selected != new_mon.clients.selected)
+        mark(MonitorField::CLIENTS_SELECTED);
+    if (!equal(old_mon.layout.symbol.cur, new_mon.layout.symbol.cur) ||
+        !equal(old_mon.layout.symbol.old, new_mon.layout.symbol.old))
+        mark(MonitorField::LAYOUT_SYMBOL);
+    if (old_mon.layout.address.cur != new_mon.layout.address.cur ||
+        old_mon.layout.address.old != new_mon.layout.address.old)
+        mark(MonitorField::LAYOUT_ADDRESS);
+    if (old_mon.bar.y != new_mon.bar.y ||
+        old_mon.bar.is_shown != new_mon.bar.is_shown ||
+        old_mon.bar.is_top != new_mon.bar.is_top ||
+        old_mon.bar.window_id != new_mon.bar.window_id)
+        mark(MonitorField::BAR);
+
+    const bool all_changed = !equal(old_mon.clients.all, new_mon.clients.all);
+    const bool stack_changed =
+        !equal(old_mon.clients.stack, new_mon.clients.stack);
+
+    if (all_changed || stack_changed) {
+        std::vector<Window> old_sorted, new_sorted;
+
+        if (all_changed) {
+            mark(MonitorField::CLIENTS_ALL);
+            sorted_copy(old_mon.clients.all, old_sorted);
+            sorted_copy(new_mon.clients.all, new_sorted);
+            difference(new_sorted, old_sorted, diff.added);
+            difference(old_sorted, new_sorted, diff.removed);
+        }
+
+        if (stack_changed) {
+            mark(MonitorField::CLIENTS_STACK);
+            sorted_copy(old_mon.clients.stack, old_sorted);
+            sorted_copy(new_mon.clients.stack, new_sorted);
+            diff.stack_reordered = old_sorted == new_sorted;
+        }
+    }
+
+    diff.changed = changed;
+    return changed != 0;
+}
+
+void diff_monitors(const std::vector<Monitor> &old_mons,
+                   const std::vector<Monitor> &new_mons, MonitorsDiff &diff) {
+    diff.added_monitors.clear();
+    diff.removed_monitors.clear();
+    diff.added_windows.clear();
+    diff.removed_windows.clear();
+
+    // Changed monitors are written over the elements left in diff.monitors by
+    // the previous call, so their vectors keep their capacity
+    size_t changed = 0;
+    for (const auto &new_mon : new_mons) {
+        auto old_mon = std::find_if(old_mons.begin(), old_mons.end(),
+                                    [&new_mon](const Monitor &mon) {
+                                        return mon.num == new_mon.num;
+                                    });
+
+        if (old_mon == old_mons.end()) {
+            diff.added_monitors.push_back(new_mon.num);
+            continue;
+        }
+
+        if (changed == diff.monitors.size())
+            diff.monitors.emplace_back();
+        if (diff_monitor(*old_mon, new_mon, diff.monitors[changed]))
+            changed++;
+    }
+    diff.monitors.resize(changed);
+
+    for (const auto &old_mon : old_mons) {
+        auto new_mon = std::find_if(new_mons.begin(), new_mons.end(),
+                                    [&old_mon](const Monitor &mon) {
+                                        return mon.num == old_mon.num;
+                                    });
+        if (new_mon == new_mons.end())
+            diff.removed_monitors.push_back(old_mon.num);
+    }
+
+    // Windows that only moved between monitors were neither added nor removed
+    // as far as the whole window manager is concerned
+    std::vector<Window> old_all, new_all;
+    for (const auto &mon : old_mons)
+        old_all.insert(old_all.end(), mon.clients.all.begin(),
+                       mon.clients.all.end());
+    for (const auto &mon : new_mons)
+        new_all.insert(new_all.end(), mon.clients.all.begin(),
+                       mon.clients.all.end());
+    std::sort(old_all.begin(), old_all.end());
+    std::sort(new_all.begin(), new_all.end());
+
+    difference(new_all, old_all, diff.added_windows);
+    difference(old_all, new_all, diff.removed_windows);
+}
+
+uint32_t diff_client(const Client &old_client, const Client &new_client) {
+    uint32_t changed = 0;
+    auto mark = [&changed](const ClientField field) {
+        changed |= static_cast<uint32_t>(field);
+    };
+
+    if (!equal(old_client.name, new_client.name))
+        mark(ClientField::NAME);
+    if (old_client.monitor_num != new_client.monitor_num)
+        mark(ClientField::MONITOR_NUM);
+    if (old_client.tags != new_client.tags)
+        mark(ClientField::TAGS);
+    if (old_client.border_width.cur != new_client.border_width.cur ||
+        old_client.border_width.old != new_client.border_width.old)
+        mark(ClientField::BORDER_WIDTH);
+    if (!equal(old_client.geom.cur, new_client.geom.cur) ||
+        !equal(old_client.geom.old, new_client.geom.old))
+        mark(ClientField::GEOM);
+
+    const auto &old_hints = old_client.size_hints;
+    const auto &new_hints = new_client.size_hints;
+    if (!equal(old_hints.base, new_hints.base) ||
+        !equal(old_hints.step, new_hints.step) ||
+        !equal(old_hints.max, new_hints.max) ||
+        !equal(old_hints.min, new_hints.min) ||
+        old_hints.aspect_ratio.min != new_hints.aspect_ratio.min ||
+        old_hints.aspect_ratio.max != new_hints.aspect_ratio.max)
+        mark(ClientField::SIZE_HINTS);
+
+    const auto &old_states = old_client.states;
+    const auto &new_states = new_client.states;
+    if (old_states.is_fixed != new_states.is_fixed ||
+        old_states.is_floating != new_states.is_floating ||
+        old_states.is_urgent != new_states.is_urgent ||
+        old_states.never_focus != new_states.never_focus ||
+        old_states.old_state != new_states.old_state ||
+        old_states.is_fullscreen != new_states.is_fullscreen)
+        mark(ClientField::STATES);
+
+    return changed;
+}
+
+} // namespace dwmipc
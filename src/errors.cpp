@@ -73,4 +73,10 @@ SocketClosedError::SocketClosedError(const std::string &msg)
 
 InvalidOperationError::InvalidOperationError(const std::string &msg)
     : IPCError(format_generic(msg)) {}
+
+TimeoutError::TimeoutError(const std::string &msg)
+    : IPCError(format_generic(msg)) {}
+
+TrafficLogError::TrafficLogError(const std::string &msg)
+    : IPCError(format_generic(msg)) {}
 } // namespace dwmipc
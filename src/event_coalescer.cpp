@@ -0,0 +1,147 @@
+/**
+ * @file event_coalescer.cpp
+ *
+ * This file contains the implementation details for the EventCoalescer class.
+ */
+
+#include "dwmipcpp/event_coalescer.hpp"
+
+#include <algorithm>
+
+namespace dwmipc {
+/**
+ * Get the position of an event's bit, used to index the policies
+ */
+static size_t policy_index(const Event ev) {
+    return __builtin_ctz(static_cast<unsigned int>(ev));
+}
+
+void EventCoalescer::set_policy(const Event ev, const CoalescePolicy &policy) {
+    policies[policy_index(ev)] = policy;
+}
+
+const CoalescePolicy &EventCoalescer::get_policy(const Event ev) const {
+    return policies[policy_index(ev)];
+}
+
+bool EventCoalescer::add(const EventMessage &msg) {
+    const CoalescePolicy &policy = policies[policy_index(msg.type)];
+    if (policy.mode == CoalesceMode::NONE)
+        return false;
+
+    const uint64_t key = policy.per_key ? key_of(msg) : 0;
+    for (auto &h : held) {
+        if (h.msg.type == msg.type && h.key == key) {
+            merge(h.msg, msg);
+            return true;
+        }
+    }
+
+    Held h;
+    h.key = key;
+    h.at_batch_end = policy.mode == CoalesceMode::LATEST;
+    h.deadline = Clock::now() + std::chrono::milliseconds(policy.window_ms);
+    h.msg = msg;
+    held.push_back(std::move(h));
+    return true;
+}
+
+bool EventCoalescer::release(EventMessage &msg, const bool batch_end) {
+    if (held.empty())
+        return false;
+
+    const auto now = Clock::now();
+    for (auto it = held.begin(); it != held.end(); ++it) {
+        const bool due =
+            it->at_batch_end ? batch_end : it->deadline <= now;
+        if (!due)
+            continue;
+
+        msg = std::move(it->msg);
+        held.erase(it);
+        return true;
+    }
+    return false;
+}
+
+int EventCoalescer::get_timeout_ms() const {
+    if (held.empty())
+        return -1;
+
+    const auto now = Clock::now();
+    auto timeout = std::chrono::milliseconds::max();
+    for (const auto &h : held) {
+        if (h.at_batch_end || h.deadline <= now)
+            return 0;
+
+        // Round up so the caller does not wake just before the deadline
+        const auto remaining =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                h.deadline - now + std::chrono::microseconds(999));
+        timeout = std::min(timeout, remaining);
+    }
+    return static_cast<int>(timeout.count());
+}
+
+size_t EventCoalescer::size() const { return held.size(); }
+
+uint64_t EventCoalescer::key_of(const EventMessage &msg) {
+    switch (msg.type) {
+    case Event::TAG_CHANGE:
+        return msg.tag_change.monitor_num;
+    case Event::CLIENT_FOCUS_CHANGE:
+        return msg.client_focus_change.monitor_num;
+    case Event::LAYOUT_CHANGE:
+        return msg.layout_change.monitor_num;
+    case Event::MONITOR_FOCUS_CHANGE:
+        return 0;
+    case Event::FOCUSED_TITLE_CHANGE:
+        return msg.focused_title_change.client_window_id;
+    case Event::FOCUSED_STATE_CHANGE:
+        return msg.focused_state_change.client_window_id;
+    }
+    return 0;
+}
+
+void EventCoalescer::merge(EventMessage &into, const EventMessage &msg) {
+    // Keep the old_* values of the first event and take everything else from
+    // the latest one
+    switch (msg.type) {
+    case Event::TAG_CHANGE:
+        into.tag_change.monitor_num = msg.tag_change.monitor_num;
+        into.tag_change.new_state = msg.tag_change.new_state;
+        break;
+    case Event::CLIENT_FOCUS_CHANGE:
+        into.client_focus_change.monitor_num =
+            msg.client_focus_change.monitor_num;
+        into.client_focus_change.new_win_id =
+            msg.client_focus_change.new_win_id;
+        break;
+    case Event::LAYOUT_CHANGE:
+        into.layout_change.monitor_num = msg.layout_change.monitor_num;
+        into.layout_change.new_symbol = msg.layout_change.new_symbol;
+        into.layout_change.new_address = msg.layout_change.new_address;
+        break;
+    case Event::MONITOR_FOCUS_CHANGE:
+        into.monitor_focus_change.new_mon_num =
+            msg.monitor_focus_change.new_mon_num;
+        break;
+    case Event::FOCUSED_TITLE_CHANGE:
+        into.focused_title_change.monitor_num =
+            msg.focused_title_change.monitor_num;
+        into.focused_title_change.client_window_id =
+            msg.focused_title_change.client_window_id;
+        into.focused_title_change.new_name = msg.focused_title_change.new_name;
+        break;
+    case Event::FOCUSED_STATE_CHANGE:
+        into.focused_state_change.monitor_num =
+            msg.focused_state_change.monitor_num;
+        into.focused_state_change.client_window_id =
+            msg.focused_state_change.client_window_id;
+        into.focused_state_change.new_state =
+            msg.focused_state_change.new_state;
+        break;
+    }
+}
+
+} // namespace dwmipc
@@ -0,0 +1,69 @@
+/**
+ * @file event_filter.cpp
+ *
+ * This file contains the implementation details for the EventFilter struct.
+ */
+
+#include "dwmipcpp/event_filter.hpp"
+
+#include "dwmipcpp/json_scanner.hpp"
+
+namespace dwmipc {
+// Shorthand for matching the keys returned by JsonScanner::next_key
+#define KEY_IS(lit) JsonScanner::key_is(key, len, lit)
+
+bool EventFilter::accepts(const char *payload, const uint32_t size) const {
+    if (accepts_all())
+        return true;
+
+    JsonScanner s(payload, payload + size);
+    const char *key;
+    size_t len;
+
+    // The event name is the only key of the top level object
+    Event type;
+    if (!s.begin_object() || !s.next_key(key, len) ||
+        !event_from_name(key, len, type))
+        return true;
+
+    if (!(events & static_cast<uint8_t>(type)))
+        return false;
+    if (!match_monitor && !match_window)
+        return true;
+
+    // Only the fields that identify a monitor or window are read. Either one
+    // of a pair of old and new fields matching is enough.
+    bool has_monitor = false, monitor_ok = false;
+    bool has_window = false, window_ok = false;
+
+    if (!s.begin_object())
+        return true;
+    while (s.next_key(key, len)) {
+        uint64_t value;
+        if (KEY_IS("monitor_number") || KEY_IS("old_monitor_number") ||
+            KEY_IS("new_monitor_number")) {
+            if (!s.read_uint(value))
+                return true;
+            has_monitor = true;
+            monitor_ok |= value == monitor_num;
+        } else if (KEY_IS("client_window_id") || KEY_IS("old_win_id") ||
+                   KEY_IS("new_win_id")) {
+            if (!s.read_uint(value))
+                return true;
+            has_window = true;
+            window_ok |= value == window_id;
+        } else if (!s.skip_value()) {
+            return true;
+        }
+    }
+    if (s.failed())
+        return true;
+
+    if (match_monitor && has_monitor && !monitor_ok)
+        return false;
+    if (match_window && has_window && !window_ok)
+        return false;
+    return true;
+}
+
+} // namespace dwmipc
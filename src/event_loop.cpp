@@ -0,0 +1,303 @@
+/**
+ * @file event_loop.cpp
+ *
+ * This file contains the implementation details for the EventLoop class.
+ */
+
+#include "dwmipcpp/event_loop.hpp"
+
+#include <cerrno>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace dwmipc {
+/**
+ * Maximum number of ready sources returned by one epoll_wait
+ */
+static constexpr int MAX_READY = 16;
+
+/**
+ * Set a timerfd to fire after interval_ms, and optionally every interval_ms
+ * after that. An interval of 0 disarms the timer.
+ */
+static void set_timerfd(const int fd, const unsigned int interval_ms,
+                        const bool repeat) {
+    struct itimerspec spec = {};
+    spec.it_value.tv_sec = interval_ms / 1000;
+    spec.it_value.tv_nsec = (interval_ms % 1000) * 1000 * 1000;
+
+    // A zero it_value disarms the timer, so fire as soon as possible instead
+    if (interval_ms == 0)
+        spec.it_value.tv_nsec = 1;
+
+    if (repeat)
+        spec.it_interval = spec.it_value;
+
+    if (timerfd_settime(fd, 0, &spec, nullptr) < 0)
+        throw ErrnoError("Failed to set timer");
+}
+
+EventLoop::EventLoop(Connection &connection)
+    : connection(connection),
+      reconnect_blocking(connection.is_event_reconnect_blocking()) {
+    this->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (this->epoll_fd < 0)
+        throw ErrnoError("Failed to create epoll instance");
+
+    this->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    this->reconnect_fd =
+        timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (this->wake_fd < 0 || this->reconnect_fd < 0) {
+        const ErrnoError err("Failed to create event loop file descriptors");
+        if (this->wake_fd >= 0)
+            close(this->wake_fd);
+        if (this->reconnect_fd >= 0)
+            close(this->reconnect_fd);
+        close(this->epoll_fd);
+        throw err;
+    }
+
+    auto wake = std::make_shared<Source>();
+    wake->kind = Source::Kind::WAKE;
+    watch(this->wake_fd, EPOLLIN, wake);
+
+    auto reconnect = std::make_shared<Source>();
+    reconnect->kind = Source::Kind::RECONNECT;
+    watch(this->reconnect_fd, EPOLLIN, reconnect);
+
+    // Reconnect from the loop's timer rather than blocking the loop
+    connection.set_event_reconnect_blocking(false);
+}
+
+EventLoop::~EventLoop() {
+    connection.set_event_reconnect_blocking(this->reconnect_blocking);
+
+    for (const auto &entry : timers)
+        close(entry.second);
+
+    close(this->reconnect_fd);
+    close(this->wake_fd);
+    close(this->epoll_fd);
+}
+
+void EventLoop::watch(const int fd, const uint32_t events,
+                      const std::shared_ptr<Source> &source) {
+    struct epoll_event ev = {};
+    ev.events = events;
+    ev.data.fd = fd;
+
+    if (epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        throw ErrnoError("Failed to add file descriptor to epoll");
+
+    sources[fd] = source;
+}
+
+void EventLoop::unwatch(const int fd) {
+    // The fd may already be closed, in which case the kernel already removed
+    // it from the epoll set
+    epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    sources.erase(fd);
+}
+
+EventLoop::TimerId EventLoop::add_timer(const unsigned int interval_ms,
+                                        const std::function<void()> &callback,
+                                        const bool repeat) {
+    const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0)
+        throw ErrnoError("Failed to create timer");
+
+    auto source = std::make_shared<Source>();
+    source->kind = Source::Kind::TIMER;
+    source->callback = [callback](uint32_t) { callback(); };
+    source->repeat = repeat;
+    source->timer_id = this->next_timer_id++;
+
+    try {
+        set_timerfd(fd, interval_ms, repeat);
+        watch(fd, EPOLLIN, source);
+    } catch (const ErrnoError &) {
+        close(fd);
+        throw;
+    }
+    timers[source->timer_id] = fd;
+    return source->timer_id;
+}
+
+void EventLoop::remove_timer(const TimerId id) {
+    auto it = timers.find(id);
+    if (it == timers.end())
+        return;
+
+    const int fd = it->second;
+    timers.erase(it);
+    unwatch(fd);
+    close(fd);
+}
+
+void EventLoop::add_fd(const int fd,
+                       const std::function<void(uint32_t)> &callback,
+                       const uint32_t events) {
+    auto source = std::make_shared<Source>();
+    source->kind = Source::Kind::USER_FD;
+    source->callback = callback;
+    watch(fd, events, source);
+}
+
+void EventLoop::remove_fd(const int fd) {
+    auto it = sources.find(fd);
+    if (it == sources.end() || it->second->kind != Source::Kind::USER_FD)
+        return;
+
+    unwatch(fd);
+}
+
+void EventLoop::set_reconnect_timer(const bool armed) {
+    // Rearming would push the next attempt back every round
+    if (armed == this->reconnect_armed)
+        return;
+    this->reconnect_armed = armed;
+
+    if (armed) {
+        set_timerfd(this->reconnect_fd, reconnect_interval_ms, true);
+    } else {
+        struct itimerspec spec = {};
+        timerfd_settime(this->reconnect_fd, 0, &spec, nullptr);
+    }
+}
+
+void EventLoop::register_event_socket() {
+    if (this->event_fd != -1)
+        return;
+
+    if (!connection.is_event_socket_connected()) {
+        set_reconnect_timer(true);
+        return;
+    }
+
+    // With the event thread enabled, this is the thread's notify fd
+    auto source = std::make_shared<Source>();
+    source->kind = Source::Kind::EVENT_SOCKET;
+    this->event_fd = connection.get_event_wait_fd();
+    this->event_generation = connection.get_event_socket_generation();
+    watch(this->event_fd, EPOLLIN, source);
+}
+
+void EventLoop::handle_events() {
+    try {
+        connection.handle_events();
+    } catch (const SocketClosedError &) {
+        // A closed socket was already removed from epoll by the kernel, but
+        // the event thread's fd stays open
+        unwatch(this->event_fd);
+        this->event_fd = -1;
+        set_reconnect_timer(true);
+    } catch (const IPCError &err) {
+        if (!on_error)
+            throw;
+        on_error(err);
+    }
+}
+
+void EventLoop::try_reconnect() {
+    if (!connection.try_reconnect_event_socket())
+        return;
+
+    set_reconnect_timer(false);
+    register_event_socket();
+}
+
+int EventLoop::run_once(const int timeout_ms) {
+    struct epoll_event events[MAX_READY];
+
+    // The connection may have been reconnected outside of the loop, possibly
+    // reusing the same file descriptor number
+    if (this->event_fd != connection.get_event_wait_fd() ||
+        this->event_generation != connection.get_event_socket_generation()) {
+        if (this->event_fd != -1)
+            unwatch(this->event_fd);
+        this->event_fd = -1;
+    }
+    register_event_socket();
+
+    // Events the connection already received will not make the socket
+    // readable, so don't sleep until they have been dispatched
+    const bool pending =
+        this->event_fd != -1 && connection.has_pending_events();
+
+    // Wake up in time to dispatch coalesced events once they are due
+    int wait_ms = pending ? 0 : timeout_ms;
+    const int coalesce_ms =
+        this->event_fd != -1 ? connection.get_coalesce_timeout_ms() : -1;
+    if (coalesce_ms >= 0 && (wait_ms < 0 || coalesce_ms < wait_ms))
+        wait_ms = coalesce_ms;
+
+    int n;
+    do {
+        n = epoll_wait(this->epoll_fd, events, MAX_READY, wait_ms);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0)
+        throw ErrnoError("Failed to wait for events");
+
+    if (pending || (coalesce_ms >= 0 && n == 0))
+        handle_events();
+
+    for (int i = 0; i < n; i++) {
+        const int fd = events[i].data.fd;
+        auto it = sources.find(fd);
+
+        // Source was removed by an earlier callback in this round
+        if (it == sources.end())
+            continue;
+
+        // Keep the source alive in case its callback removes it
+        const std::shared_ptr<Source> source = it->second;
+        uint64_t count;
+
+        switch (source->kind) {
+        case Source::Kind::EVENT_SOCKET:
+            handle_events();
+            break;
+        case Source::Kind::TIMER:
+            if (read(fd, &count, sizeof(count)) < 0)
+                break;
+            if (!source->repeat)
+                remove_timer(source->timer_id);
+            source->callback(events[i].events);
+            break;
+        case Source::Kind::USER_FD:
+            source->callback(events[i].events);
+            break;
+        case Source::Kind::WAKE:
+            if (read(fd, &count, sizeof(count)) < 0)
+                break;
+            break;
+        case Source::Kind::RECONNECT:
+            if (read(fd, &count, sizeof(count)) < 0)
+                break;
+            try_reconnect();
+            break;
+        }
+    }
+
+    return n;
+}
+
+void EventLoop::run() {
+    this->running = true;
+    while (this->running)
+        run_once(-1);
+}
+
+void EventLoop::stop() {
+    this->running = false;
+
+    const uint64_t one = 1;
+    if (write(this->wake_fd, &one, sizeof(one)) < 0) {
+        // The counter can only overflow if the loop is not draining it, in
+        // which case it is already awake
+    }
+}
+
+} // namespace dwmipc
@@ -0,0 +1,244 @@
+/**
+ * @file event_reader_thread.cpp
+ *
+ * This file contains the implementation details for the EventReaderThread
+ * class.
+ */
+
+#include "dwmipcpp/event_reader_thread.hpp"
+
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "dwmipcpp/errors.hpp"
+#include "dwmipcpp/types.hpp"
+
+namespace dwmipc {
+/**
+ * Reset an eventfd, ignoring whether it was signalled
+ */
+static void drain_eventfd(const int fd) {
+    uint64_t count;
+    if (read(fd, &count, sizeof(count)) < 0) {
+        // Not signalled
+    }
+}
+
+EventReaderThread::~EventReaderThread() {
+    stop();
+
+    if (this->notify != -1)
+        close(this->notify);
+    if (this->wake != -1)
+        close(this->wake);
+}
+
+void EventReaderThread::init(const size_t capacity) {
+    if (this->notify == -1) {
+        this->notify = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        this->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (this->notify < 0 || this->wake < 0) {
+            const ErrnoError err(
+                "Failed to create event thread file descriptors");
+            if (this->notify >= 0)
+                close(this->notify);
+            if (this->wake >= 0)
+                close(this->wake);
+            this->notify = -1;
+            this->wake = -1;
+            throw err;
+        }
+    }
+
+    if (empty())
+        this->ring.reset(new SpscRing<Slot>(capacity));
+}
+
+void EventReaderThread::start(const int sockfd, FrameReader &reader,
+                              const Decoder decoder,
+                              const EventFilter &filter,
+                              TrafficRecorder *recorder) {
+    this->filter = filter;
+    this->recorder = recorder;
+    this->filled = TrafficRecorder::Clock::now();
+    this->stopping = false;
+    this->waiting = false;
+    this->finished = false;
+    this->socket_lost = false;
+    this->failure = nullptr;
+    drain_eventfd(this->wake);
+
+    this->thread = std::thread(&EventReaderThread::run, this, sockfd,
+                               std::ref(reader), decoder);
+}
+
+void EventReaderThread::stop() {
+    if (!this->thread.joinable())
+        return;
+
+    this->stopping = true;
+    signal(this->wake);
+    this->thread.join();
+}
+
+bool EventReaderThread::lost() const {
+    return this->finished.load(std::memory_order_acquire) && this->socket_lost;
+}
+
+std::exception_ptr EventReaderThread::error() const {
+    if (!this->finished.load(std::memory_order_acquire))
+        return nullptr;
+    return this->failure;
+}
+
+void EventReaderThread::clear_notify() { drain_eventfd(this->notify); }
+
+void EventReaderThread::pop() {
+    this->ring->commit_read();
+
+    // Pairs with the fence in publish, so that either the thread sees the
+    // free slot or this sees that the thread is waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (this->waiting.load(std::memory_order_relaxed)) {
+        this->waiting = false;
+        signal(this->wake);
+    }
+}
+
+EventThreadStats EventReaderThread::get_stats() const {
+    EventThreadStats stats;
+    stats.received = this->received.load(std::memory_order_relaxed);
+    stats.stalls = this->stalls.load(std::memory_order_relaxed);
+    stats.queued = this->ring ? this->ring->size() : 0;
+    stats.capacity = this->ring ? this->ring->capacity() : 0;
+    return stats;
+}
+
+void EventReaderThread::run(const int sockfd, FrameReader &reader,
+                            const Decoder decoder) {
+    try {
+        bool drained = false;
+        while (true) {
+            if (!publish(reader, decoder))
+                return;
+
+            if (drained) {
+                wait(sockfd);
+                if (this->stopping)
+                    return;
+            }
+            if (reader.fill(sockfd, drained) > 0 && this->recorder)
+                this->filled = TrafficRecorder::Clock::now();
+        }
+    } catch (const SocketClosedError &) {
+        this->socket_lost = true;
+    } catch (...) {
+        this->failure = std::current_exception();
+    }
+
+    this->finished.store(true, std::memory_order_release);
+    signal(this->notify);
+}
+
+bool EventReaderThread::publish(FrameReader &reader, const Decoder decoder) {
+    size_t count = 0;
+    size_t dropped = 0;
+    Frame frame;
+
+    while (true) {
+        // Take a slot before the frame, so that no frame is lost if the
+        // thread is stopped while waiting for room
+        Slot *slot = this->ring->write_slot();
+        if (!slot) {
+            // Let the consumer handle what was published so far
+            if (count > 0) {
+                signal(this->notify);
+                this->received += count;
+                count = 0;
+            }
+            this->stalls++;
+
+            while (!slot) {
+                this->waiting = true;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                slot = this->ring->write_slot();
+                if (slot)
+                    break;
+
+                wait(-1);
+                if (this->stopping)
+                    return false;
+                slot = this->ring->write_slot();
+            }
+            this->waiting = false;
+        }
+
+        if (!reader.next(frame))
+            break;
+
+        if (this->recorder)
+            this->recorder->record(this->filled, SocketRole::EVENT,
+                                   Direction::RECEIVED, frame.type,
+                                   frame.payload, frame.size);
+
+        // Rejected events don't take up a slot. The slot is reused for the
+        // next frame.
+        if (frame.type == static_cast<uint8_t>(MessageType::EVENT) &&
+            !this->filter.accepts(frame.payload, frame.size)) {
+            dropped++;
+            continue;
+        }
+
+        slot->type = frame.type;
+        slot->payload.assign(frame.payload, frame.size);
+        slot->decoded = false;
+        if (frame.type == static_cast<uint8_t>(MessageType::EVENT)) {
+            if (decoder == Decoder::STREAMING)
+                slot->decoded = decode_event(frame.payload, frame.size,
+                                             slot->msg);
+            if (!slot->decoded) {
+                // Malformed events are reported when they are handled
+                try {
+                    Json::Value root;
+                    pre_parse_reply(root, frame.payload, frame.size);
+                    slot->decoded = parse_event(root, slot->msg);
+                } catch (const std::exception &) {
+                }
+            }
+        }
+
+        this->ring->commit_write();
+        count++;
+    }
+
+    if (count > 0)
+        signal(this->notify);
+    if (count + dropped > 0)
+        this->received += count + dropped;
+    return !this->stopping;
+}
+
+void EventReaderThread::wait(const int sockfd) {
+    struct pollfd fds[2] = {{this->wake, POLLIN, 0}, {sockfd, POLLIN, 0}};
+    const nfds_t count = sockfd < 0 ? 1 : 2;
+
+    while (poll(fds, count, -1) < 0) {
+        if (errno != EINTR)
+            throw ErrnoError("Error waiting for events");
+    }
+
+    if (fds[0].revents)
+        drain_eventfd(this->wake);
+}
+
+void EventReaderThread::signal(const int fd) {
+    const uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) < 0) {
+        // The counter can only overflow if nobody is draining it, in which
+        // case the other thread is already awake
+    }
+}
+
+} // namespace dwmipc
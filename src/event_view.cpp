@@ -0,0 +1,137 @@
+/**
+ * @file event_view.cpp
+ *
+ * This file contains the implementation details for the lazy event views.
+ */
+
+#include "dwmipcpp/event_view.hpp"
+
+#include "dwmipcpp/json_scanner.hpp"
+
+namespace dwmipc {
+// Pass a string literal key along with its length
+#define KEY(lit) lit, sizeof(lit) - 1
+
+StringRef EventView::raw() const {
+    StringRef ref;
+    if (!this->body)
+        return ref;
+
+    // Measure the body by skipping over it
+    JsonScanner s(this->body, this->end);
+    if (s.skip_value()) {
+        ref.data = this->body;
+        ref.size = s.position() - this->body;
+    }
+    return ref;
+}
+
+void EventView::reset(const Event ev, const char *body, const char *end) {
+    this->ev = ev;
+    this->body = body;
+    this->end = end;
+}
+
+bool EventView::find(const char *key, const size_t len, JsonScanner &s) const {
+    const char *k;
+    size_t k_len;
+
+    if (!s.begin_object())
+        return false;
+    while (s.next_key(k, k_len)) {
+        if (k_len == len && std::memcmp(k, key, len) == 0)
+            return true;
+        if (!s.skip_value())
+            return false;
+    }
+    return false;
+}
+
+uint64_t EventView::get_uint(const char *key, const size_t len) const {
+    JsonScanner s(this->body, this->end);
+    uint64_t value;
+    if (!find(key, len, s) || !s.read_uint(value))
+        return 0;
+    return value;
+}
+
+StringRef EventView::get_string(const char *key, const size_t len,
+                                std::string &scratch) const {
+    JsonScanner s(this->body, this->end);
+    StringRef ref;
+    const char *str;
+    size_t str_len;
+    bool escaped;
+
+    if (!find(key, len, s) || !s.read_raw_string(str, str_len, escaped))
+        return ref;
+
+    if (!escaped) {
+        ref.data = str;
+        ref.size = str_len;
+        return ref;
+    }
+
+    // The unescaped string is never longer than the raw one
+    scratch.resize(str_len);
+    const long unescaped_len = JsonScanner::unescape(str, str_len, &scratch[0]);
+    if (unescaped_len < 0)
+        return ref;
+
+    ref.data = scratch.data();
+    ref.size = unescaped_len;
+    return ref;
+}
+
+unsigned int FocusedTitleChangeView::monitor_num() const {
+    return get_uint(KEY("monitor_number"));
+}
+
+Window FocusedTitleChangeView::client_window_id() const {
+    return get_uint(KEY("client_window_id"));
+}
+
+StringRef FocusedTitleChangeView::old_name() const {
+    return get_string(KEY("old_name"), old_scratch);
+}
+
+StringRef FocusedTitleChangeView::new_name() const {
+    return get_string(KEY("new_name"), new_scratch);
+}
+
+unsigned int LayoutChangeView::monitor_num() const {
+    return get_uint(KEY("monitor_number"));
+}
+
+StringRef LayoutChangeView::old_symbol() const {
+    return get_string(KEY("old_symbol"), old_scratch);
+}
+
+uintptr_t LayoutChangeView::old_address() const {
+    return get_uint(KEY("old_address"));
+}
+
+StringRef LayoutChangeView::new_symbol() const {
+    return get_string(KEY("new_symbol"), new_scratch);
+}
+
+uintptr_t LayoutChangeView::new_address() const {
+    return get_uint(KEY("new_address"));
+}
+
+bool locate_event(const char *payload, const uint32_t size, Event &ev,
+                  const char *&body) {
+    JsonScanner s(payload, payload + size);
+    const char *key;
+    size_t len;
+
+    // The event name is the only key of the top level object
+    if (!s.begin_object() || !s.next_key(key, len) ||
+        !event_from_name(key, len, ev))
+        return false;
+
+    body = s.position();
+    return true;
+}
+
+} // namespace dwmipc
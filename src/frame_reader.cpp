@@ -0,0 +1,105 @@
+/**
+ * @file frame_reader.cpp
+ *
+ * This file contains the implementation details for the FrameReader class.
+ */
+
+#include "dwmipcpp/frame_reader.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+#include "dwmipcpp/errors.hpp"
+#include "dwmipcpp/packet.hpp"
+
+namespace dwmipc {
+FrameReader::FrameReader(const size_t capacity) : buf(capacity) {}
+
+void FrameReader::make_room() {
+    // Move the partial packet to the front of the buffer
+    if (this->start > 0) {
+        std::memmove(buf.data(), buf.data() + start, end - start);
+        this->end -= this->start;
+        this->start = 0;
+    }
+
+    // If the header of the partial packet has been received, make sure the
+    // whole packet fits
+    if (this->end >= Packet::HEADER_SIZE) {
+        const Packet::Header *header =
+            reinterpret_cast<const Packet::Header *>(buf.data());
+        uint32_t size;
+        std::memcpy(&size, &header->size, sizeof(size));
+
+        const size_t needed = Packet::HEADER_SIZE + size;
+        if (needed > buf.size())
+            buf.resize(needed);
+    }
+}
+
+size_t FrameReader::fill(const int fd, bool &drained) {
+    make_room();
+
+    const size_t space = buf.size() - this->end;
+
+    while (true) {
+        const ssize_t n = read(fd, buf.data() + end, space);
+
+        if (n == 0) {
+            throw SocketClosedError(fd);
+        } else if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                drained = true;
+                return 0;
+            }
+            throw ErrnoError("Error reading from dwm socket");
+        }
+
+        // A read that did not fill the buffer emptied the socket
+        drained = static_cast<size_t>(n) < space;
+        this->end += n;
+        return n;
+    }
+}
+
+bool FrameReader::next(Frame &frame) {
+    const size_t available = this->end - this->start;
+    if (available < Packet::HEADER_SIZE)
+        return false;
+
+    char *walk = buf.data() + start;
+    const Packet::Header *header =
+        reinterpret_cast<const Packet::Header *>(walk);
+
+    // Check if magic string is correct
+    if (std::memcmp(header->magic, DWM_MAGIC, DWM_MAGIC_LEN) != 0) {
+        const std::string magic(walk, DWM_MAGIC_LEN);
+        clear();
+        throw HeaderError("Invalid magic string: " + magic);
+    }
+
+    uint32_t size;
+    std::memcpy(&size, &header->size, sizeof(size));
+    if (available - Packet::HEADER_SIZE < size)
+        return false;
+
+    frame.type = header->type;
+    frame.size = size;
+    frame.payload = walk + Packet::HEADER_SIZE;
+    this->start += Packet::HEADER_SIZE + size;
+
+    // Rewind to the front once everything has been extracted so that the
+    // next fill has the whole buffer available without moving any bytes
+    if (this->start == this->end)
+        this->start = this->end = 0;
+
+    return true;
+}
+
+void FrameReader::clear() { this->start = this->end = 0; }
+
+} // namespace dwmipc
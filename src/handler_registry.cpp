@@ -0,0 +1,122 @@
+/**
+ * @file handler_registry.cpp
+ *
+ * This file contains the implementation details for the HandlerRegistry
+ * class.
+ */
+
+#include "dwmipcpp/handler_registry.hpp"
+
+namespace dwmipc {
+bool HandlerRegistry::remove(HandlerToken &token) {
+    if (!token.valid())
+        return false;
+
+    bool removed = false;
+    switch (token.event) {
+    case Event::TAG_CHANGE:
+        removed = tag_change.remove(token.id);
+        break;
+    case Event::CLIENT_FOCUS_CHANGE:
+        removed = client_focus_change.remove(token.id);
+        break;
+    case Event::LAYOUT_CHANGE:
+        removed = layout_change.remove(token.id) ||
+                  layout_change_view.remove(token.id);
+        break;
+    case Event::MONITOR_FOCUS_CHANGE:
+        removed = monitor_focus_change.remove(token.id);
+        break;
+    case Event::FOCUSED_TITLE_CHANGE:
+        removed = focused_title_change.remove(token.id) ||
+                  focused_title_change_view.remove(token.id);
+        break;
+    case Event::FOCUSED_STATE_CHANGE:
+        removed = focused_state_change.remove(token.id);
+        break;
+    }
+
+    token.id = 0;
+    return removed;
+}
+
+size_t HandlerRegistry::count(const Event ev) const {
+    switch (ev) {
+    case Event::TAG_CHANGE:
+        return tag_change.size();
+    case Event::CLIENT_FOCUS_CHANGE:
+        return client_focus_change.size();
+    case Event::LAYOUT_CHANGE:
+        return layout_change.size() + layout_change_view.size();
+    case Event::MONITOR_FOCUS_CHANGE:
+        return monitor_focus_change.size();
+    case Event::FOCUSED_TITLE_CHANGE:
+        return focused_title_change.size() + focused_title_change_view.size();
+    case Event::FOCUSED_STATE_CHANGE:
+        return focused_state_change.size();
+    }
+    return 0;
+}
+
+bool HandlerRegistry::has_event_handlers(const Event ev) const {
+    switch (ev) {
+    case Event::LAYOUT_CHANGE:
+        return layout_change.size() > 0;
+    case Event::FOCUSED_TITLE_CHANGE:
+        return focused_title_change.size() > 0;
+    default:
+        return count(ev) > 0;
+    }
+}
+
+bool HandlerRegistry::has_view_handlers(const Event ev) const {
+    switch (ev) {
+    case Event::LAYOUT_CHANGE:
+        return layout_change_view.size() > 0;
+    case Event::FOCUSED_TITLE_CHANGE:
+        return focused_title_change_view.size() > 0;
+    default:
+        return false;
+    }
+}
+
+void HandlerRegistry::dispatch(const EventMessage &msg) {
+    switch (msg.type) {
+    case Event::TAG_CHANGE:
+        tag_change.dispatch(msg.tag_change);
+        break;
+    case Event::CLIENT_FOCUS_CHANGE:
+        client_focus_change.dispatch(msg.client_focus_change);
+        break;
+    case Event::LAYOUT_CHANGE:
+        layout_change.dispatch(msg.layout_change);
+        break;
+    case Event::MONITOR_FOCUS_CHANGE:
+        monitor_focus_change.dispatch(msg.monitor_focus_change);
+        break;
+    case Event::FOCUSED_TITLE_CHANGE:
+        focused_title_change.dispatch(msg.focused_title_change);
+        break;
+    case Event::FOCUSED_STATE_CHANGE:
+        focused_state_change.dispatch(msg.focused_state_change);
+        break;
+    }
+}
+
+void HandlerRegistry::dispatch_view(const Event ev, const char *body,
+                                    const char *end) {
+    switch (ev) {
+    case Event::LAYOUT_CHANGE:
+        layout_view.reset(ev, body, end);
+        layout_change_view.dispatch(layout_view);
+        break;
+    case Event::FOCUSED_TITLE_CHANGE:
+        title_view.reset(ev, body, end);
+        focused_title_change_view.dispatch(title_view);
+        break;
+    default:
+        break;
+    }
+}
+
+} // namespace dwmipc
@@ -0,0 +1,462 @@
+/**
+ * @file json_scanner.cpp
+ *
+ * This file contains the implementation details for the JsonScanner class.
+ */
+
+#include "dwmipcpp/json_scanner.hpp"
+
+namespace dwmipc {
+/**
+ * Maximum nesting depth skip_value will descend into before giving up
+ */
+static constexpr unsigned MAX_DEPTH = 64;
+
+/**
+ * Exactly representable powers of 10
+ */
+static const double pow10_table[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                     1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                     1e18, 1e19, 1e20, 1e21, 1e22};
+
+static double scale_pow10(double value, int exponent) {
+    const int max_exp = sizeof(pow10_table) / sizeof(pow10_table[0]) - 1;
+
+    while (exponent > max_exp) {
+        value *= pow10_table[max_exp];
+        exponent -= max_exp;
+    }
+    while (exponent < -max_exp) {
+        value /= pow10_table[max_exp];
+        exponent += max_exp;
+    }
+
+    if (exponent >= 0)
+        return value * pow10_table[exponent];
+    return value / pow10_table[-exponent];
+}
+
+static int hex_value(const char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * Parse the 4 hex digits of a \u escape sequence
+ */
+static long parse_hex4(const char *str) {
+    long value = 0;
+    for (int i = 0; i < 4; i++) {
+        const int digit = hex_value(str[i]);
+        if (digit < 0)
+            return -1;
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+/**
+ * Encode a unicode code point as UTF-8
+ *
+ * @return The number of bytes written
+ */
+static size_t encode_utf8(unsigned long cp, char *out) {
+    if (cp < 0x80) {
+        out[0] = static_cast<char>(cp);
+        return 1;
+    } else if (cp < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (cp >> 6));
+        out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 2;
+    } else if (cp < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (cp >> 12));
+        out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (cp >> 18));
+    out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+JsonScanner::JsonScanner(const char *begin, const char *end)
+    : cur(begin), end(end), error(false), depth(0) {}
+
+void JsonScanner::skip_ws() {
+    while (cur < end &&
+           (*cur == ' ' || *cur == '\n' || *cur == '\t' || *cur == '\r'))
+        cur++;
+}
+
+bool JsonScanner::fail() {
+    this->error = true;
+    return false;
+}
+
+bool JsonScanner::consume(const char c) {
+    if (error)
+        return false;
+
+    skip_ws();
+    if (cur == end || *cur != c)
+        return fail();
+    cur++;
+    return true;
+}
+
+bool JsonScanner::begin_object() { return consume('{'); }
+
+bool JsonScanner::begin_array() { return consume('['); }
+
+bool JsonScanner::next_key(const char *&key, size_t &len) {
+    if (error)
+        return false;
+
+    skip_ws();
+    if (cur == end)
+        return fail();
+
+    if (*cur == '}') {
+        cur++;
+        return false;
+    } else if (*cur == ',') {
+        cur++;
+    }
+
+    bool escaped;
+    if (!read_raw_string(key, len, escaped))
+        return false;
+
+    return consume(':');
+}
+
+bool JsonScanner::next_element() {
+    if (error)
+        return false;
+
+    skip_ws();
+    if (cur == end)
+        return fail();
+
+    if (*cur == ']') {
+        cur++;
+        return false;
+    } else if (*cur == ',') {
+        cur++;
+    }
+    return true;
+}
+
+bool JsonScanner::read_number(Number &num) {
+    if (error)
+        return false;
+
+    skip_ws();
+    num.negative = false;
+    num.digits = 0;
+    num.exponent = 0;
+    num.is_integral = true;
+
+    if (cur < end && *cur == '-') {
+        num.negative = true;
+        cur++;
+    }
+
+    const char *start = cur;
+    while (cur < end && *cur >= '0' && *cur <= '9') {
+        // Keep the most significant digits and drop the rest into the exponent
+        if (num.digits < (UINT64_MAX - 9) / 10)
+            num.digits = num.digits * 10 + (*cur - '0');
+        else
+            num.exponent++;
+        cur++;
+    }
+    if (cur == start)
+        return fail();
+
+    if (cur < end && *cur == '.') {
+        num.is_integral = false;
+        cur++;
+        start = cur;
+        while (cur < end && *cur >= '0' && *cur <= '9') {
+            if (num.digits < (UINT64_MAX - 9) / 10) {
+                num.digits = num.digits * 10 + (*cur - '0');
+                num.exponent--;
+            }
+            cur++;
+        }
+        if (cur == start)
+            return fail();
+    }
+
+    if (cur < end && (*cur == 'e' || *cur == 'E')) {
+        num.is_integral = false;
+        cur++;
+
+        bool exp_negative = false;
+        if (cur < end && (*cur == '+' || *cur == '-')) {
+            exp_negative = *cur == '-';
+            cur++;
+        }
+
+        int exp = 0;
+        start = cur;
+        while (cur < end && *cur >= '0' && *cur <= '9') {
+            if (exp < 10000)
+                exp = exp * 10 + (*cur - '0');
+            cur++;
+        }
+        if (cur == start)
+            return fail();
+
+        num.exponent += exp_negative ? -exp : exp;
+    }
+
+    return true;
+}
+
+bool JsonScanner::read_uint(uint64_t &value) {
+    Number num;
+    if (!read_number(num))
+        return false;
+
+    if (num.is_integral && num.exponent == 0) {
+        value = num.negative ? static_cast<uint64_t>(-num.digits) : num.digits;
+        return true;
+    }
+
+    const double d = scale_pow10(static_cast<double>(num.digits), num.exponent);
+    value = num.negative ? 0 : static_cast<uint64_t>(d);
+    return true;
+}
+
+bool JsonScanner::read_int(int64_t &value) {
+    Number num;
+    if (!read_number(num))
+        return false;
+
+    if (num.is_integral && num.exponent == 0) {
+        value = static_cast<int64_t>(num.digits);
+    } else {
+        value = static_cast<int64_t>(
+            scale_pow10(static_cast<double>(num.digits), num.exponent));
+    }
+
+    if (num.negative)
+        value = -value;
+    return true;
+}
+
+bool JsonScanner::read_double(double &value) {
+    Number num;
+    if (!read_number(num))
+        return false;
+
+    value = scale_pow10(static_cast<double>(num.digits), num.exponent);
+    if (num.negative)
+        value = -value;
+    return true;
+}
+
+bool JsonScanner::skip_literal(const char *lit, const size_t len) {
+    if (static_cast<size_t>(end - cur) < len || std::memcmp(cur, lit, len) != 0)
+        return fail();
+    cur += len;
+    return true;
+}
+
+bool JsonScanner::read_bool(bool &value) {
+    if (error)
+        return false;
+
+    skip_ws();
+    if (cur == end)
+        return fail();
+
+    if (*cur == 't') {
+        value = true;
+        return skip_literal("true", 4);
+    } else if (*cur == 'f') {
+        value = false;
+        return skip_literal("false", 5);
+    }
+    return fail();
+}
+
+bool JsonScanner::read_raw_string(const char *&str, size_t &len,
+                                  bool &escaped) {
+    if (!consume('"'))
+        return false;
+
+    str = cur;
+    escaped = false;
+
+    while (cur < end) {
+        const char *quote =
+            static_cast<const char *>(std::memchr(cur, '"', end - cur));
+        if (!quote)
+            break;
+
+        // Check if quote is escaped by counting preceding backslashes
+        const char *walk = quote;
+        while (walk > str && *(walk - 1) == '\\')
+            walk--;
+
+        if ((quote - walk) % 2 == 0) {
+            len = quote - str;
+            cur = quote + 1;
+            escaped = std::memchr(str, '\\', len) != nullptr;
+            return true;
+        }
+        cur = quote + 1;
+    }
+    return fail();
+}
+
+long JsonScanner::unescape(const char *str, const size_t len, char *out) {
+    const char *walk = str;
+    const char *str_end = str + len;
+    char *dest = out;
+
+    while (walk < str_end) {
+        if (*walk != '\\') {
+            *dest++ = *walk++;
+            continue;
+        }
+
+        if (++walk == str_end)
+            return -1;
+
+        switch (*walk++) {
+        case '"':
+            *dest++ = '"';
+            break;
+        case '\\':
+            *dest++ = '\\';
+            break;
+        case '/':
+            *dest++ = '/';
+            break;
+        case 'b':
+            *dest++ = '\b';
+            break;
+        case 'f':
+            *dest++ = '\f';
+            break;
+        case 'n':
+            *dest++ = '\n';
+            break;
+        case 'r':
+            *dest++ = '\r';
+            break;
+        case 't':
+            *dest++ = '\t';
+            break;
+        case 'u': {
+            if (str_end - walk < 4)
+                return -1;
+            long cp = parse_hex4(walk);
+            if (cp < 0)
+                return -1;
+            walk += 4;
+
+            // Combine UTF-16 surrogate pairs
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                if (str_end - walk < 6 || walk[0] != '\\' || walk[1] != 'u')
+                    return -1;
+                const long low = parse_hex4(walk + 2);
+                if (low < 0xDC00 || low > 0xDFFF)
+                    return -1;
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                walk += 6;
+            }
+            // An escape sequence is always at least as long as its encoding
+            dest += encode_utf8(cp, dest);
+            break;
+        }
+        default:
+            return -1;
+        }
+    }
+    return dest - out;
+}
+
+bool JsonScanner::read_string(std::string &value) {
+    const char *str;
+    size_t len;
+    bool escaped;
+
+    if (!read_raw_string(str, len, escaped))
+        return false;
+
+    if (!escaped) {
+        value.assign(str, len);
+        return true;
+    }
+
+    value.resize(len);
+    const long out_len = unescape(str, len, &value[0]);
+    if (out_len < 0)
+        return fail();
+    value.resize(out_len);
+    return true;
+}
+
+bool JsonScanner::skip_value() {
+    if (error)
+        return false;
+
+    skip_ws();
+    if (cur == end)
+        return fail();
+
+    switch (*cur) {
+    case '"': {
+        const char *str;
+        size_t len;
+        bool escaped;
+        return read_raw_string(str, len, escaped);
+    }
+    case '{': {
+        if (++depth > MAX_DEPTH)
+            return fail();
+        cur++;
+        const char *key;
+        size_t len;
+        while (next_key(key, len))
+            if (!skip_value())
+                return false;
+        depth--;
+        return !error;
+    }
+    case '[':
+        if (++depth > MAX_DEPTH)
+            return fail();
+        cur++;
+        while (next_element())
+            if (!skip_value())
+                return false;
+        depth--;
+        return !error;
+    case 't':
+        return skip_literal("true", 4);
+    case 'f':
+        return skip_literal("false", 5);
+    case 'n':
+        return skip_literal("null", 4);
+    default: {
+        Number num;
+        return read_number(num);
+    }
+    }
+}
+
+} // namespace dwmipc
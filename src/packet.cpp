@@ -9,7 +9,8 @@
 #include "dwmipcpp/packet.hpp"
 
 namespace dwmipc {
-Packet::Packet(const uint32_t payload_size) : size(payload_size + HEADER_SIZE) {
+Packet::Packet(const uint32_t payload_size)
+    : size(payload_size + HEADER_SIZE), capacity(payload_size) {
     // Use malloc since primitive type, and to allow realloc
     this->data = (uint8_t *)malloc(sizeof(uint8_t) * size);
     this->header = (Header *)data;
@@ -22,16 +23,38 @@ Packet::Packet(const uint32_t payload_size) : size(payload_size + HEADER_SIZE) {
 Packet::Packet(const MessageType type, const std::string &msg)
     : Packet(msg.size() + 1) {
     this->header->type = static_cast<uint8_t>(type);
-    std::strncpy(this->payload, msg.c_str(), msg.size() + 1);
+    std::memcpy(this->payload, msg.c_str(), msg.size() + 1);
 }
 
 Packet::~Packet() { free(this->data); }
 
 void Packet::realloc_to_header_size() {
+    reserve(this->header->size);
     this->size = this->header->size + HEADER_SIZE;
-    this->data = (uint8_t *)realloc(this->data, this->size);
+}
+
+void Packet::reserve(const uint32_t payload_size) {
+    if (payload_size <= this->capacity)
+        return;
+
+    this->data = (uint8_t *)realloc(this->data, payload_size + HEADER_SIZE);
     this->header = (Header *)this->data;
     this->payload = (char *)(this->data + HEADER_SIZE);
+    this->capacity = payload_size;
+}
+
+void Packet::assign(const MessageType type, const std::string &msg) {
+    assign(static_cast<uint8_t>(type), msg.c_str(), msg.size() + 1);
+}
+
+void Packet::assign(const uint8_t type, const char *payload,
+                    const uint32_t payload_size) {
+    reserve(payload_size);
+
+    this->size = payload_size + HEADER_SIZE;
+    this->header->size = payload_size;
+    this->header->type = type;
+    std::memcpy(this->payload, payload, payload_size);
 }
 
 } // namespace dwmipc
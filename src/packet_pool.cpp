@@ -0,0 +1,100 @@
+/**
+ * @file packet_pool.cpp
+ *
+ * This file contains the implementation details for the PacketPool class.
+ */
+
+#include "dwmipcpp/packet_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace dwmipc {
+constexpr size_t PacketPool::DEFAULT_MAX_PACKETS;
+constexpr uint32_t PacketPool::MAX_POOLED_CAPACITY;
+
+PacketPool::PacketPool(const size_t max_packets) : max_packets(max_packets) {
+    packets.reserve(max_packets);
+}
+
+std::shared_ptr<Packet> PacketPool::acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return take(0);
+}
+
+std::shared_ptr<Packet> PacketPool::acquire(const MessageType type,
+                                            const std::string &msg) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto packet = take(msg.size() + 1);
+    packet->assign(type, msg);
+    return packet;
+}
+
+void PacketPool::observe(const uint32_t payload_size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (payload_size > MAX_POOLED_CAPACITY)
+        return;
+
+    // Move an eighth of the way towards each new size, so one large reply
+    // barely affects the size of the packets handed out after it
+    if (typical_size == 0) {
+        typical_size = payload_size;
+    } else {
+        const int64_t delta = static_cast<int64_t>(payload_size) -
+                              static_cast<int64_t>(typical_size);
+        typical_size = static_cast<uint32_t>(typical_size + delta / 8);
+    }
+}
+
+PacketPoolStats PacketPool::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    PacketPoolStats result = stats;
+    result.pooled = packets.size();
+    return result;
+}
+
+std::shared_ptr<Packet> PacketPool::take(const uint32_t payload_size) {
+    // New packets get room for a typical message, but a reused packet only
+    // grows for the message it is about to hold
+    const uint32_t wanted = std::max(payload_size, typical_size);
+
+    // A packet is free once the pool holds the only reference to it. Nobody
+    // else can gain a reference to it after that, so it is safe to reuse.
+    for (size_t n = 0; n < packets.size(); n++) {
+        const size_t i = (next + n) % packets.size();
+        auto &packet = packets[i];
+        if (packet.use_count() != 1)
+            continue;
+
+        // use_count is a relaxed load. The last reference may have been
+        // dropped on another thread, such as the I/O thread or the event
+        // thread, so make its accesses to the packet happen before ours. The
+        // release half is the decrement done by shared_ptr's destructor.
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        next = i + 1;
+
+        if (packet->capacity > MAX_POOLED_CAPACITY) {
+            // Drop the buffer grown by an oversize message. This allocates
+            // like a miss, so count it as one.
+            packet = std::make_shared<Packet>(wanted);
+            stats.misses++;
+            return packet;
+        }
+
+        stats.hits++;
+        if (packet->capacity < payload_size) {
+            packet->reserve(payload_size);
+            stats.grows++;
+        }
+        return packet;
+    }
+
+    stats.misses++;
+    auto packet = std::make_shared<Packet>(wanted);
+    if (packets.size() < max_packets)
+        packets.push_back(packet);
+    return packet;
+}
+
+} // namespace dwmipc
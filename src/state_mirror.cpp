@@ -0,0 +1,264 @@
+/**
+ * @file state_mirror.cpp
+ *
+ * This file contains the implementation details for the StateMirror class.
+ */
+
+#include "dwmipcpp/state_mirror.hpp"
+
+#include <algorithm>
+
+namespace dwmipc {
+StateMirror::StateMirror(Connection &connection) : connection(connection) {
+    // Subscribe to every event, since each one updates part of the state.
+    // This is done before fetching the state so that no change made in
+    // between is missed; events already reflected by the snapshot are
+    // harmless to apply again.
+    const uint8_t last = static_cast<uint8_t>(Event::FOCUSED_STATE_CHANGE);
+    connection.subscribe_many((last << 1) - 1);
+
+    refresh();
+
+    tokens.push_back(connection.handlers.add<TagChangeEvent>(
+        [this](const TagChangeEvent &ev) {
+            sync();
+            apply(ev);
+        }));
+    tokens.push_back(connection.handlers.add<ClientFocusChangeEvent>(
+        [this](const ClientFocusChangeEvent &ev) {
+            sync();
+            apply(ev);
+        }));
+    tokens.push_back(connection.handlers.add<LayoutChangeEvent>(
+        [this](const LayoutChangeEvent &ev) {
+            sync();
+            apply(ev);
+        }));
+    tokens.push_back(connection.handlers.add<MonitorFocusChangeEvent>(
+        [this](const MonitorFocusChangeEvent &ev) {
+            sync();
+            apply(ev);
+        }));
+    tokens.push_back(connection.handlers.add<FocusedTitleChangeEvent>(
+        [this](const FocusedTitleChangeEvent &ev) {
+            sync();
+            apply(ev);
+        }));
+    tokens.push_back(connection.handlers.add<FocusedStateChangeEvent>(
+        [this](const FocusedStateChangeEvent &ev) {
+            sync();
+            apply(ev);
+        }));
+
+    // on_reconnected may be called on another thread, such as the event
+    // thread, so only note that the state must be fetched again
+    this->chained_reconnected = connection.on_reconnected;
+    connection.on_reconnected = [this]() {
+        this->resync = true;
+        if (this->chained_reconnected)
+            this->chained_reconnected();
+    };
+}
+
+StateMirror::~StateMirror() {
+    connection.on_reconnected = this->chained_reconnected;
+    for (auto &token : tokens)
+        connection.handlers.remove(token);
+}
+
+void StateMirror::sync() {
+    if (this->resync)
+        refresh();
+}
+
+void StateMirror::refresh() {
+    // Cleared first so that a reconnect during the fetch is not forgotten
+    this->resync = false;
+    const StateSnapshot state = connection.get_state();
+    this->round_trips++;
+
+    replace_monitors(*state.monitors);
+    this->tags = std::move(*state.tags);
+    this->layouts = std::move(*state.layouts);
+    this->focused = FocusedClient();
+    this->clients_stale = false;
+}
+
+const std::vector<Monitor> &StateMirror::get_monitors() {
+    sync();
+    if (!this->clients_stale)
+        return this->monitors;
+
+    // Everything except the client lists is already current, but replacing
+    // the whole monitor is simpler and just as correct
+    const auto fresh = connection.get_monitors();
+    this->round_trips++;
+    replace_monitors(*fresh);
+    this->clients_stale = false;
+    return this->monitors;
+}
+
+void StateMirror::replace_monitors(std::vector<Monitor> &fresh) {
+    // Nothing to compare against on the initial fetch
+    if (this->monitors.empty()) {
+        this->monitors.swap(fresh);
+        return;
+    }
+
+    diff_monitors(this->monitors, fresh, this->diff);
+    this->monitors.swap(fresh);
+
+    if (this->diff.empty())
+        return;
+
+    if (on_monitors_changed)
+        on_monitors_changed(this->diff);
+    if (on_window_added)
+        for (const Window win_id : this->diff.added_windows)
+            on_window_added(win_id);
+    if (on_window_removed)
+        for (const Window win_id : this->diff.removed_windows)
+            on_window_removed(win_id);
+}
+
+Monitor *StateMirror::find_monitor(const unsigned int num) {
+    // Monitors are normally listed in index order
+    if (num < monitors.size() && monitors[num].num == num)
+        return &monitors[num];
+
+    for (auto &mon : monitors)
+        if (mon.num == num)
+            return &mon;
+    return nullptr;
+}
+
+const Monitor *StateMirror::get_monitor(const unsigned int num) const {
+    return const_cast<StateMirror *>(this)->find_monitor(num);
+}
+
+const Monitor *StateMirror::get_selected_monitor() const {
+    for (const auto &mon : monitors)
+        if (mon.is_selected)
+            return &mon;
+    return nullptr;
+}
+
+Window StateMirror::get_focused_window() const {
+    const Monitor *mon = get_selected_monitor();
+    return mon ? mon->clients.selected : 0;
+}
+
+void StateMirror::fetch_focused() {
+    const Window win_id = get_focused_window();
+    const auto client = connection.get_client(win_id);
+    this->round_trips++;
+
+    this->focused.window_id = win_id;
+    this->focused.has_name = true;
+    this->focused.name = client->name;
+    this->focused.has_state = true;
+    this->focused.state.is_fixed = client->states.is_fixed;
+    this->focused.state.is_floating = client->states.is_floating;
+    this->focused.state.is_urgent = client->states.is_urgent;
+    this->focused.state.never_focus = client->states.never_focus;
+    this->focused.state.old_state = client->states.old_state;
+    this->focused.state.is_fullscreen = client->states.is_fullscreen;
+}
+
+const std::string &StateMirror::get_focused_title() {
+    static const std::string empty;
+
+    sync();
+    const Window win_id = get_focused_window();
+    if (win_id == 0)
+        return empty;
+
+    if (focused.window_id != win_id || !focused.has_name)
+        fetch_focused();
+    return this->focused.name;
+}
+
+ClientState StateMirror::get_focused_state() {
+    sync();
+    const Window win_id = get_focused_window();
+    if (win_id == 0)
+        return ClientState();
+
+    if (focused.window_id != win_id || !focused.has_state)
+        fetch_focused();
+    return this->focused.state;
+}
+
+void StateMirror::apply(const TagChangeEvent &ev) {
+    Monitor *mon = find_monitor(ev.monitor_num);
+    if (!mon) {
+        this->clients_stale = true;
+        return;
+    }
+
+    // A change in occupied tags means a window was created, destroyed, or
+    // moved between tags
+    if (mon->tag_state.occupied != ev.new_state.occupied)
+        this->clients_stale = true;
+
+    if (mon->tagset.cur != ev.new_state.selected) {
+        mon->tagset.old = mon->tagset.cur;
+        mon->tagset.cur = ev.new_state.selected;
+    }
+    mon->tag_state = ev.new_state;
+}
+
+void StateMirror::apply(const ClientFocusChangeEvent &ev) {
+    Monitor *mon = find_monitor(ev.monitor_num);
+    if (!mon) {
+        this->clients_stale = true;
+        return;
+    }
+
+    // Focusing a window we have not seen means it was just created or moved
+    // to this monitor
+    const auto &all = mon->clients.all;
+    if (ev.new_win_id != 0 &&
+        std::find(all.begin(), all.end(), ev.new_win_id) == all.end())
+        this->clients_stale = true;
+
+    mon->clients.selected = ev.new_win_id;
+}
+
+void StateMirror::apply(const LayoutChangeEvent &ev) {
+    Monitor *mon = find_monitor(ev.monitor_num);
+    if (!mon) {
+        this->clients_stale = true;
+        return;
+    }
+
+    mon->layout.symbol.old = ev.old_symbol;
+    mon->layout.symbol.cur = ev.new_symbol;
+    mon->layout.address.old = ev.old_address;
+    mon->layout.address.cur = ev.new_address;
+}
+
+void StateMirror::apply(const MonitorFocusChangeEvent &ev) {
+    for (auto &mon : monitors)
+        mon.is_selected = mon.num == ev.new_mon_num;
+}
+
+void StateMirror::apply(const FocusedTitleChangeEvent &ev) {
+    if (focused.window_id != ev.client_window_id) {
+        this->focused = FocusedClient();
+        this->focused.window_id = ev.client_window_id;
+    }
+    this->focused.has_name = true;
+    this->focused.name = ev.new_name;
+}
+
+void StateMirror::apply(const FocusedStateChangeEvent &ev) {
+    if (focused.window_id != ev.client_window_id) {
+        this->focused = FocusedClient();
+        this->focused.window_id = ev.client_window_id;
+    }
+    this->focused.has_state = true;
+    this->focused.state = ev.new_state;
+}
+
+} // namespace dwmipc
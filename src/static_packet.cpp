@@ -0,0 +1,95 @@
+/**
+ * @file static_packet.cpp
+ *
+ * This file contains the packets generated at compile time for requests that
+ * never change.
+ */
+
+#include "dwmipcpp/static_packet.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace dwmipc {
+/**
+ * Build the packet for subscribing or unsubscribing to an event. The payload
+ * is assembled by string literal concatenation.
+ */
+#define SUBSCRIBE_PACKET(event, action)                                        \
+    make_static_packet(MessageType::SUBSCRIBE,                                 \
+                       "{\"event\":\"" event "\",\"action\":\"" action "\"}")
+
+static constexpr auto GET_MONITORS_PACKET =
+    make_static_packet(MessageType::GET_MONITORS, "");
+static constexpr auto GET_TAGS_PACKET =
+    make_static_packet(MessageType::GET_TAGS, "");
+static constexpr auto GET_LAYOUTS_PACKET =
+    make_static_packet(MessageType::GET_LAYOUTS, "");
+
+static constexpr auto TAG_CHANGE_SUB =
+    SUBSCRIBE_PACKET("tag_change_event", "subscribe");
+static constexpr auto TAG_CHANGE_UNSUB =
+    SUBSCRIBE_PACKET("tag_change_event", "unsubscribe");
+static constexpr auto CLIENT_FOCUS_CHANGE_SUB =
+    SUBSCRIBE_PACKET("client_focus_change_event", "subscribe");
+static constexpr auto CLIENT_FOCUS_CHANGE_UNSUB =
+    SUBSCRIBE_PACKET("client_focus_change_event", "unsubscribe");
+static constexpr auto LAYOUT_CHANGE_SUB =
+    SUBSCRIBE_PACKET("layout_change_event", "subscribe");
+static constexpr auto LAYOUT_CHANGE_UNSUB =
+    SUBSCRIBE_PACKET("layout_change_event", "unsubscribe");
+static constexpr auto MONITOR_FOCUS_CHANGE_SUB =
+    SUBSCRIBE_PACKET("monitor_focus_change_event", "subscribe");
+static constexpr auto MONITOR_FOCUS_CHANGE_UNSUB =
+    SUBSCRIBE_PACKET("monitor_focus_change_event", "unsubscribe");
+static constexpr auto FOCUSED_TITLE_CHANGE_SUB =
+    SUBSCRIBE_PACKET("focused_title_change_event", "subscribe");
+static constexpr auto FOCUSED_TITLE_CHANGE_UNSUB =
+    SUBSCRIBE_PACKET("focused_title_change_event", "unsubscribe");
+static constexpr auto FOCUSED_STATE_CHANGE_SUB =
+    SUBSCRIBE_PACKET("focused_state_change_event", "subscribe");
+static constexpr auto FOCUSED_STATE_CHANGE_UNSUB =
+    SUBSCRIBE_PACKET("focused_state_change_event", "unsubscribe");
+
+#undef SUBSCRIBE_PACKET
+
+PacketView static_request(const MessageType type) {
+    switch (type) {
+    case MessageType::GET_TAGS:
+        return GET_TAGS_PACKET.view();
+    case MessageType::GET_LAYOUTS:
+        return GET_LAYOUTS_PACKET.view();
+    case MessageType::GET_MONITORS:
+        return GET_MONITORS_PACKET.view();
+    default:
+        throw std::invalid_argument(
+            "No static request for message type " +
+            std::to_string(static_cast<unsigned int>(type)));
+    }
+}
+
+PacketView static_subscribe(const Event ev, const bool sub) {
+    switch (ev) {
+    case Event::TAG_CHANGE:
+        return sub ? TAG_CHANGE_SUB.view() : TAG_CHANGE_UNSUB.view();
+    case Event::CLIENT_FOCUS_CHANGE:
+        return sub ? CLIENT_FOCUS_CHANGE_SUB.view()
+                   : CLIENT_FOCUS_CHANGE_UNSUB.view();
+    case Event::LAYOUT_CHANGE:
+        return sub ? LAYOUT_CHANGE_SUB.view() : LAYOUT_CHANGE_UNSUB.view();
+    case Event::MONITOR_FOCUS_CHANGE:
+        return sub ? MONITOR_FOCUS_CHANGE_SUB.view()
+                   : MONITOR_FOCUS_CHANGE_UNSUB.view();
+    case Event::FOCUSED_TITLE_CHANGE:
+        return sub ? FOCUSED_TITLE_CHANGE_SUB.view()
+                   : FOCUSED_TITLE_CHANGE_UNSUB.view();
+    case Event::FOCUSED_STATE_CHANGE:
+        return sub ? FOCUSED_STATE_CHANGE_SUB.view()
+                   : FOCUSED_STATE_CHANGE_UNSUB.view();
+    default:
+        throw std::invalid_argument(
+            "Unknown event " + std::to_string(static_cast<unsigned int>(ev)));
+    }
+}
+
+} // namespace dwmipc
@@ -0,0 +1,212 @@
+/**
+ * @file traffic_log.cpp
+ *
+ * This file contains the implementation details for the TrafficRecorder class
+ * and for reading traffic logs.
+ */
+
+#include "dwmipcpp/traffic_log.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "dwmipcpp/errors.hpp"
+
+namespace dwmipc {
+/**
+ * Every traffic log starts with this magic string, followed by the version
+ */
+static const char LOG_MAGIC[] = {'D', 'W', 'M', '-', 'I', 'P', 'C', '-',
+                                 'L', 'O', 'G'};
+static const uint8_t LOG_VERSION = 1;
+
+/**
+ * Bits of the byte following the time of a record
+ */
+static const uint8_t FLAG_EVENT_SOCKET = 1 << 0;
+static const uint8_t FLAG_RECEIVED = 1 << 1;
+
+/**
+ * Append an unsigned LEB128 encoded integer
+ */
+static void put_varint(std::vector<char> &buf, uint64_t value) {
+    while (value >= 0x80) {
+        buf.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buf.push_back(static_cast<char>(value));
+}
+
+/**
+ * Read an unsigned LEB128 encoded integer, advancing walk past it
+ *
+ * @return false if the integer is truncated or too long
+ */
+static bool get_varint(const char *&walk, const char *end, uint64_t &value) {
+    value = 0;
+    for (unsigned int shift = 0; walk < end && shift < 64; shift += 7) {
+        const uint8_t byte = static_cast<uint8_t>(*walk++);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+TrafficRecorder::TrafficRecorder(const std::string &path)
+    : start(Clock::now()) {
+    this->fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644);
+    if (this->fd < 0)
+        throw ErrnoError("Failed to create traffic log " + path);
+
+    buf.reserve(FLUSH_SIZE + 4096);
+    buf.insert(buf.end(), LOG_MAGIC, LOG_MAGIC + sizeof(LOG_MAGIC));
+    buf.push_back(static_cast<char>(LOG_VERSION));
+}
+
+TrafficRecorder::~TrafficRecorder() {
+    try {
+        write_buffer();
+    } catch (const ErrnoError &) {
+    }
+    close(this->fd);
+}
+
+void TrafficRecorder::record(const Clock::time_point time,
+                             const SocketRole role, const Direction direction,
+                             const uint8_t type, const char *payload,
+                             const uint32_t size) {
+    // A read may have completed just before the recording started
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     time - this->start)
+                     .count();
+    if (ns < 0)
+        ns = 0;
+
+    uint8_t flags = 0;
+    if (role == SocketRole::EVENT)
+        flags |= FLAG_EVENT_SOCKET;
+    if (direction == Direction::RECEIVED)
+        flags |= FLAG_RECEIVED;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Zigzag encode the difference, which may be negative
+    const int64_t delta = ns - static_cast<int64_t>(this->last_ns);
+    this->last_ns = ns;
+    put_varint(buf, (static_cast<uint64_t>(delta) << 1) ^
+                        static_cast<uint64_t>(delta >> 63));
+
+    buf.push_back(static_cast<char>(flags));
+    buf.push_back(static_cast<char>(type));
+    put_varint(buf, size);
+    buf.insert(buf.end(), payload, payload + size);
+    this->records++;
+
+    if (buf.size() >= FLUSH_SIZE)
+        write_buffer();
+}
+
+void TrafficRecorder::record_sent(const SocketRole role,
+                                  const PacketView &packet) {
+    record(Clock::now(), role, Direction::SENT, packet.type,
+           reinterpret_cast<const char *>(packet.data) + Packet::HEADER_SIZE,
+           packet.size - Packet::HEADER_SIZE);
+}
+
+void TrafficRecorder::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    write_buffer();
+}
+
+size_t TrafficRecorder::get_records() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return this->records;
+}
+
+void TrafficRecorder::write_buffer() {
+    size_t written = 0;
+    while (written < buf.size()) {
+        const ssize_t n =
+            write(this->fd, buf.data() + written, buf.size() - written);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            // Drop the records rather than retrying them forever
+            const ErrnoError err("Failed to write traffic log");
+            buf.clear();
+            throw err;
+        }
+        written += n;
+    }
+    buf.clear();
+}
+
+std::vector<TrafficRecord> read_traffic_log(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw ErrnoError("Failed to open traffic log " + path);
+
+    std::vector<char> data;
+    size_t size = 0;
+    while (true) {
+        if (data.size() - size < 64 * 1024)
+            data.resize(size + 256 * 1024);
+
+        const ssize_t n = read(fd, data.data() + size, data.size() - size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            const ErrnoError err("Failed to read traffic log " + path);
+            close(fd);
+            throw err;
+        }
+        if (n == 0)
+            break;
+        size += n;
+    }
+    close(fd);
+
+    const char *walk = data.data();
+    const char *end = walk + size;
+
+    if (size < sizeof(LOG_MAGIC) + 1 ||
+        std::memcmp(walk, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0)
+        throw TrafficLogError(path + " is not a traffic log");
+    walk += sizeof(LOG_MAGIC);
+    if (static_cast<uint8_t>(*walk++) != LOG_VERSION)
+        throw TrafficLogError("Unsupported traffic log version in " + path);
+
+    std::vector<TrafficRecord> records;
+    uint64_t time_ns = 0;
+    while (walk < end) {
+        uint64_t zigzag, payload_size;
+        if (!get_varint(walk, end, zigzag) || end - walk < 2)
+            throw TrafficLogError("Truncated traffic log " + path);
+
+        const uint8_t flags = static_cast<uint8_t>(*walk++);
+        const uint8_t type = static_cast<uint8_t>(*walk++);
+        if (!get_varint(walk, end, payload_size) ||
+            static_cast<uint64_t>(end - walk) < payload_size)
+            throw TrafficLogError("Truncated traffic log " + path);
+
+        time_ns += (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+
+        TrafficRecord record;
+        record.time_ns = time_ns;
+        record.role = flags & FLAG_EVENT_SOCKET ? SocketRole::EVENT
+                                                : SocketRole::MAIN;
+        record.direction =
+            flags & FLAG_RECEIVED ? Direction::RECEIVED : Direction::SENT;
+        record.type = type;
+        record.payload.assign(walk, payload_size);
+        walk += payload_size;
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+} // namespace dwmipc
@@ -0,0 +1,100 @@
+/**
+ * @file traffic_replayer.cpp
+ *
+ * This file contains the implementation details for the TrafficReplayer
+ * class.
+ */
+
+#include "dwmipcpp/traffic_replayer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "dwmipcpp/errors.hpp"
+
+namespace dwmipc {
+constexpr double TrafficReplayer::AS_FAST_AS_POSSIBLE;
+
+TrafficReplayer::TrafficReplayer(std::vector<TrafficRecord> records)
+    : records(std::move(records)) {}
+
+TrafficReplayer::TrafficReplayer(const std::string &path)
+    : records(read_traffic_log(path)) {}
+
+ReplayStats TrafficReplayer::replay(Connection &conn,
+                                    const double speed) const {
+    typedef std::chrono::steady_clock Clock;
+
+    ReplayStats stats = {};
+    const auto start = Clock::now();
+
+    // Time is counted from the first received message, since the recording
+    // may have started well before it
+    bool first = true;
+    uint64_t base_ns = 0;
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const TrafficRecord &record = records[i];
+        if (record.direction != Direction::RECEIVED)
+            continue;
+
+        if (first) {
+            base_ns = record.time_ns;
+            first = false;
+        }
+
+        if (speed > 0) {
+            // Records from different threads may be slightly out of order, so
+            // one may be earlier than the first
+            const uint64_t offset_ns =
+                record.time_ns > base_ns ? record.time_ns - base_ns : 0;
+            const auto due =
+                start + std::chrono::duration_cast<Clock::duration>(
+                            std::chrono::duration<double, std::nano>(
+                                offset_ns / speed));
+            const auto now = Clock::now();
+            if (now < due)
+                std::this_thread::sleep_until(due);
+            else
+                stats.max_lag_ms = std::max(
+                    stats.max_lag_ms,
+                    std::chrono::duration<double, std::milli>(now - due)
+                        .count());
+        }
+
+        try {
+            conn.replay_message(record.type, record.payload.data(),
+                                record.payload.size(), ends_batch(i));
+        } catch (const ResultFailureError &) {
+            // A failed request is replayed as faithfully as a successful one
+            stats.failures++;
+        }
+
+        if (record.type == static_cast<uint8_t>(MessageType::EVENT))
+            stats.events++;
+        else
+            stats.replies++;
+    }
+
+    stats.elapsed_ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count();
+    return stats;
+}
+
+bool TrafficReplayer::ends_batch(const size_t i) const {
+    const TrafficRecord &record = records[i];
+
+    for (size_t j = i + 1; j < records.size(); j++) {
+        const TrafficRecord &next = records[j];
+        if (next.direction != Direction::RECEIVED || next.role != record.role)
+            continue;
+
+        // Messages received in one read were recorded with the same time
+        return next.time_ns != record.time_ns;
+    }
+    return true;
+}
+
+} // namespace dwmipc
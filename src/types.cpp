@@ -2,11 +2,13 @@
  * @file types.cpp
  *
  * This file implements the global event_map which maps the Event enum values
- * to their event names.
+ * to their event names, and the reverse lookup.
  */
 
 #include "dwmipcpp/types.hpp"
 
+#include <cstring>
+
 namespace dwmipc {
 const std::unordered_map<Event, std::string> event_map = {
     {Event::TAG_CHANGE, "tag_change_event"},
@@ -15,4 +17,51 @@ const std::unordered_map<Event, std::string> event_map = {
     {Event::MONITOR_FOCUS_CHANGE, "monitor_focus_change_event"},
     {Event::FOCUSED_TITLE_CHANGE, "focused_title_change_event"},
     {Event::FOCUSED_STATE_CHANGE, "focused_state_change_event"}};
+
+/**
+ * Event names indexed by the position of the event's bit
+ */
+static const struct {
+    const char *name;
+    size_t len;
+} event_names[] = {
+    {"tag_change_event", 16},
+    {"client_focus_change_event", 25},
+    {"layout_change_event", 19},
+    {"monitor_focus_change_event", 26},
+    {"focused_title_change_event", 26},
+    {"focused_state_change_event", 26}};
+
+bool event_from_name(const char *name, const size_t len, Event &ev) {
+    // The first letter tells the events apart, except for the two focused_*
+    // events which differ at the start of their second word
+    size_t i;
+    switch (len > 8 ? name[0] : '\0') {
+    case 't':
+        i = 0;
+        break;
+    case 'c':
+        i = 1;
+        break;
+    case 'l':
+        i = 2;
+        break;
+    case 'm':
+        i = 3;
+        break;
+    case 'f':
+        i = name[8] == 't' ? 4 : 5;
+        break;
+    default:
+        return false;
+    }
+
+    // Confirm the guess with a single comparison
+    if (len != event_names[i].len ||
+        std::memcmp(name, event_names[i].name, len) != 0)
+        return false;
+
+    ev = static_cast<Event>(1 << i);
+    return true;
+}
 } // namespace dwmipc
@@ -7,6 +7,8 @@
 
 #include "dwmipcpp/util.hpp"
 
+#include <algorithm>
+#include <climits>
 #include <cstring>
 
 #include "dwmipcpp/errors.hpp"
@@ -32,6 +34,7 @@ int connect(const std::string &socket_path, bool is_blocking) {
 
     if (::connect(sockfd, reinterpret_cast<struct sockaddr *>(&addr),
                   sizeof(struct sockaddr_un)) < 0) {
+        close(sockfd);
         throw IPCError("Failed to connect to dwm ipc socket");
     }
 
@@ -47,7 +50,8 @@ ssize_t swrite(const int fd, const void *buf, const uint32_t count) {
     size_t written = 0;
 
     while (written < count) {
-        const ssize_t n = send(fd, buf, count, MSG_NOSIGNAL);
+        const ssize_t n = send(fd, static_cast<const char *>(buf) + written,
+                               count - written, MSG_NOSIGNAL);
 
         if (n == -1) {
             // This may block, but shouldn't for long
@@ -63,6 +67,42 @@ ssize_t swrite(const int fd, const void *buf, const uint32_t count) {
     return written;
 }
 
+ssize_t swritev(const int fd, struct iovec *iov, size_t iovcnt) {
+    size_t written = 0;
+
+    while (iovcnt > 0) {
+        struct msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = std::min(iovcnt, static_cast<size_t>(IOV_MAX));
+
+        const ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+
+        if (n == -1) {
+            // This may block, but shouldn't for long
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+                continue;
+            else if (errno == EPIPE)
+                throw SocketClosedError(fd);
+
+            throw ErrnoError("Error writing buffers to dwm socket");
+        }
+        written += n;
+
+        // Skip fully written buffers and advance into a partial one
+        size_t remaining = n;
+        while (iovcnt > 0 && remaining >= iov->iov_len) {
+            remaining -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
+        }
+    }
+    return written;
+}
+
 std::shared_ptr<Packet> recv_message(int sockfd, bool wait) {
     uint32_t read_bytes = 0;
     size_t to_read = Packet::HEADER_SIZE;
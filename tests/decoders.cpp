@@ -0,0 +1,96 @@
+/**
+ * @file decoders.cpp
+ *
+ * Check that the streaming decoders produce the same monitors and clients as
+ * the jsoncpp decoder, and that reused output objects are fully overwritten.
+ */
+
+#include <cstring>
+
+#include "dwmipcpp/decoder.hpp"
+#include "dwmipcpp/diff.hpp"
+#include "mock_server.hpp"
+#include "test.hpp"
+
+using namespace dwmipc;
+
+static void check_monitors(Connection &streaming, Connection &jsoncpp,
+                           const MockModel &model) {
+    const auto a = streaming.get_monitors();
+    const auto b = jsoncpp.get_monitors();
+    CHECK(a->size() == model.monitors.size());
+    CHECK(b->size() == model.monitors.size());
+    if (a->size() != b->size())
+        return;
+
+    MonitorDiff diff;
+    for (size_t i = 0; i < a->size(); i++) {
+        CHECK((*a)[i].num == (*b)[i].num);
+        CHECK(!diff_monitor((*a)[i], (*b)[i], diff));
+        CHECK(!diff_monitor((*a)[i], model.monitors[i], diff));
+    }
+}
+
+static void check_clients(Connection &streaming, Connection &jsoncpp,
+                          const MockModel &model) {
+    for (const Client &expected : model.clients) {
+        const auto a = streaming.get_client(expected.window_id);
+        const auto b = jsoncpp.get_client(expected.window_id);
+        CHECK(a->window_id == expected.window_id);
+        CHECK(b->window_id == expected.window_id);
+        CHECK(diff_client(*a, *b) == 0);
+        CHECK(diff_client(*a, expected) == 0);
+    }
+
+    CHECK_THROWS(streaming.get_client(12345), ResultFailureError);
+    CHECK_THROWS(jsoncpp.get_client(12345), ResultFailureError);
+}
+
+static bool decode(const char *payload, Client &client) {
+    return decode_client(payload, std::strlen(payload) + 1, client);
+}
+
+static void check_client_reuse() {
+    const char *full =
+        "{\"name\":\"a\",\"tags\":3,\"window_id\":7,\"monitor_number\":1,"
+        "\"size_hints\":{\"aspect_ratio\":{\"min\":1.5,\"max\":2}},"
+        "\"states\":{\"is_floating\":true,\"is_urgent\":true}}";
+    const char *bare = "{\"name\":\"b\",\"window_id\":8}";
+
+    Client client;
+    CHECK(decode(full, client));
+    CHECK(client.tags == 3);
+    CHECK(client.size_hints.aspect_ratio.min == 1.5f);
+    CHECK(client.states.is_floating);
+
+    // Nothing of the first client may survive in the reused object
+    CHECK(decode(bare, client));
+    CHECK(client.name == "b");
+    CHECK(client.window_id == 8);
+    CHECK(client.tags == 0);
+    CHECK(client.monitor_num == 0);
+    CHECK(client.size_hints.aspect_ratio.min == 0);
+    CHECK(client.size_hints.aspect_ratio.max == 0);
+    CHECK(!client.states.is_floating);
+    CHECK(!client.states.is_urgent);
+
+    // Error replies are left to the jsoncpp decoder
+    const char *error = "{\"result\":\"error\",\"reason\":\"x\"}";
+    CHECK(!decode(error, client));
+}
+
+int main() {
+    return test::run("decoders", []() {
+        const MockModel model = MockModel::synthetic(3, 9, 5);
+        MockServer server(test::socket_path("decoders"), model);
+
+        Connection streaming(server.socket_path);
+        Connection jsoncpp(server.socket_path);
+        streaming.set_decoder(Decoder::STREAMING);
+        jsoncpp.set_decoder(Decoder::JSONCPP);
+
+        check_monitors(streaming, jsoncpp, model);
+        check_clients(streaming, jsoncpp, model);
+        check_client_reuse();
+    });
+}
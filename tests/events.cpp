@@ -0,0 +1,120 @@
+/**
+ * @file events.cpp
+ *
+ * Check subscribing to events and receiving them from the mock server, both
+ * inline and on the background event thread.
+ */
+
+#include <stdexcept>
+
+#include "mock_server.hpp"
+#include "test.hpp"
+
+using namespace dwmipc;
+
+static const uint8_t TAG_AND_LAYOUT =
+    static_cast<uint8_t>(Event::TAG_CHANGE) |
+    static_cast<uint8_t>(Event::LAYOUT_CHANGE);
+
+static void check_subscribe(MockServer &server, Connection &conn) {
+    conn.subscribe_many(TAG_AND_LAYOUT);
+    CHECK(conn.get_subscriptions() == TAG_AND_LAYOUT);
+    CHECK(server.wait_subscribers(Event::TAG_CHANGE, 1));
+    CHECK(server.wait_subscribers(Event::LAYOUT_CHANGE, 1));
+    CHECK(server.wait_subscribers(Event::FOCUSED_TITLE_CHANGE, 0));
+
+    // Bits that are not events are rejected before anything is sent
+    CHECK_THROWS(conn.subscribe_many(0xc0), std::invalid_argument);
+    CHECK(conn.get_subscriptions() == TAG_AND_LAYOUT);
+}
+
+static void check_events(MockServer &server, Connection &conn) {
+    size_t tags = 0, layouts = 0;
+    conn.on_tag_change = [&](const TagChangeEvent &ev) {
+        if (ev.new_state.selected == 4)
+            tags++;
+    };
+    conn.on_layout_change = [&](const LayoutChangeEvent &) { layouts++; };
+
+    // Commands run by another connection raise events for this one
+    Connection commands(server.socket_path, false);
+    commands.connect_main_socket();
+    commands.run_command("view", 1);
+    commands.run_command("view", 4);
+    commands.run_command("setlayoutsafe",
+                         server.get_model().layouts[1].address);
+
+    CHECK(test::handle_until(conn,
+                             [&]() { return tags == 1 && layouts == 1; }));
+
+    // Events that are not subscribed to are not sent
+    server.emit("{\"focused_title_change_event\":{\"monitor_number\":0,"
+                "\"client_window_id\":1,\"old_name\":\"a\","
+                "\"new_name\":\"b\"}}");
+    commands.run_command("view", 1);
+    commands.run_command("view", 4);
+    CHECK(test::handle_until(conn, [&]() { return tags == 2; }));
+    CHECK(layouts == 1);
+
+    conn.on_tag_change = nullptr;
+    conn.on_layout_change = nullptr;
+}
+
+static void check_filter(MockServer &server, Connection &conn) {
+    size_t tags = 0, layouts = 0;
+    conn.on_tag_change = [&](const TagChangeEvent &) { tags++; };
+    conn.on_layout_change = [&](const LayoutChangeEvent &) { layouts++; };
+
+    Connection commands(server.socket_path, false);
+    commands.connect_main_socket();
+    commands.run_command("view", 2);
+
+    // Events queued before the filter changed are still filtered by it. The
+    // layout event follows the tag event, so both have been handled once it
+    // is dispatched.
+    EventFilter filter;
+    filter.events = static_cast<uint8_t>(Event::LAYOUT_CHANGE);
+    conn.set_event_filter(filter);
+    commands.run_command("setlayoutsafe",
+                         server.get_model().layouts[0].address);
+    CHECK(test::handle_until(conn, [&]() { return layouts == 1; }));
+    CHECK(tags == 0);
+
+    conn.set_event_filter(EventFilter());
+    commands.run_command("view", 4);
+    CHECK(test::handle_until(conn, [&]() { return tags == 1; }));
+
+    conn.on_tag_change = nullptr;
+    conn.on_layout_change = nullptr;
+}
+
+static void check_unsubscribe(MockServer &server, Connection &conn) {
+    conn.unsubscribe(Event::TAG_CHANGE);
+    CHECK(conn.get_subscriptions() ==
+          static_cast<uint8_t>(Event::LAYOUT_CHANGE));
+    CHECK(server.wait_subscribers(Event::TAG_CHANGE, 0));
+}
+
+int main() {
+    return test::run("events", []() {
+        MockServer server(test::socket_path("events"));
+
+        {
+            Connection conn(server.socket_path);
+            check_subscribe(server, conn);
+            check_events(server, conn);
+            check_filter(server, conn);
+            check_unsubscribe(server, conn);
+        }
+        CHECK(server.wait_subscribers(Event::LAYOUT_CHANGE, 0));
+
+        {
+            Connection conn(server.socket_path);
+            conn.start_event_thread();
+            check_subscribe(server, conn);
+            check_events(server, conn);
+            check_filter(server, conn);
+            check_unsubscribe(server, conn);
+        }
+    });
+}
@@ -0,0 +1,114 @@
+/**
+ * @file reconnect.cpp
+ *
+ * Check that lost sockets are reconnected and subscriptions replayed when
+ * the mock server is restarted, by a Connection on its own and by an
+ * EventLoop without blocking it.
+ */
+
+#include <chrono>
+#include <memory>
+
+#include "dwmipcpp/event_loop.hpp"
+#include "mock_server.hpp"
+#include "test.hpp"
+
+using namespace dwmipc;
+
+static const char TAG_EVENT[] =
+    "{\"tag_change_event\":{\"monitor_number\":0,\"old_state\":{"
+    "\"selected\":1,\"occupied\":1,\"urgent\":0},\"new_state\":{"
+    "\"selected\":2,\"occupied\":1,\"urgent\":0}}}";
+
+static void check_connection(const std::string &path) {
+    std::unique_ptr<MockServer> server(new MockServer(path));
+    Connection conn(path);
+    conn.subscribe(Event::TAG_CHANGE);
+
+    size_t reconnected = 0, tags = 0;
+    conn.on_reconnected = [&]() { reconnected++; };
+    conn.on_tag_change = [&](const TagChangeEvent &) { tags++; };
+
+    server.reset();
+    server.reset(new MockServer(path));
+
+    // The request is retried on the reconnected main socket
+    CHECK(!conn.get_monitors()->empty());
+    CHECK(reconnected == 1);
+
+    // The lost event socket is noticed and reconnected by handle_events,
+    // and the subscription is replayed
+    CHECK(test::handle_until(conn, [&]() { return reconnected == 2; }));
+    CHECK(server->wait_subscribers(Event::TAG_CHANGE, 1));
+    server->emit(TAG_EVENT);
+    CHECK(test::handle_until(conn, [&]() { return tags == 1; }));
+
+    // Without reconnecting, the loss is reported
+    ReconnectPolicy policy;
+    policy.enabled = false;
+    conn.set_reconnect_policy(policy);
+    server.reset();
+    server.reset(new MockServer(path));
+    CHECK_THROWS(conn.get_monitors(), SocketClosedError);
+}
+
+static void check_event_loop(const std::string &path) {
+    std::unique_ptr<MockServer> server(new MockServer(path));
+    Connection conn(path);
+    conn.subscribe(Event::TAG_CHANGE);
+
+    size_t reconnected = 0, tags = 0, ticks = 0;
+    conn.on_reconnected = [&]() { reconnected++; };
+    conn.on_tag_change = [&](const TagChangeEvent &) { tags++; };
+
+    EventLoop loop(conn);
+    loop.reconnect_interval_ms = 20;
+    loop.add_timer(5, [&]() { ticks++; });
+
+    auto run_for = [&](const unsigned int ms) {
+        const auto until =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+        while (std::chrono::steady_clock::now() < until)
+            loop.run_once(10);
+    };
+
+    // A one-shot timer fires once, and its id is not reused by later timers
+    size_t once = 0, later = 0;
+    const EventLoop::TimerId once_id =
+        loop.add_timer(1, [&]() { once++; }, false);
+    run_for(50);
+    CHECK(once == 1);
+    const EventLoop::TimerId later_id = loop.add_timer(1, [&]() { later++; });
+    CHECK(later_id != once_id);
+    loop.remove_timer(once_id);
+    run_for(20);
+    CHECK(later > 0);
+    loop.remove_timer(later_id);
+
+    server.reset();
+
+    // The loop keeps running its timers while DWM is down
+    const size_t before = ticks;
+    run_for(200);
+    CHECK(ticks - before >= 10);
+    CHECK(reconnected == 0);
+
+    server.reset(new MockServer(path));
+    run_for(200);
+    CHECK(reconnected == 1);
+    CHECK(server->wait_subscribers(Event::TAG_CHANGE, 1));
+
+    server->emit(TAG_EVENT);
+    const auto until =
+        std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (tags == 0 && std::chrono::steady_clock::now() < until)
+        loop.run_once(10);
+    CHECK(tags == 1);
+}
+
+int main() {
+    return test::run("reconnect", []() {
+        check_connection(test::socket_path("reconnect"));
+        check_event_loop(test::socket_path("event-loop"));
+    });
+}
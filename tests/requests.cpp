@@ -0,0 +1,105 @@
+/**
+ * @file requests.cpp
+ *
+ * Check pipelined requests, commands and the thread-safe and asynchronous
+ * request paths against the mock server.
+ */
+
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "mock_server.hpp"
+#include "test.hpp"
+
+using namespace dwmipc;
+
+static void check_state(Connection &conn, const MockModel &model) {
+    const StateSnapshot state = conn.get_state();
+    CHECK(state.monitors->size() == model.monitors.size());
+    CHECK(state.tags->size() == model.tags.size());
+    CHECK(state.layouts->size() == model.layouts.size());
+}
+
+static void check_clients(Connection &conn, const MockModel &model) {
+    // More windows than are written to the socket at once
+    std::vector<Window> ids;
+    for (const Client &client : model.clients)
+        ids.push_back(client.window_id);
+    const Window missing = 12345;
+    ids.insert(ids.begin() + ids.size() / 2, missing);
+
+    const auto list = conn.get_clients(ids);
+    CHECK(list->clients.size() == model.clients.size());
+    CHECK(list->failures.size() == 1);
+    if (list->failures.size() == 1)
+        CHECK(list->failures[0].window_id == missing);
+
+    // Clients are returned in the order they were requested
+    for (size_t i = 0; i < list->clients.size(); i++)
+        CHECK(list->clients[i].window_id == model.clients[i].window_id);
+}
+
+static void check_commands(Connection &conn) {
+    conn.run_command("view", 4);
+
+    bool found = false;
+    for (const Monitor &mon : *conn.get_monitors()) {
+        if (!mon.is_selected)
+            continue;
+        found = true;
+        CHECK(mon.tagset.cur == 4);
+    }
+    CHECK(found);
+
+    CHECK_THROWS(conn.run_command("setlayoutsafe", 1), ResultFailureError);
+}
+
+static void check_async(Connection &conn, const MockModel &model) {
+    std::vector<std::future<std::shared_ptr<Client>>> replies;
+    for (const Client &client : model.clients)
+        replies.push_back(conn.get_client_async(client.window_id));
+    auto missing = conn.get_client_async(12345);
+
+    for (size_t i = 0; i < replies.size(); i++)
+        CHECK(replies[i].get()->window_id == model.clients[i].window_id);
+
+    // A failed request does not affect the others pipelined with it
+    CHECK_THROWS(missing.get(), ResultFailureError);
+}
+
+static void check_thread_safe(Connection &conn, const MockModel &model) {
+    conn.set_thread_safe(true);
+
+    std::vector<std::thread> threads;
+    std::vector<size_t> mismatches(4, 0);
+    for (size_t t = 0; t < mismatches.size(); t++)
+        threads.emplace_back([&, t]() {
+            for (size_t i = 0; i < 200; i++) {
+                const Client &expected =
+                    model.clients[(t + i) % model.clients.size()];
+                const auto client = conn.get_client(expected.window_id);
+                if (client->window_id != expected.window_id)
+                    mismatches[t]++;
+            }
+        });
+    for (auto &thread : threads)
+        thread.join();
+
+    for (const size_t count : mismatches)
+        CHECK(count == 0);
+}
+
+int main() {
+    return test::run("requests", []() {
+        const MockModel model = MockModel::synthetic(4, 9, 20);
+        MockServer server(test::socket_path("requests"), model);
+        Connection conn(server.socket_path);
+
+        check_state(conn, model);
+        check_clients(conn, model);
+        check_commands(conn);
+        check_async(conn, model);
+        check_thread_safe(conn, model);
+    });
+}
@@ -0,0 +1,108 @@
+/**
+ * @file test.hpp
+ *
+ * This file contains the helpers shared by the tests: checks that report
+ * failures without stopping the test, and waiting for events from a mock
+ * server.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <poll.h>
+#include <string>
+#include <unistd.h>
+
+#include "dwmipcpp/connection.hpp"
+#include "dwmipcpp/errors.hpp"
+
+/**
+ * Check a condition, reporting it if it does not hold
+ */
+#define CHECK(cond) test::check((cond), #cond, __FILE__, __LINE__)
+
+/**
+ * Check that an expression throws the specified exception type
+ */
+#define CHECK_THROWS(expr, type)                                               \
+    do {                                                                       \
+        bool thrown = false;                                                   \
+        try {                                                                  \
+            expr;                                                              \
+        } catch (const type &) {                                               \
+            thrown = true;                                                     \
+        }                                                                      \
+        test::check(thrown, #expr " throws " #type, __FILE__, __LINE__);       \
+    } while (false)
+
+namespace test {
+/**
+ * Get the number of failed checks so far
+ */
+inline int &failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void check(const bool ok, const char *what, const char *file,
+                  const int line) {
+    if (ok)
+        return;
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    failures()++;
+}
+
+/**
+ * Get a socket path for a mock server that no other test run uses
+ */
+inline std::string socket_path(const std::string &name) {
+    return "/tmp/dwmipcpp-test-" + name + "-" + std::to_string(getpid());
+}
+
+/**
+ * Handle events on a connection until a condition holds
+ *
+ * @return true if the condition held before the timeout
+ */
+inline bool handle_until(dwmipc::Connection &conn,
+                         const std::function<bool()> &done,
+                         const unsigned int timeout_ms = 2000) {
+    const auto until = std::chrono::steady_clock::now() +
+                       std::chrono::milliseconds(timeout_ms);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > until)
+            return false;
+
+        struct pollfd pfd = {conn.get_event_wait_fd(), POLLIN, 0};
+        poll(&pfd, 1, 10);
+        conn.handle_events();
+    }
+    return true;
+}
+
+/**
+ * Run a test body, counting an escaped exception as a failure, and report
+ * the result
+ *
+ * @return The exit status for the test
+ */
+inline int run(const char *name, const std::function<void()> &body) {
+    try {
+        body();
+    } catch (const std::exception &err) {
+        std::fprintf(stderr, "%s: unexpected exception: %s\n", name,
+                     err.what());
+        failures()++;
+    }
+
+    if (failures() == 0) {
+        std::printf("%s: passed\n", name);
+        return 0;
+    }
+    std::printf("%s: %d checks failed\n", name, failures());
+    return 1;
+}
+
+} // namespace test